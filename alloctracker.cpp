@@ -0,0 +1,194 @@
+#include "alloctracker.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <mutex>
+#include <new>
+
+namespace {
+
+  // plain data so that the thread-local storage never allocates itself
+  struct ThreadAllocs {
+    uint64_t    allocs;
+    uint64_t    bytes;
+    const char *forbidden; // innermost ALLOC_FREE_SCOPE phase, if any
+    bool        reporting; // avoid recursion while reporting
+  };
+
+  thread_local ThreadAllocs threadAllocs = {0,0,0,false};
+
+  // fixed table: updating the report never allocates
+  struct PhaseAllocs {
+    const char *phase;
+    uint64_t    calls;
+    uint64_t    last;
+    uint64_t    max;
+    uint64_t    total;
+    uint64_t    bytes;
+  };
+
+  const unsigned int maxPhases = 64;
+  PhaseAllocs        phases[maxPhases];
+  unsigned int       nbPhases = 0;
+  std::mutex         phasesMutex;
+
+  // 0: off, 1: report, 2: abort (read from SIM_ALLOC_ASSERT once)
+  int assertMode() {
+    static int mode = -1;
+
+    if(mode<0) {
+      const char *env = getenv("SIM_ALLOC_ASSERT");
+      mode = !env || !env[0] || !strcmp(env,"0") ? 0 : (!strcmp(env,"abort") ? 2 : 1);
+    }
+
+    return mode;
+  }
+
+#ifdef SIM_TRACK_ALLOCS
+  void count(size_t size) {
+    ThreadAllocs &t = threadAllocs;
+
+    t.allocs++;
+    t.bytes += size;
+
+    if(!t.forbidden || t.reporting || assertMode()==0)
+      return;
+
+    // snprintf/write on a stack buffer: no allocation while reporting
+    char message[256];
+    t.reporting = true;
+    const int n = snprintf(message,sizeof(message),"Allocation of %lu bytes inside %s\n",
+                           (unsigned long)size,t.forbidden);
+    if(write(2,message,n>0 ? n : 0)<0) {}
+    t.reporting = false;
+
+    if(assertMode()==2)
+      abort();
+  }
+#endif
+
+}
+
+#ifdef SIM_TRACK_ALLOCS
+
+// linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (see main.pro)
+extern "C" {
+  void *__real_malloc(size_t size);
+  void *__real_calloc(size_t n,size_t size);
+  void *__real_realloc(void *p,size_t size);
+
+  void *__wrap_malloc(size_t size) {
+    count(size);
+    return __real_malloc(size);
+  }
+
+  void *__wrap_calloc(size_t n,size_t size) {
+    count(n*size);
+    return __real_calloc(n,size);
+  }
+
+  void *__wrap_realloc(void *p,size_t size) {
+    count(size);
+    return __real_realloc(p,size);
+  }
+}
+
+// route the C++ allocations of every library through the wrapped malloc
+void *operator new(size_t size) {
+  void *p = malloc(size ? size : 1);
+  if(!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+
+void *operator new(size_t size,const std::nothrow_t &) noexcept {
+  return malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size,const std::nothrow_t &) noexcept {
+  return malloc(size ? size : 1);
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p,const std::nothrow_t &) noexcept {
+  free(p);
+}
+
+void operator delete[](void *p,const std::nothrow_t &) noexcept {
+  free(p);
+}
+
+#endif
+
+AllocTracker::Counts AllocTracker::thread() {
+  Counts c;
+  c.allocs = threadAllocs.allocs;
+  c.bytes  = threadAllocs.bytes;
+  return c;
+}
+
+void AllocTracker::print() {
+#ifndef SIM_TRACK_ALLOCS
+  printf("Allocation tracking not compiled in (qmake CONFIG+=track_allocs)\n");
+#else
+  std::lock_guard<std::mutex> lock(phasesMutex);
+
+  printf("%-24s %8s %8s %8s %10s %12s\n","phase","calls","last","max","total","bytes");
+  for(unsigned int i=0;i<nbPhases;++i) {
+    const PhaseAllocs &p = phases[i];
+    printf("%-24s %8llu %8llu %8llu %10llu %12llu\n",p.phase,
+           (unsigned long long)p.calls,(unsigned long long)p.last,(unsigned long long)p.max,
+           (unsigned long long)p.total,(unsigned long long)p.bytes);
+  }
+#endif
+}
+
+AllocScope::AllocScope(const char *phase,bool forbid)
+  : _phase(phase),
+    _previous(threadAllocs.forbidden),
+    _start(AllocTracker::thread()),
+    _forbid(forbid) {
+  if(_forbid)
+    threadAllocs.forbidden = _phase;
+}
+
+AllocScope::~AllocScope() {
+  const AllocTracker::Counts end = AllocTracker::thread();
+  const uint64_t allocs = end.allocs-_start.allocs;
+
+  if(_forbid)
+    threadAllocs.forbidden = _previous;
+
+  std::lock_guard<std::mutex> lock(phasesMutex);
+  unsigned int i = 0;
+  while(i<nbPhases && strcmp(phases[i].phase,_phase))
+    i++;
+
+  if(i==nbPhases) {
+    if(nbPhases==maxPhases)
+      return;
+    memset(&phases[i],0,sizeof(PhaseAllocs));
+    phases[i].phase = _phase;
+    nbPhases++;
+  }
+
+  PhaseAllocs &p = phases[i];
+  p.calls++;
+  p.last   = allocs;
+  p.max    = allocs>p.max ? allocs : p.max;
+  p.total += allocs;
+  p.bytes += end.bytes-_start.bytes;
+}
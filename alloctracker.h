@@ -0,0 +1,58 @@
+#ifndef ALLOCTRACKER_H
+#define ALLOCTRACKER_H
+
+#include <stdint.h>
+
+// Heap allocation tracking, opt-in at build time: qmake CONFIG+=track_allocs
+//
+// operator new/delete are replaced so that every allocation goes through
+// malloc, and malloc/calloc/realloc are wrapped by the linker (--wrap):
+// each thread counts its own allocations without any lock.
+//
+//   ALLOC_SCOPE(name)       accumulates the allocations done in a phase
+//   ALLOC_FREE_SCOPE(name)  same, for phases that must not allocate at all:
+//                           with SIM_ALLOC_ASSERT=1 every allocation inside
+//                           is reported on stderr, SIM_ALLOC_ASSERT=abort aborts
+//
+// Without track_allocs the macros expand to nothing.
+
+class AllocTracker {
+ public:
+  struct Counts {
+    uint64_t allocs;
+    uint64_t bytes;
+  };
+
+  // allocations done by the calling thread since it started
+  static Counts thread();
+
+  // per-phase table: calls, allocations of the last call, max and total
+  static void print();
+};
+
+class AllocScope {
+ public:
+  AllocScope(const char *phase,bool forbid);
+  ~AllocScope();
+
+ private:
+  AllocScope(const AllocScope &);
+  AllocScope &operator=(const AllocScope &);
+
+  const char           *_phase;
+  const char           *_previous; // enclosing forbidden phase
+  AllocTracker::Counts  _start;
+  bool                  _forbid;
+};
+
+#ifdef SIM_TRACK_ALLOCS
+#define ALLOC_CONCAT_(a,b) a##b
+#define ALLOC_CONCAT(a,b)  ALLOC_CONCAT_(a,b)
+#define ALLOC_SCOPE(phase)      AllocScope ALLOC_CONCAT(_allocScope,__LINE__)(phase,false)
+#define ALLOC_FREE_SCOPE(phase) AllocScope ALLOC_CONCAT(_allocScope,__LINE__)(phase,true)
+#else
+#define ALLOC_SCOPE(phase)
+#define ALLOC_FREE_SCOPE(phase)
+#endif
+
+#endif // ALLOCTRACKER_H
@@ -0,0 +1,143 @@
+#include "backgroundLoader.h"
+#include "progressiveMesh.h"
+#include "trace.h"
+
+#include <sys/stat.h>
+
+BackgroundLoader::BackgroundLoader()
+  : _gridSize(0),
+    _gridMin(0.0f),
+    _gridMax(0.0f),
+    _grid(NULL),
+    _nbLoaded(0),
+    _nbTaken(0),
+    _progress(0.0f),
+    _quit(false) {
+}
+
+BackgroundLoader::~BackgroundLoader() {
+  // the parsing, conversion, simplification or cache writing in progress
+  // stops at its next check
+  _quit = true;
+
+  if(_thread.joinable())
+    _thread.join();
+  delete _grid;
+}
+
+void BackgroundLoader::loadGrid(unsigned int size,float minval,float maxval) {
+  _gridSize = size;
+  _gridMin  = minval;
+  _gridMax  = maxval;
+}
+
+void BackgroundLoader::load(unsigned int id,const std::string &filename,const std::string &chunked) {
+  struct stat s;
+  File f;
+  f.id      = id;
+  f.name    = filename;
+  f.chunked = chunked;
+  f.size = stat(filename.c_str(),&s)==0 ? (double)s.st_size : 0.0;
+  _files.push_back(f);
+}
+
+void BackgroundLoader::start() {
+  _thread = std::thread(&BackgroundLoader::run,this);
+}
+
+Grid *BackgroundLoader::grid() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  Grid *g = _grid;
+  _grid = NULL;
+  return g;
+}
+
+std::shared_ptr<BackgroundLoader::Result> BackgroundLoader::next() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::shared_ptr<Result> r;
+  if(_nbTaken<_nbLoaded) {
+    r.swap(_loaded[_nbTaken]);
+    _nbTaken++;
+  }
+  return r;
+}
+
+float BackgroundLoader::progress() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  double total = 0.0,loaded = 0.0;
+  for(unsigned int i=0;i<_files.size();++i) {
+    total  += _files[i].size;
+    loaded += i<_nbLoaded ? _files[i].size : (i==_nbLoaded ? _progress*_files[i].size : 0.0);
+  }
+  return total>0.0 ? (float)(loaded/total) : (_nbLoaded==_files.size() ? 1.0f : 0.0f);
+}
+
+bool BackgroundLoader::done() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _nbTaken==_files.size();
+}
+
+bool BackgroundLoader::loads(unsigned int id) const {
+  for(unsigned int i=0;i<_files.size();++i) {
+    if(_files[i].id==id)
+      return true;
+  }
+  return false;
+}
+
+void BackgroundLoader::run() {
+  if(_gridSize>0) {
+    Grid *g = new Grid(_gridSize,_gridMin,_gridMax);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _grid = g;
+  }
+
+  for(unsigned int i=0;i<_files.size() && !_quit;++i) {
+    TRACE_SCOPE("BackgroundLoader::load");
+    std::shared_ptr<Result> r(new Result());
+    r->id = _files[i].id;
+    _progress = 0.0f;
+
+    if(!_files[i].chunked.empty()) {
+      // out of core: only the chunks of the file are mapped
+      r->chunked = new ChunkedMesh();
+      if(!ChunkedMesh::convert(_files[i].chunked,_files[i].name.c_str(),&_progress,&_quit) ||
+	 !r->chunked->open(_files[i].chunked,_files[i].name.c_str())) {
+	if(!_quit)
+	  printf("Unable to convert %s\n",_files[i].name.c_str());
+	delete r->chunked;
+	r->chunked = NULL;
+      }
+    } else if(PointCloud::isPointCloud(_files[i].name.c_str())) {
+      // no faces: no levels nor meshlets, the octree instead
+      r->cloud = new PointCloud(_files[i].name.c_str(),&_progress,&_quit);
+    } else {
+      r->mesh = new Mesh(&_files[i].name[0],&_progress,&_quit);
+      if(_quit)
+	return;
+
+      // all the levels in the same range (they share the vertices), the
+      // faces of each one in the order of its meshlets
+      const Mesh *m = r->mesh;
+      r->levels.build(m->vertices,m->nb_vertices,m->faces,m->nb_faces,r->indices,256,LodChain::MAX_LEVELS,&_quit);
+      if(_quit)
+	return;
+      r->levels.buildMeshlets(m->vertices,m->nb_vertices,r->indices,r->meshlets);
+    }
+    if(_quit)
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _loaded.push_back(r);
+      _nbLoaded++;
+    }
+
+    // its cache, for the next runs (the viewer may upload the mesh
+    // meanwhile), then the mesh is only held by the viewer until uploaded
+    const std::string cache = ProgressiveMesh::cacheFilename(_files[i].name.c_str());
+    const Mesh       *m     = r->mesh;
+    if(m && !cache.empty())
+      ProgressiveMesh::write(cache,_files[i].name.c_str(),m->vertices,m->nb_vertices,m->faces,m->nb_faces,m->center,m->radius,&_quit);
+  }
+}
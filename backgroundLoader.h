@@ -0,0 +1,90 @@
+#ifndef BACKGROUND_LOADER_H
+#define BACKGROUND_LOADER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "meshLoader.h"
+#include "simplify.h"
+#include "chunkedMesh.h"
+#include "pointCloud.h"
+#include "grid.h"
+
+// The grid of the tiles, then the OFF files, loaded on a worker thread,
+// one after the other: parsed, then
+// their levels of detail and meshlets are built (everything createScene
+// did before the first frame), converted into chunks for the ones too
+// large for the memory, or sorted in an octree for the point clouds. The
+// viewer polls next() and uploads each mesh while the window stays
+// responsive. The progressive cache of each mesh is written for the next
+// runs right after it is loaded, before the next file.
+class BackgroundLoader {
+ public:
+  struct Result {
+    unsigned int              id;       // given to load()
+    Mesh                     *mesh;     // NULL if out of core or a point cloud
+    LodChain                  levels;
+    std::vector<Meshlets>     meshlets;
+    std::vector<unsigned int> indices;  // of all the levels, in the order of their meshlets
+    ChunkedMesh              *chunked;  // out of core, NULL if the conversion failed
+    PointCloud               *cloud;    // OFF file without faces
+
+    Result() : mesh(NULL),chunked(NULL),cloud(NULL) {}
+    ~Result() {delete mesh; delete chunked; delete cloud;}
+  };
+
+  BackgroundLoader();
+  ~BackgroundLoader();
+
+  // queued files, loaded once started. chunked: not empty for a file
+  // rendered out of core, converted there
+  void load(unsigned int id,const std::string &filename,const std::string &chunked="");
+  void start();
+
+  // grid built first once started (if queued), NULL until then and once
+  // returned: the caller deletes it
+  void  loadGrid(unsigned int size,float minval,float maxval);
+  Grid *grid();
+
+  // next loaded mesh, NULL if none. Shared with the worker thread while it
+  // writes its cache: released by whichever is done last
+  std::shared_ptr<Result> next();
+
+  // loaded part of the queued files (by size, 0 to 1)
+  float progress();
+  // every queued file is loaded and was returned by next()
+  bool  done();
+
+  // queued files, and whether id is one of them
+  inline unsigned int size() const {return _files.size();}
+  bool loads(unsigned int id) const;
+
+ private:
+  struct File {
+    unsigned int id;
+    std::string  name;
+    std::string  chunked;
+    double       size;
+  };
+
+  void run(); // worker thread
+
+  unsigned int                          _gridSize; // 0: no grid
+  float                                 _gridMin;
+  float                                 _gridMax;
+  Grid                                 *_grid;     // built, not returned by grid() yet
+  std::vector<File>                     _files;
+  std::vector<std::shared_ptr<Result> > _loaded;  // not returned by next() yet
+  unsigned int                          _nbLoaded;
+  unsigned int                          _nbTaken;
+  std::atomic<float>                    _progress; // of the file being parsed
+
+  std::thread       _thread;
+  std::mutex        _mutex;
+  std::atomic<bool> _quit; // also stops the parsing and the cache writing
+};
+
+#endif // BACKGROUND_LOADER_H
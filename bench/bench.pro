@@ -0,0 +1,34 @@
+# micro-benchmarks of the math, grid and mesh code (no Qt, no OpenGL)
+# usage: qmake && make && ./bench --json results.json
+#        ./bench --compare baseline.json results.json [--thresholds file] [--alpha a]
+#        ./bench --write-off nbFaces file.off
+#        ./bench --check
+# see regress.sh for the full regression gate
+
+TEMPLATE  = app
+TARGET    = bench
+
+SOURCES   = main.cpp benchmark.cpp compare.cpp check.cpp \
+    ../meshLoader.cpp ../grid.cpp ../trackball.cpp ../trace.cpp ../perfcounters.cpp \
+    ../transform.cpp ../bvh.cpp ../occlusion.cpp ../meshlets.cpp ../simplify.cpp \
+    ../progressiveMesh.cpp ../chunkedMesh.cpp ../pointCloud.cpp
+HEADERS   = benchmark.h compare.h check.h \
+    ../meshLoader.h ../grid.h ../trackball.h ../trace.h ../perfcounters.h \
+    ../transform.h ../bvh.h ../occlusion.h ../meshlets.h ../simplify.h \
+    ../progressiveMesh.h ../chunkedMesh.h ../pointCloud.h
+
+INCLUDEPATH += ..
+LIBS     += -lm
+
+CONFIG   += console warn_on thread release
+CONFIG   -= qt app_bundle
+QMAKE_CXXFLAGS += -std=c++14
+
+# SIMD matrices (see mat4simd.h): SSE by default on x86,
+# qmake CONFIG+=avx for the Mat4d versions, CONFIG+=no_simd for the scalar code
+avx {
+  QMAKE_CXXFLAGS += -mavx
+}
+no_simd {
+  DEFINES += SIM_NO_SIMD
+}
@@ -0,0 +1,332 @@
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <algorithm>
+
+using namespace std;
+
+Benchmark::Benchmark()
+  : _minSamples(5),
+    _maxSamples(50),
+    _budget(0.5),
+    _maxFaces(1000000),
+    _perf(false) {
+
+}
+
+bool Benchmark::parseArgs(int argc,char **argv) {
+  for(int i=1;i<argc;++i) {
+    const bool hasValue = i+1<argc;
+
+    if(!strcmp(argv[i],"--filter") && hasValue) {
+      _filter = argv[++i];
+    } else if(!strcmp(argv[i],"--json") && hasValue) {
+      _jsonFilename = argv[++i];
+    } else if(!strcmp(argv[i],"--min-samples") && hasValue) {
+      _minSamples = atoi(argv[++i]);
+    } else if(!strcmp(argv[i],"--max-samples") && hasValue) {
+      _maxSamples = atoi(argv[++i]);
+    } else if(!strcmp(argv[i],"--budget") && hasValue) {
+      _budget = atof(argv[++i]);
+    } else if(!strcmp(argv[i],"--max-faces") && hasValue) {
+      _maxFaces = strtoul(argv[++i],NULL,10);
+    } else if(!strcmp(argv[i],"--perf")) {
+      _perf = true;
+      PerfCounters::setEnabled(true);
+    } else {
+      printf("Usage: %s [--filter name] [--json file] [--min-samples n] [--max-samples n]"
+             " [--budget seconds] [--max-faces n] [--perf]\n",argv[0]);
+      return false;
+    }
+  }
+
+  _minSamples = _minSamples<2 ? 2 : _minSamples;
+  _maxSamples = _maxSamples<_minSamples ? _minSamples : _maxSamples;
+  return true;
+}
+
+void Benchmark::addResult(BenchmarkResult &r) {
+  computeStats(r);
+
+  // human readable report: time per iteration and per element
+  const double perElement = r.median/(double)r.elements;
+  printf("%-32s %12.1f ns  (min %.1f, mean %.1f, sd %4.1f%%, n=%u x %lu)",
+         r.name.c_str(),r.median,r.min,r.mean,100.0*r.stddev/r.mean,
+         (unsigned int)r.samples.size(),r.iterations);
+  if(r.elements>1)
+    printf("  %.2f ns/elt",perElement);
+  printf("\n");
+
+  // IPC and misses per element over all the samples
+  if(_perf) {
+    const PerfCounters::Values &c = r.counters;
+    const double n = (double)r.elements*(double)r.iterations*(double)r.samples.size();
+
+    printf("%-32s","");
+    if(c.valid[PerfCounters::CYCLES] && c.valid[PerfCounters::INSTRUCTIONS] && c.value[PerfCounters::CYCLES]>0)
+      printf(" IPC %.2f",(double)c.value[PerfCounters::INSTRUCTIONS]/(double)c.value[PerfCounters::CYCLES]);
+    for(int i=PerfCounters::LLC_MISSES;i<PerfCounters::NB_COUNTERS;++i)
+      if(c.valid[i])
+        printf(", %s/elt %.4f",PerfCounters::name(i),(double)c.value[i]/n);
+    if(!c.valid[PerfCounters::CYCLES])
+      printf(" (counters unavailable)");
+    printf("\n");
+  }
+  fflush(stdout);
+
+  _results.push_back(r);
+}
+
+void computeStats(BenchmarkResult &r) {
+  vector<double> s = r.samples;
+  const double n = (double)s.size();
+
+  if(s.empty()) {
+    r.min = r.max = r.median = r.mean = r.stddev = 0.0;
+    return;
+  }
+
+  sort(s.begin(),s.end());
+
+  r.min    = s.front();
+  r.max    = s.back();
+  r.median = s.size()%2 ? s[s.size()/2] : 0.5*(s[s.size()/2-1]+s[s.size()/2]);
+
+  r.mean = 0.0;
+  for(unsigned int i=0;i<s.size();++i)
+    r.mean += s[i];
+  r.mean /= n;
+
+  r.stddev = 0.0;
+  for(unsigned int i=0;i<s.size();++i)
+    r.stddev += (s[i]-r.mean)*(s[i]-r.mean);
+  r.stddev = s.size()>1 ? sqrt(r.stddev/(n-1.0)) : 0.0;
+}
+
+bool writeBenchmarkJson(const char *filename,const vector<BenchmarkResult> &results) {
+  FILE *file;
+
+  if((file=fopen(filename,"w"))==NULL) {
+    printf("Unable to write %s\n",filename);
+    return false;
+  }
+
+  fprintf(file,"{\n  \"unit\": \"ns\",\n  \"benchmarks\": [");
+  for(unsigned int i=0;i<results.size();++i) {
+    const BenchmarkResult &r = results[i];
+
+    fprintf(file,"%s\n    {\"name\": \"%s\", \"elements\": %lu, \"iterations\": %lu,\n",
+            i==0 ? "" : ",",r.name.c_str(),r.elements,r.iterations);
+    fprintf(file,"     \"min\": %.3f, \"max\": %.3f, \"median\": %.3f, \"mean\": %.3f, \"stddev\": %.3f,\n",
+            r.min,r.max,r.median,r.mean,r.stddev);
+    // raw counts over iterations*samples runs
+    bool first = true;
+    for(int j=0;j<PerfCounters::NB_COUNTERS;++j) {
+      if(!r.counters.valid[j])
+        continue;
+      fprintf(file,"%s\"%s\": %llu",first ? "     \"counters\": {" : ", ",
+              PerfCounters::name(j),(unsigned long long)r.counters.value[j]);
+      first = false;
+    }
+    if(!first)
+      fprintf(file,"},\n");
+
+    fprintf(file,"     \"samples\": [");
+    for(unsigned int j=0;j<r.samples.size();++j)
+      fprintf(file,"%s%.3f",j==0 ? "" : ", ",r.samples[j]);
+    fprintf(file,"]}");
+  }
+  fprintf(file,"\n  ]\n}\n");
+  fclose(file);
+
+  return true;
+}
+
+namespace {
+
+  // just enough JSON to read back the files written above
+  class JsonReader {
+  public:
+    JsonReader(const string &text) : _s(text), _i(0) {}
+
+    void skipSpaces() {
+      while(_i<_s.size() && isspace((unsigned char)_s[_i]))
+        _i++;
+    }
+
+    bool accept(char c) {
+      skipSpaces();
+      if(_i<_s.size() && _s[_i]==c) {
+        _i++;
+        return true;
+      }
+      return false;
+    }
+
+    bool readString(string &str) {
+      if(!accept('"'))
+        return false;
+
+      str.clear();
+      while(_i<_s.size() && _s[_i]!='"') {
+        if(_s[_i]=='\\' && _i+1<_s.size())
+          _i++;
+        str += _s[_i++];
+      }
+      return accept('"');
+    }
+
+    bool readNumber(double &d) {
+      skipSpaces();
+      const char *start = _s.c_str()+_i;
+      char *end;
+      d = strtod(start,&end);
+      _i += end-start;
+      return end!=start;
+    }
+
+    // skip any value (object, array, string, number or literal)
+    bool skipValue() {
+      skipSpaces();
+      if(_i>=_s.size())
+        return false;
+
+      string str;
+      if(_s[_i]=='"')
+        return readString(str);
+
+      if(_s[_i]=='{' || _s[_i]=='[') {
+        const char close = _s[_i]=='{' ? '}' : ']';
+        _i++;
+        if(accept(close))
+          return true;
+        do {
+          if(close=='}' && (!readString(str) || !accept(':')))
+            return false;
+          if(!skipValue())
+            return false;
+        } while(accept(','));
+        return accept(close);
+      }
+
+      while(_i<_s.size() && (isalnum((unsigned char)_s[_i]) || strchr("+-.",_s[_i])))
+        _i++;
+      return true;
+    }
+
+    bool readResult(BenchmarkResult &r) {
+      string key;
+      double d;
+
+      r.elements   = 1;
+      r.iterations = 1;
+      r.samples.clear();
+
+      if(!accept('{'))
+        return false;
+      if(accept('}'))
+        return true;
+
+      do {
+        if(!readString(key) || !accept(':'))
+          return false;
+
+        if(key=="name") {
+          if(!readString(r.name))
+            return false;
+        } else if(key=="elements" || key=="iterations") {
+          if(!readNumber(d))
+            return false;
+          (key=="elements" ? r.elements : r.iterations) = (unsigned long)d;
+        } else if(key=="samples") {
+          if(!accept('['))
+            return false;
+          if(!accept(']')) {
+            do {
+              if(!readNumber(d))
+                return false;
+              r.samples.push_back(d);
+            } while(accept(','));
+            if(!accept(']'))
+              return false;
+          }
+        } else if(!skipValue()) {
+          return false;
+        }
+      } while(accept(','));
+
+      computeStats(r);
+      return accept('}');
+    }
+
+    bool readFile(vector<BenchmarkResult> &results) {
+      string key;
+
+      if(!accept('{'))
+        return false;
+      do {
+        if(!readString(key) || !accept(':'))
+          return false;
+
+        if(key!="benchmarks") {
+          if(!skipValue())
+            return false;
+          continue;
+        }
+
+        if(!accept('['))
+          return false;
+        if(accept(']'))
+          continue;
+        do {
+          BenchmarkResult r;
+          if(!readResult(r))
+            return false;
+          results.push_back(r);
+        } while(accept(','));
+        if(!accept(']'))
+          return false;
+      } while(accept(','));
+
+      return accept('}');
+    }
+
+  private:
+    const string &_s;
+    size_t        _i;
+  };
+
+}
+
+bool readBenchmarkJson(const char *filename,vector<BenchmarkResult> &results) {
+  FILE *file;
+  string text;
+  char buffer[4096];
+  size_t n;
+
+  if((file=fopen(filename,"r"))==NULL) {
+    printf("Unable to read %s\n",filename);
+    return false;
+  }
+
+  while((n=fread(buffer,1,sizeof(buffer),file))>0)
+    text.append(buffer,n);
+  fclose(file);
+
+  JsonReader reader(text);
+  if(!reader.readFile(results)) {
+    printf("Unable to parse %s\n",filename);
+    return false;
+  }
+
+  return true;
+}
+
+string tmpFilename(const char *name) {
+  const char *dir = getenv("TMPDIR");
+  return string(dir && dir[0] ? dir : "/tmp")+"/"+name;
+}
@@ -0,0 +1,130 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "perfcounters.h"
+
+// Minimal benchmark harness: every case is warmed up, then timed over
+// several samples (each sample runs the case enough times to last about
+// 1ms). Per-iteration statistics are printed and can be written as JSON.
+
+// prevent the compiler from optimizing away a computed value
+template<class T>
+inline void doNotOptimize(const T &value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct BenchmarkResult {
+  std::string         name;
+  unsigned long       elements;   // work items per iteration (faces, vertices...)
+  unsigned long       iterations; // iterations per sample
+  std::vector<double> samples;    // ns per iteration
+
+  double min;
+  double max;
+  double median;
+  double mean;
+  double stddev;
+
+  // hardware counters over all the samples (--perf)
+  PerfCounters::Values counters;
+};
+
+// fill min/max/median/mean/stddev from the samples
+void computeStats(BenchmarkResult &r);
+
+// JSON format shared by the micro-benchmarks and the frame benchmark of tp03
+bool writeBenchmarkJson(const char *filename,const std::vector<BenchmarkResult> &results);
+bool readBenchmarkJson(const char *filename,std::vector<BenchmarkResult> &results);
+
+// temporary file of a benchmark or check, in $TMPDIR (/tmp by default)
+std::string tmpFilename(const char *name);
+
+class Benchmark {
+ public:
+  Benchmark();
+
+  // --filter <substring> --json <file> --min-samples <n> --max-samples <n>
+  // --budget <seconds> --max-faces <n> --perf
+  bool parseArgs(int argc,char **argv);
+
+  inline unsigned long maxFaces() const {return _maxFaces;}
+  inline bool perf() const {return _perf;}
+  inline bool selected(const std::string &name) const {
+    return _filter.empty() || name.find(_filter)!=std::string::npos;
+  }
+
+  // time f() and store the result (elements = work items done by one call)
+  template<class F>
+  void run(const std::string &name,F f,unsigned long elements=1);
+
+  inline bool writeJson(const char *filename) const {return writeBenchmarkJson(filename,_results);}
+  inline const std::string &jsonFilename() const {return _jsonFilename;}
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  void addResult(BenchmarkResult &r);
+
+  std::string   _filter;
+  std::string   _jsonFilename;
+  unsigned int  _minSamples;
+  unsigned int  _maxSamples;
+  double        _budget; // seconds per case, warm-up excluded
+  unsigned long _maxFaces;
+  bool          _perf;
+
+  std::vector<BenchmarkResult> _results;
+};
+
+template<class F>
+void Benchmark::run(const std::string &name,F f,unsigned long elements) {
+  if(!selected(name))
+    return;
+
+  // warm-up and calibration: grow the batch until it lasts at least 1ms
+  const double minSampleTime = 1e-3;
+  unsigned long iterations = 1;
+  double t = 0.0;
+
+  for(;;) {
+    const Clock::time_point start = Clock::now();
+    for(unsigned long i=0;i<iterations;++i)
+      f();
+    t = std::chrono::duration<double>(Clock::now()-start).count();
+
+    if(t>=minSampleTime)
+      break;
+    iterations *= t<minSampleTime/10.0 ? 10 : 2;
+  }
+
+  // number of samples that fit in the time budget
+  unsigned int nbSamples = (unsigned int)(_budget/t);
+  nbSamples = nbSamples<_minSamples ? _minSamples : nbSamples;
+  nbSamples = nbSamples>_maxSamples ? _maxSamples : nbSamples;
+
+  BenchmarkResult r;
+  r.name       = name;
+  r.elements   = elements;
+  r.iterations = iterations;
+
+  const PerfCounters::Values counters = _perf ? PerfCounters::thread().read() : PerfCounters::Values();
+
+  for(unsigned int s=0;s<nbSamples;++s) {
+    const Clock::time_point start = Clock::now();
+    for(unsigned long i=0;i<iterations;++i)
+      f();
+    const double dt = std::chrono::duration<double,std::nano>(Clock::now()-start).count();
+    r.samples.push_back(dt/(double)iterations);
+  }
+
+  if(_perf)
+    r.counters = PerfCounters::thread().read()-counters;
+
+  addResult(r);
+}
+
+#endif // BENCHMARK_H
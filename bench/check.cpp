@@ -0,0 +1,327 @@
+#include "check.h"
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "../mat4.h"
+#include "../quat.h"
+#include "../transform.h"
+#include "../occlusion.h"
+#include "../progressiveMesh.h"
+
+using namespace std;
+
+namespace {
+
+  // a float (or double) the SIMD specializations do not apply to: Mat4 of
+  // it runs the generic code of mat4.h, with the same operations
+  template<class F>
+  struct Scalar {
+    constexpr Scalar() : v() {}
+    constexpr Scalar(F x) : v(x) {}
+
+    F v;
+  };
+
+  template<class F> inline Scalar<F> operator+(Scalar<F> a,Scalar<F> b) {return a.v+b.v;}
+  template<class F> inline Scalar<F> operator-(Scalar<F> a,Scalar<F> b) {return a.v-b.v;}
+  template<class F> inline Scalar<F> operator*(Scalar<F> a,Scalar<F> b) {return a.v*b.v;}
+  template<class F> inline Scalar<F> operator-(Scalar<F> a) {return -a.v;}
+  template<class F> inline Scalar<F> &operator*=(Scalar<F> &a,Scalar<F> b) {a.v *= b.v; return a;}
+  template<class F> inline Scalar<F> operator/(double a,Scalar<F> b) {return (F)(a/b.v);}
+  template<class F> inline F fabs(Scalar<F> a) {return std::fabs(a.v);}
+
+  template<class F>
+  Mat4<Scalar<F> > scalar(const Mat4<F> &m) {
+    Mat4<Scalar<F> > r;
+    for(int i=0;i<16;++i)
+      r[i] = m[i];
+    return r;
+  }
+
+  template<class F>
+  Vec4<Scalar<F> > scalar(const Vec4<F> &v) {
+    return Vec4<Scalar<F> >(v(0),v(1),v(2),v(3));
+  }
+
+  // same bits (-0 and 0 differ)
+  template<class F>
+  bool same(const Mat4<F> &a,const Mat4<Scalar<F> > &b) {
+    for(int i=0;i<16;++i) {
+      if(memcmp(&a[i],&b[i].v,sizeof(F))!=0)
+	return false;
+    }
+    return true;
+  }
+
+  template<class F>
+  bool same(const Vec4<F> &a,const Vec4<Scalar<F> > &b) {
+    for(int i=0;i<4;++i) {
+      if(memcmp(&a(i),&b(i).v,sizeof(F))!=0)
+	return false;
+    }
+    return true;
+  }
+
+  inline bool sameBits(float a,float b) {
+    return memcmp(&a,&b,sizeof(float))==0;
+  }
+
+  inline float random(float min,float max) {
+    return min+(max-min)*rand()/RAND_MAX;
+  }
+
+  bool report(const char *name,unsigned long nbErrors,unsigned long nbTests) {
+    if(nbErrors==0)
+      printf("%-36s ok (%lu tested)\n",name,nbTests);
+    else
+      printf("%-36s FAILED: %lu of %lu differ\n",name,nbErrors,nbTests);
+    return nbErrors==0;
+  }
+
+  // products, transposes and (Mat4f only) inverses of random matrices
+  template<class F>
+  bool checkMat4(const char *name,bool inverses) {
+    const unsigned int n = 100000;
+    unsigned int nbErrors = 0;
+
+    srand(1);
+    for(unsigned int i=0;i<n;++i) {
+      Mat4<F> a,b;
+      Vec4<F> v;
+      for(int k=0;k<16;++k) {
+	a[k] = random(-2.0f,2.0f);
+	b[k] = random(-2.0f,2.0f);
+      }
+      for(int k=0;k<4;++k)
+	v(k) = random(-2.0f,2.0f);
+
+      const Mat4<Scalar<F> > sa = scalar(a),sb = scalar(b);
+      Mat4<F> c = a;
+      c *= b;
+      bool ok = same(a*b,sa*sb) && same(c,sa*sb) && same(a*v,sa*scalar(v)) && same(a.transpose(),sa.transpose());
+
+      if(inverses) {
+	Mat4<F> t = a;
+	t[3] = t[7] = t[11] = 0;
+	t[15] = 1;
+	ok = ok && same(a.inverse(),sa.inverse()) && same(t.affineInverse(),scalar(t).affineInverse());
+      }
+
+      nbErrors += !ok;
+    }
+
+    return report(name,nbErrors,n);
+  }
+
+  // AoS and SoA transforms and frustum masks against Mat4f*Vec4f, with the
+  // kernels given by Transform::simd()
+  bool checkTransform(const char *name) {
+    const size_t n = 100003; // the scalar tails too
+
+    const Mat4f mvp = Mat4f(1.5f,0,0,0, 0,2,0,0, 0,0,-1.02f,-0.2f, 0,0,-1,0)*
+      Quatf(Vec3f(1,2,3).normal(),0.3f).toMat4().translateEq(Vec3f(0,0,-3));
+
+    vector<float> xyz(3*n),x(n),y(n),z(n),aos(4*n),soa(4*n);
+    vector<uint8_t> maskAoS((n+7)/8),maskSoA((n+7)/8);
+    srand(1);
+    for(size_t i=0;i<n;++i) {
+      x[i] = xyz[3*i]   = random(-2.0f,2.0f);
+      y[i] = xyz[3*i+1] = random(-2.0f,2.0f);
+      z[i] = xyz[3*i+2] = random(-2.0f,2.0f);
+    }
+
+    Transform::points(mvp,&xyz[0],&aos[0],n);
+    Transform::points(mvp,&x[0],&y[0],&z[0],&soa[0],&soa[n],&soa[2*n],&soa[3*n],n);
+    const size_t nbVisibleAoS = Transform::frustumMask(mvp,&xyz[0],&maskAoS[0],n);
+    const size_t nbVisibleSoA = Transform::frustumMask(mvp,&x[0],&y[0],&z[0],&maskSoA[0],n);
+
+    unsigned long nbErrors  = 0;
+    size_t        nbVisible = 0;
+    for(size_t i=0;i<n;++i) {
+      const Vec4f c      = mvp*Vec4f(x[i],y[i],z[i],1.0f);
+      const bool  inside = -c[3]<=c[0] && c[0]<=c[3] && -c[3]<=c[1] && c[1]<=c[3] && -c[3]<=c[2] && c[2]<=c[3];
+      bool ok = true;
+      for(int k=0;k<4;++k)
+	ok = ok && sameBits(aos[4*i+k],c[k]) && sameBits(soa[k*n+i],c[k]);
+      ok = ok && ((maskAoS[i/8]>>(i%8))&1)==inside && ((maskSoA[i/8]>>(i%8))&1)==inside;
+      nbErrors  += !ok;
+      nbVisible += inside;
+    }
+    nbErrors += (nbVisibleAoS!=nbVisible)+(nbVisibleSoA!=nbVisible);
+
+    return report(name,nbErrors,n);
+  }
+
+  // random occluder triangles in front of random spheres, depth buffer and
+  // visibility of the AVX2 version against the scalar one
+  bool checkOcclusion() {
+    const char *name = "occlusion_avx2_vs_scalar";
+
+    if(!Occlusion::simd()) {
+      printf("%-36s skipped (no AVX2)\n",name);
+      return true;
+    }
+
+    const unsigned int nbTriangles = 256;
+    vector<float>        vertices(9*nbTriangles);
+    vector<unsigned int> faces(3*nbTriangles);
+    srand(1);
+    for(unsigned int i=0;i<nbTriangles;++i) {
+      const Vec3f c(random(-3.0f,3.0f),random(0.0f,1.0f),random(-1.0f,1.0f));
+      for(unsigned int j=0;j<3;++j) {
+	vertices[9*i+3*j]   = c[0]+random(-0.5f,0.5f);
+	vertices[9*i+3*j+1] = c[1]+random(-0.5f,0.5f);
+	vertices[9*i+3*j+2] = c[2]+random(-0.5f,0.5f);
+	faces[3*i+j]        = 3*i+j;
+      }
+    }
+
+    const unsigned int n = 65536;
+    vector<Box> boxes(n);
+    for(unsigned int i=0;i<n;++i)
+      boxes[i] = Box::sphere(Vec3f(random(-3.0f,3.0f),random(-0.5f,1.5f),random(1.0f,7.0f)),random(0.02f,0.1f));
+
+    const Mat4f mvp = Mat4f::perspective(45.0f,2.0f,0.05f,30.0f)*
+      Mat4f::lookAt(Vec3f(0.0f,0.5f,-3.0f),Vec3f(0.0f,0.5f,0.0f),Vec3f(0.0f,1.0f,0.0f));
+
+    Occlusion o;
+    o.addOccluder(&vertices[0],3*nbTriangles,&faces[0],nbTriangles,Mat4f::identity());
+
+    o.render(mvp);
+    const vector<float> depth(o.depth(),o.depth()+o.w()*o.h());
+    vector<bool> visible(n);
+    for(unsigned int i=0;i<n;++i)
+      visible[i] = o.visible(boxes[i]);
+
+    Occlusion::setSimd(false);
+    Transform::setSimd(false);
+    o.render(mvp);
+    Occlusion::setSimd(true);
+    Transform::setSimd(true);
+
+    unsigned long nbErrors = 0;
+    for(unsigned int i=0;i<o.w()*o.h();++i)
+      nbErrors += !sameBits(depth[i],o.depth()[i]);
+    for(unsigned int i=0;i<n;++i)
+      nbErrors += visible[i]!=o.visible(boxes[i]);
+
+    return report(name,nbErrors,o.w()*o.h()+n);
+  }
+
+  // every split of the cache of a bumpy grid (one position per vertex),
+  // the triangles compared with their first corner the smallest index
+  bool checkProgressive() {
+    const char        *name = "progressive_replay";
+    const unsigned int n    = 150;
+
+    vector<float>        vertices;
+    vector<unsigned int> faces;
+    for(unsigned int i=0;i<=n;++i) {
+      for(unsigned int j=0;j<=n;++j) {
+	const float x = (float)j/(float)n;
+	const float y = (float)i/(float)n;
+	vertices.push_back(x);
+	vertices.push_back(y);
+	vertices.push_back(0.1f*sinf(20.0f*x)*cosf(20.0f*y));
+      }
+    }
+    for(unsigned int i=0;i<n;++i) {
+      for(unsigned int j=0;j<n;++j) {
+	const unsigned int v = i*(n+1)+j;
+	const unsigned int t[6] = {v,v+1,v+n+2,v,v+n+2,v+n+1};
+	faces.insert(faces.end(),t,t+6);
+      }
+    }
+    const unsigned int nbVertices = vertices.size()/3;
+    const unsigned int nbFaces    = faces.size()/3;
+
+    const string   filename  = tmpFilename(name)+".pm";
+    const float    center[3] = {0.5f,0.5f,0.0f};
+    ProgressiveMesh pm;
+    if(!ProgressiveMesh::write(filename,NULL,&vertices[0],nbVertices,&faces[0],nbFaces,center,1.0f) ||
+       !pm.open(filename,NULL)) {
+      remove(filename.c_str());
+      return report(name,nbFaces,nbFaces);
+    }
+
+    while(!pm.finished()) {
+      if(pm.ready())
+	pm.next();
+      else
+	std::this_thread::yield();
+    }
+    remove(filename.c_str());
+
+    // original index of each vertex of the progressive mesh
+    typedef std::tuple<float,float,float> Position;
+    map<Position,unsigned int> original;
+    for(unsigned int i=0;i<nbVertices;++i)
+      original[Position(vertices[3*i],vertices[3*i+1],vertices[3*i+2])] = i;
+
+    vector<unsigned int> remap(pm.nbVertices(),nbVertices);
+    for(unsigned int i=0;i<pm.nbVertices();++i) {
+      const float *p = pm.vertices()+3*i;
+      map<Position,unsigned int>::const_iterator it = original.find(Position(p[0],p[1],p[2]));
+      if(it!=original.end())
+	remap[i] = it->second;
+    }
+
+    // same orientation: rotated, not sorted
+    typedef std::tuple<unsigned int,unsigned int,unsigned int> Triangle;
+    auto canonical = [](unsigned int a,unsigned int b,unsigned int c) {
+      if(b<a && b<c)
+	return Triangle(b,c,a);
+      if(c<a && c<b)
+	return Triangle(c,a,b);
+      return Triangle(a,b,c);
+    };
+
+    vector<Triangle> expected,replayed;
+    for(unsigned int i=0;i<nbFaces;++i)
+      expected.push_back(canonical(faces[3*i],faces[3*i+1],faces[3*i+2]));
+    for(unsigned int i=0;i<pm.nbIndices()/3;++i) {
+      const unsigned int *t = pm.indices()+3*i;
+      replayed.push_back(canonical(remap[t[0]],remap[t[1]],remap[t[2]]));
+    }
+    sort(expected.begin(),expected.end());
+    sort(replayed.begin(),replayed.end());
+
+    unsigned long nbErrors = pm.nbVertices()!=nbVertices ? nbFaces : 0;
+    if(expected.size()!=replayed.size())
+      nbErrors = nbFaces;
+    for(unsigned int i=0;i<std::min(expected.size(),replayed.size());++i)
+      nbErrors += expected[i]!=replayed[i];
+
+    return report(name,nbErrors,nbFaces);
+  }
+
+}
+
+bool runChecks() {
+  bool ok = true;
+
+  ok = checkMat4<float>("mat4f_simd_vs_scalar",true) && ok;
+  ok = checkMat4<double>("mat4d_simd_vs_scalar",false) && ok;
+
+  if(Transform::simd())
+    ok = checkTransform("transform_avx2_vs_mat4f") && ok;
+  Transform::setSimd(false);
+  ok = checkTransform("transform_scalar_vs_mat4f") && ok;
+  Transform::setSimd(true);
+
+  ok = checkOcclusion() && ok;
+  ok = checkProgressive() && ok;
+
+  printf(ok ? "All checks passed\n" : "Some checks FAILED\n");
+  return ok;
+}
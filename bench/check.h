@@ -0,0 +1,17 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+// Correctness checks of the optimized code (bench --check), run by the
+// regression gate before the timings:
+//  - the SIMD Mat4f/Mat4d operations give the same bits as the generic
+//    scalar code of mat4.h
+//  - the AVX2 and scalar batched transforms and frustum masks give the
+//    same bits as Mat4f::operator*(Vec4f)
+//  - the AVX2 and scalar occlusion rasterizers give the same depth buffer
+//  - replaying every split of a progressive mesh gives back the original
+//    triangles
+//
+// Each check prints one line, the result is false if any of them failed.
+bool runChecks();
+
+#endif // CHECK_H
@@ -0,0 +1,157 @@
+#include "compare.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using namespace std;
+
+Thresholds::Thresholds(double defaultValue)
+  : _default(defaultValue) {
+
+}
+
+bool Thresholds::load(const char *filename) {
+  FILE *file;
+  char line[512];
+  char name[256];
+  double value;
+
+  if((file=fopen(filename,"r"))==NULL) {
+    printf("Unable to read %s\n",filename);
+    return false;
+  }
+
+  while(fgets(line,sizeof(line),file)) {
+    if(line[0]=='#' || sscanf(line,"%255s %lf",name,&value)!=2)
+      continue;
+
+    if(!strcmp(name,"default"))
+      _default = value;
+    else
+      _values.push_back(make_pair(string(name),value));
+  }
+
+  fclose(file);
+  return true;
+}
+
+double Thresholds::get(const string &name) const {
+  // first matching line wins, "prefix*" matches every name starting with prefix
+  for(unsigned int i=0;i<_values.size();++i) {
+    const string &pattern = _values[i].first;
+
+    if(!pattern.empty() && pattern[pattern.size()-1]=='*') {
+      if(name.compare(0,pattern.size()-1,pattern,0,pattern.size()-1)==0)
+        return _values[i].second;
+    } else if(pattern==name) {
+      return _values[i].second;
+    }
+  }
+
+  return _default;
+}
+
+double mannWhitneySlowerPValue(const vector<double> &baseline,
+                               const vector<double> &current) {
+  const double n1 = (double)baseline.size();
+  const double n2 = (double)current.size();
+  const double n  = n1+n2;
+
+  if(baseline.empty() || current.empty())
+    return 1.0;
+
+  // rank the pooled samples (ties get their average rank)
+  vector<pair<double,int> > pooled;
+  for(unsigned int i=0;i<baseline.size();++i)
+    pooled.push_back(make_pair(baseline[i],0));
+  for(unsigned int i=0;i<current.size();++i)
+    pooled.push_back(make_pair(current[i],1));
+  sort(pooled.begin(),pooled.end());
+
+  double rankSum = 0.0; // sum of the ranks of the current samples
+  double ties    = 0.0; // sum of t^3-t over the groups of ties
+  for(unsigned int i=0;i<pooled.size();) {
+    unsigned int j = i;
+    while(j<pooled.size() && pooled[j].first==pooled[i].first)
+      j++;
+
+    const double rank = 0.5*(double)(i+1+j);
+    const double t = (double)(j-i);
+    for(unsigned int k=i;k<j;++k)
+      if(pooled[k].second==1)
+        rankSum += rank;
+    ties += t*t*t-t;
+    i = j;
+  }
+
+  // U is large when the current samples are slower
+  const double u     = rankSum-n2*(n2+1.0)/2.0;
+  const double mean  = n1*n2/2.0;
+  const double var   = n1*n2/12.0*((n+1.0)-ties/(n*(n-1.0)));
+
+  if(var<=0.0)
+    return 1.0;
+
+  const double z = (u-mean-0.5)/sqrt(var);
+  return 0.5*erfc(z/sqrt(2.0));
+}
+
+unsigned int compareBenchmarks(const vector<BenchmarkResult> &baseline,
+                               const vector<BenchmarkResult> &current,
+                               const Thresholds &thresholds,
+                               double alpha,
+                               unsigned int *nbNew) {
+  unsigned int nbRegressions = 0;
+  if(nbNew)
+    *nbNew = 0;
+
+  printf("%-32s %14s %14s %8s %8s %8s  %s\n",
+         "benchmark","baseline","current","change","limit","p","status");
+
+  for(unsigned int i=0;i<current.size();++i) {
+    const BenchmarkResult &c = current[i];
+    const BenchmarkResult *b = NULL;
+
+    for(unsigned int j=0;j<baseline.size() && !b;++j)
+      if(baseline[j].name==c.name)
+        b = &baseline[j];
+
+    if(!b) {
+      printf("%-32s %14s %14.1f %8s %8s %8s  new\n",c.name.c_str(),"-",c.median,"","","");
+      if(nbNew)
+        (*nbNew)++;
+      continue;
+    }
+
+    const double change = c.median/b->median-1.0;
+    const double limit  = thresholds.get(c.name);
+    const double p      = mannWhitneySlowerPValue(b->samples,c.samples);
+    const double pFaster = mannWhitneySlowerPValue(c.samples,b->samples);
+    const char *status  = "ok";
+
+    if(p<alpha && change>limit) {
+      status = "REGRESSION";
+      nbRegressions++;
+    } else if(p<alpha && change>0.0) {
+      status = "slower (within limit)";
+    } else if(pFaster<alpha && change<0.0) {
+      status = "faster";
+    }
+
+    printf("%-32s %14.1f %14.1f %+7.1f%% %7.1f%% %8.4f  %s\n",
+           c.name.c_str(),b->median,c.median,100.0*change,100.0*limit,p,status);
+  }
+
+  for(unsigned int j=0;j<baseline.size();++j) {
+    bool found = false;
+    for(unsigned int i=0;i<current.size() && !found;++i)
+      found = current[i].name==baseline[j].name;
+    if(!found)
+      printf("%-32s %14.1f %14s %8s %8s %8s  missing\n",baseline[j].name.c_str(),baseline[j].median,"-","","","");
+  }
+
+  return nbRegressions;
+}
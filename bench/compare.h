@@ -0,0 +1,42 @@
+#ifndef COMPARE_H
+#define COMPARE_H
+
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+// Regression gate: a benchmark fails when its samples are significantly
+// slower than the baseline ones (one-sided Mann-Whitney U test) AND its
+// median slowed down by more than the allowed threshold.
+
+class Thresholds {
+ public:
+  Thresholds(double defaultValue=0.05);
+
+  // text file, one "<name or prefix*> <max slowdown>" per line, # comments,
+  // the special name "default" sets the value used for unlisted benchmarks
+  bool load(const char *filename);
+
+  // allowed relative slowdown of the median (0.05 = 5%)
+  double get(const std::string &name) const;
+
+ private:
+  double                                        _default;
+  std::vector<std::pair<std::string,double> > _values;
+};
+
+// probability that the current samples are not slower than the baseline
+// ones (one-sided Mann-Whitney U test, normal approximation with ties)
+double mannWhitneySlowerPValue(const std::vector<double> &baseline,
+                               const std::vector<double> &current);
+
+// print a report and return the number of regressions. nbNew: if not
+// NULL, the number of current benchmarks without a baseline
+unsigned int compareBenchmarks(const std::vector<BenchmarkResult> &baseline,
+                               const std::vector<BenchmarkResult> &current,
+                               const Thresholds &thresholds,
+                               double alpha=0.01,
+                               unsigned int *nbNew=NULL);
+
+#endif // COMPARE_H
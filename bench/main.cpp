@@ -0,0 +1,455 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "compare.h"
+#include "check.h"
+#include "../mat4.h"
+#include "../quat.h"
+#include "../trackball.h"
+#include "../grid.h"
+#include "../meshLoader.h"
+#include "../transform.h"
+#include "../bvh.h"
+#include "../occlusion.h"
+#include "../meshlets.h"
+#include "../simplify.h"
+#include "../progressiveMesh.h"
+#include "../chunkedMesh.h"
+#include "../pointCloud.h"
+
+using namespace std;
+
+// write a bumpy square of about nbFaces triangles in the OFF format
+static bool writeSyntheticOff(const string &filename,unsigned long nbFaces) {
+  const unsigned long n = (unsigned long)ceil(sqrt((double)nbFaces/2.0));
+  const unsigned long nbVertices = (n+1)*(n+1);
+  FILE *file;
+
+  if((file=fopen(filename.c_str(),"w"))==NULL) {
+    printf("Unable to write %s\n",filename.c_str());
+    return false;
+  }
+
+  fprintf(file,"OFF\n%lu %lu 0\n",nbVertices,2*n*n);
+  for(unsigned long i=0;i<=n;++i) {
+    for(unsigned long j=0;j<=n;++j) {
+      const float x = (float)j/(float)n;
+      const float y = (float)i/(float)n;
+      fprintf(file,"%f %f %f\n",x,y,0.1f*sinf(20.0f*x)*cosf(20.0f*y));
+    }
+  }
+  for(unsigned long i=0;i<n;++i) {
+    for(unsigned long j=0;j<n;++j) {
+      const unsigned long v = i*(n+1)+j;
+      fprintf(file,"3 %lu %lu %lu\n",v,v+1,v+n+2);
+      fprintf(file,"3 %lu %lu %lu\n",v,v+n+2,v+n+1);
+    }
+  }
+
+  fclose(file);
+  return true;
+}
+
+static void benchMath(Benchmark &b) {
+  const Mat4f a = Quatf(Vec3f(1,2,3).normal(),0.3f).toMat4().translateEq(Vec3f(1,2,3));
+  const Mat4d ad(a);
+  Mat4f m = Mat4f::identity();
+  Mat4d md = Mat4d::identity();
+  Vec4f v(1,2,3,1);
+
+  b.run("mat4f_mul",[&]() { m = a*m; doNotOptimize(m); });
+  b.run("mat4d_mul",[&]() { md = ad*md; doNotOptimize(md); });
+  b.run("mat4f_mul_vec4",[&]() { v = a*v; doNotOptimize(v); });
+  b.run("mat4f_inverse",[&]() { m = m.inverse(); doNotOptimize(m); });
+  b.run("mat4d_inverse",[&]() { md = md.inverse(); doNotOptimize(md); });
+  b.run("mat4f_affine_inverse",[&]() { m = a.affineInverse()*m; doNotOptimize(m); });
+  b.run("mat4f_transpose",[&]() { m = m.transpose(); doNotOptimize(m); });
+  b.run("mat4d_transpose",[&]() { md = md.transpose(); doNotOptimize(md); });
+
+  float angle = 0.0f;
+  b.run("quatf_to_mat4",[&]() {
+      angle += 0.001f;
+      m = Quatf(Vec3f(0,1,0),angle).toMat4();
+      doNotOptimize(m);
+    });
+
+  TrackBall t(400.0f,Vec2f(400.0f,300.0f));
+  t.beginTracking(Vec2f(410.0f,290.0f));
+  float x = 0.0f;
+  b.run("trackball_track",[&]() {
+      x = x>100.0f ? 0.0f : x+0.5f;
+      Quatf q = t.track(Vec2f(420.0f+x,310.0f-x));
+      doNotOptimize(q);
+    });
+}
+
+static void benchTransform(Benchmark &b) {
+  // large enough to stream from memory
+  const size_t n = 10000000;
+  const char *names[] = {"transform_aos_10M","transform_soa_10M","frustum_mask_aos_10M","frustum_mask_soa_10M"};
+  bool any = false;
+
+  for(unsigned int i=0;i<4;++i)
+    any = any || b.selected(names[i]);
+  if(!any)
+    return;
+
+  const Mat4f mvp = Mat4f(1.5f,0,0,0, 0,2,0,0, 0,0,-1.02f,-0.2f, 0,0,-1,0)*
+    Quatf(Vec3f(1,2,3).normal(),0.3f).toMat4().translateEq(Vec3f(0,0,-3));
+
+  vector<float> xyz(3*n),x(n),y(n),z(n),out(4*n);
+  vector<uint8_t> mask((n+7)/8);
+  srand(1);
+  for(size_t i=0;i<n;++i) {
+    x[i] = xyz[3*i]   = 4.0f*rand()/RAND_MAX-2.0f;
+    y[i] = xyz[3*i+1] = 4.0f*rand()/RAND_MAX-2.0f;
+    z[i] = xyz[3*i+2] = 4.0f*rand()/RAND_MAX-2.0f;
+  }
+
+  printf("Transform: %s\n",Transform::simd() ? "AVX2" : "scalar");
+
+  b.run(names[0],[&]() { Transform::points(mvp,&xyz[0],&out[0],n); doNotOptimize(out[0]); },n);
+  b.run(names[1],[&]() {
+      Transform::points(mvp,&x[0],&y[0],&z[0],&out[0],&out[n],&out[2*n],&out[3*n],n);
+      doNotOptimize(out[0]);
+    },n);
+  b.run(names[2],[&]() { size_t v = Transform::frustumMask(mvp,&xyz[0],&mask[0],n); doNotOptimize(v); },n);
+  b.run(names[3],[&]() { size_t v = Transform::frustumMask(mvp,&x[0],&y[0],&z[0],&mask[0],n); doNotOptimize(v); },n);
+}
+
+static void benchCull(Benchmark &b) {
+  // as many spheres as the copies of tp03 (about a third in the frustum)
+  const unsigned int n = 65536;
+  const char *names[] = {"cull_bvh_64k","cull_brute_64k"};
+
+  if(!b.selected(names[0]) && !b.selected(names[1]))
+    return;
+
+  vector<Box> boxes(n);
+  srand(1);
+  for(unsigned int i=0;i<n;++i) {
+    const Vec3f c(6.0f*rand()/RAND_MAX-3.0f,6.0f*rand()/RAND_MAX-3.0f,0.0f);
+    boxes[i] = Box::sphere(c,0.02f+0.08f*rand()/RAND_MAX);
+  }
+
+  Bvh bvh;
+  bvh.build(boxes);
+
+  const Frustum f(Mat4f::perspective(45.0f,1.3f,0.05f,30.0f)*
+		  Mat4f::lookAt(Vec3f(1.0f,0.5f,-2.0f),Vec3f(2.0f,1.0f,0.0f),Vec3f(0.0f,1.0f,0.0f)));
+  vector<unsigned int> visible;
+  visible.reserve(n);
+
+  b.run(names[0],[&]() { visible.clear(); bvh.cull(f,visible); doNotOptimize(visible[0]); },n);
+  b.run(names[1],[&]() {
+      visible.clear();
+      for(unsigned int i=0;i<n;++i) {
+	if(f.classify(boxes[i])!=Frustum::OUTSIDE)
+	  visible.push_back(i);
+      }
+      doNotOptimize(visible[0]);
+    },n);
+}
+
+static void benchOcclusion(Benchmark &b) {
+  const char *names[] = {"occlusion_raster","occlusion_test_64k"};
+
+  if(!b.selected(names[0]) && !b.selected(names[1]))
+    return;
+
+  // 64 walls (thin boxes, 12 triangles each) in front of 64k spheres
+  Occlusion o;
+  srand(1);
+  const unsigned int quads[6][4] = {{0,1,3,2},{4,6,7,5},{0,4,5,1},{2,3,7,6},{0,2,6,4},{1,5,7,3}};
+  for(unsigned int k=0;k<64;++k) {
+    const Vec3f c(6.0f*rand()/RAND_MAX-3.0f,1.0f*rand()/RAND_MAX,2.0f*rand()/RAND_MAX-1.0f);
+    const Vec3f s(0.1f+0.4f*rand()/RAND_MAX,0.1f+0.4f*rand()/RAND_MAX,0.05f);
+    float        v[24];
+    unsigned int f[36];
+    for(unsigned int i=0;i<8;++i) {
+      v[3*i]   = c[0]+(i&1 ? s[0] : -s[0]);
+      v[3*i+1] = c[1]+(i&2 ? s[1] : -s[1]);
+      v[3*i+2] = c[2]+(i&4 ? s[2] : -s[2]);
+    }
+    for(unsigned int i=0;i<6;++i) {
+      const unsigned int t[6] = {0,1,2,0,2,3};
+      for(unsigned int j=0;j<6;++j)
+	f[6*i+j] = quads[i][t[j]];
+    }
+    o.addOccluder(v,8,f,12,Mat4f::identity());
+  }
+
+  const unsigned int n = 65536;
+  vector<Box> boxes(n);
+  for(unsigned int i=0;i<n;++i) {
+    const Vec3f c(6.0f*rand()/RAND_MAX-3.0f,0.0f,6.0f*rand()/RAND_MAX+1.0f);
+    boxes[i] = Box::sphere(c,0.02f+0.08f*rand()/RAND_MAX);
+  }
+
+  const Mat4f mvp = Mat4f::perspective(45.0f,2.0f,0.05f,30.0f)*
+    Mat4f::lookAt(Vec3f(0.0f,0.5f,-3.0f),Vec3f(0.0f,0.5f,0.0f),Vec3f(0.0f,1.0f,0.0f));
+
+  b.run(names[0],[&]() { o.render(mvp); doNotOptimize(o.depth()[0]); },o.w()*o.h());
+
+  o.render(mvp);
+  b.run(names[1],[&]() {
+      unsigned int visible = 0;
+      for(unsigned int i=0;i<n;++i)
+	visible += o.visible(boxes[i]);
+      doNotOptimize(visible);
+    },n);
+}
+
+// unit sphere of 2*rings*sectors triangles, counter clockwise from the outside
+static void sphere(unsigned int rings,unsigned int sectors,vector<float> &vertices,vector<unsigned int> &faces) {
+  for(unsigned int i=0;i<=rings;++i) {
+    for(unsigned int j=0;j<sectors;++j) {
+      const float t = M_PI*i/rings,p = 2.0f*M_PI*j/sectors;
+      vertices.push_back(sin(t)*cos(p));
+      vertices.push_back(sin(t)*sin(p));
+      vertices.push_back(cos(t));
+    }
+  }
+  for(unsigned int i=0;i<rings;++i) {
+    for(unsigned int j=0;j<sectors;++j) {
+      const unsigned int a = i*sectors+j,c = (i+1)*sectors+j;
+      const unsigned int b = i*sectors+(j+1)%sectors,d = (i+1)*sectors+(j+1)%sectors;
+      const unsigned int t[6] = {a,c,b,b,c,d};
+      faces.insert(faces.end(),t,t+6);
+    }
+  }
+}
+
+static void benchMeshlets(Benchmark &b) {
+  const char *names[] = {"meshlets_build_1m","meshlets_cull_1m"};
+
+  if(!b.selected(names[0]) && !b.selected(names[1]))
+    return;
+
+  vector<float>        vertices;
+  vector<unsigned int> faces;
+  sphere(500,1000,vertices,faces);
+  const unsigned int nbFaces = faces.size()/3;
+
+  Meshlets             meshlets;
+  vector<unsigned int> indices;
+  b.run(names[0],[&]() { meshlets.build(&vertices[0],vertices.size()/3,&faces[0],nbFaces,indices); doNotOptimize(indices[0]); },nbFaces);
+
+  meshlets.build(&vertices[0],vertices.size()/3,&faces[0],nbFaces,indices);
+  const Mat4f view = Mat4f::lookAt(Vec3f(0.0f,-0.5f,3.0f),Vec3f(0.0f,0.0f,0.0f),Vec3f(0.0f,1.0f,0.0f));
+  const Frustum f(Mat4f::perspective(45.0f,1.3f,0.1f,10.0f)*view);
+  vector<unsigned int> visible;
+  visible.reserve(meshlets.size());
+
+  b.run(names[1],[&]() {
+      visible.clear();
+      meshlets.cull(f,Vec3f(0.0f,-0.5f,3.0f),true,visible);
+      doNotOptimize(visible[0]);
+    },meshlets.size());
+}
+
+static void benchSimplify(Benchmark &b) {
+  const char *name = "simplify_lod_chain_200k";
+
+  if(!b.selected(name))
+    return;
+
+  vector<float>        vertices;
+  vector<unsigned int> faces;
+  sphere(200,500,vertices,faces);
+
+  LodChain             lods;
+  vector<unsigned int> indices;
+  b.run(name,[&]() { lods.build(&vertices[0],vertices.size()/3,&faces[0],faces.size()/3,indices); doNotOptimize(indices[0]); },faces.size()/3);
+}
+
+static void benchProgressive(Benchmark &b) {
+  const char *names[] = {"progressive_write_200k","progressive_open_200k"};
+
+  if(!b.selected(names[0]) && !b.selected(names[1]))
+    return;
+
+  vector<float>        vertices;
+  vector<unsigned int> faces;
+  sphere(200,500,vertices,faces);
+
+  const string       filename  = tmpFilename(names[0])+".pm";
+  const float        center[3] = {0.0f,0.0f,0.0f};
+  const unsigned int nbFaces   = faces.size()/3;
+  b.run(names[0],[&]() { doNotOptimize(ProgressiveMesh::write(filename,NULL,&vertices[0],vertices.size()/3,&faces[0],nbFaces,center,1.0f)); },nbFaces);
+
+  // time to the first frame: the base mesh only
+  if(ProgressiveMesh::write(filename,NULL,&vertices[0],vertices.size()/3,&faces[0],nbFaces,center,1.0f))
+    b.run(names[1],[&]() { ProgressiveMesh pm; doNotOptimize(pm.open(filename,NULL)); },nbFaces);
+  remove(filename.c_str());
+}
+
+static void benchChunked(Benchmark &b) {
+  const unsigned long nbFaces = 1000000;
+  const char         *names[] = {"chunked_convert_1M","chunked_open_1M"};
+
+  if(nbFaces>b.maxFaces() || (!b.selected(names[0]) && !b.selected(names[1])))
+    return;
+
+  const string offFilename = tmpFilename(names[0])+".off";
+  const string filename    = tmpFilename(names[0])+".ooc";
+  if(!writeSyntheticOff(offFilename,nbFaces))
+    return;
+
+  // the OFF file is parsed again each time: compare with mesh_load_1000000
+  b.run(names[0],[&]() { doNotOptimize(ChunkedMesh::convert(filename,offFilename.c_str())); },nbFaces);
+
+  // mapped, nothing is read
+  if(ChunkedMesh::convert(filename,offFilename.c_str()))
+    b.run(names[1],[&]() { ChunkedMesh m; doNotOptimize(m.open(filename,offFilename.c_str())); },nbFaces);
+  remove(filename.c_str());
+  remove(offFilename.c_str());
+}
+
+static void benchPointCloud(Benchmark &b) {
+  const unsigned int nbPoints = 1000000;
+  const char        *names[]  = {"pointcloud_build_1M","pointcloud_select_1M"};
+
+  if(!b.selected(names[0]) && !b.selected(names[1]))
+    return;
+
+  // noisy unit sphere
+  vector<float> points(3*nbPoints);
+  srand(1);
+  for(unsigned int i=0;i<nbPoints;++i) {
+    Vec3f p(2.0f*rand()/RAND_MAX-1.0f,2.0f*rand()/RAND_MAX-1.0f,2.0f*rand()/RAND_MAX-1.0f);
+    p = p*((1.0f+0.01f*rand()/RAND_MAX)/std::max(p.length(),1e-6f));
+    for(int k=0;k<3;++k)
+      points[3*i+k] = p[k];
+  }
+
+  b.run(names[0],[&]() { PointCloud c(&points[0],nbPoints); doNotOptimize(c.nbNodes()); },nbPoints);
+
+  // a 1080p view of half the sphere, 1M points at most
+  const PointCloud  c(&points[0],nbPoints);
+  const Mat4f       proj = Mat4f::perspective(45.0f,16.0f/9.0f,0.1f,10.0f);
+  const Frustum     f(proj*Mat4f::lookAt(Vec3f(0.0f,0.0f,2.0f),Vec3f(0.0f,0.0f,0.0f),Vec3f(0.0f,1.0f,0.0f)));
+  PointCloud::Queue queue;
+  vector<unsigned int> selected;
+  queue.reserve(c.nbNodes());
+  selected.reserve(c.nbNodes());
+
+  b.run(names[1],[&]() {
+      selected.clear();
+      doNotOptimize(c.select(f,Vec3f(0.0f,0.0f,2.0f),0.5f*1080.0f*proj(1,1),1.0f,0.1f,1000000,queue,selected));
+    },c.nbNodes());
+}
+
+static void benchGrid(Benchmark &b) {
+  const unsigned int sizes[] = {64,256,1024};
+
+  for(unsigned int i=0;i<sizeof(sizes)/sizeof(sizes[0]);++i) {
+    const unsigned int s = sizes[i];
+    char name[64];
+    snprintf(name,sizeof(name),"grid_%u",s);
+
+    b.run(name,[s]() { Grid g(s); doNotOptimize(g); },(unsigned long)s*s);
+  }
+}
+
+static void benchMesh(Benchmark &b) {
+  const unsigned long sizes[] = {1000,10000,100000,1000000,10000000};
+
+  for(unsigned int i=0;i<sizeof(sizes)/sizeof(sizes[0]);++i) {
+    const unsigned long f = sizes[i];
+    char name[64];
+    snprintf(name,sizeof(name),"mesh_load_%lu",f);
+
+    if(f>b.maxFaces() || !b.selected(name))
+      continue;
+
+    string filename = tmpFilename(name)+".off";
+    if(!writeSyntheticOff(filename,f))
+      continue;
+
+    b.run(name,[&filename]() { Mesh m(&filename[0]); doNotOptimize(m); },f);
+    remove(filename.c_str());
+  }
+}
+
+// bench --compare baseline.json current.json [--thresholds file] [--alpha a]
+static int compare(int argc,char **argv) {
+  vector<BenchmarkResult> baseline;
+  vector<BenchmarkResult> current;
+  Thresholds thresholds;
+  double alpha = 0.01;
+
+  for(int i=4;i<argc;++i) {
+    if(!strcmp(argv[i],"--thresholds") && i+1<argc) {
+      if(!thresholds.load(argv[++i]))
+        return 2;
+    } else if(!strcmp(argv[i],"--alpha") && i+1<argc) {
+      alpha = atof(argv[++i]);
+    } else {
+      printf("Unknown option %s\n",argv[i]);
+      return 2;
+    }
+  }
+
+  if(!readBenchmarkJson(argv[2],baseline) || !readBenchmarkJson(argv[3],current))
+    return 2;
+
+  unsigned int       nbNew         = 0;
+  const unsigned int nbRegressions = compareBenchmarks(baseline,current,thresholds,alpha,&nbNew);
+  if(nbRegressions>0) {
+    printf("%u significant regression(s) (alpha=%g)\n",nbRegressions,alpha);
+    return 1;
+  }
+
+  // not gated until the baselines are updated
+  if(nbNew>0) {
+    printf("%u benchmark(s) without a baseline (update the baselines)\n",nbNew);
+    return 1;
+  }
+
+  return 0;
+}
+
+int main(int argc,char **argv) {
+  Benchmark b;
+
+  if(argc>=4 && !strcmp(argv[1],"--compare"))
+    return compare(argc,argv);
+
+  // synthetic model for the frame benchmark of tp03
+  if(argc==4 && !strcmp(argv[1],"--write-off"))
+    return writeSyntheticOff(argv[3],strtoul(argv[2],NULL,10)) ? 0 : 1;
+
+  // SIMD against scalar results, progressive mesh replay
+  if(argc==2 && !strcmp(argv[1],"--check"))
+    return runChecks() ? 0 : 1;
+
+  if(!b.parseArgs(argc,argv))
+    return 1;
+
+  benchMath(b);
+  benchTransform(b);
+  benchCull(b);
+  benchOcclusion(b);
+  benchMeshlets(b);
+  benchSimplify(b);
+  benchProgressive(b);
+  benchChunked(b);
+  benchPointCloud(b);
+  benchGrid(b);
+  benchMesh(b);
+
+  // per-phase counters of the code instrumented with PERF_SCOPE
+  if(b.perf())
+    PerfReport::print();
+
+  if(!b.jsonFilename().empty() && !b.writeJson(b.jsonFilename().c_str()))
+    return 1;
+
+  return 0;
+}
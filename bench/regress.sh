@@ -0,0 +1,58 @@
+#!/bin/sh
+# Performance regression gate: runs the correctness checks, the
+# micro-benchmarks and the frame benchmark of tp03, then compares the
+# timings with the baselines committed in bench/baselines (one-sided
+# Mann-Whitney test + per-benchmark thresholds).
+#
+#   bench/regress.sh            compare, exit 1 on a significant slowdown
+#                               or on a benchmark without a baseline
+#   bench/regress.sh --update   replace the baselines with the new results
+#
+# environment: MAX_FACES (largest mesh_load case, default 1000000),
+#              FRAME_FACES (model of the frame benchmark, default 250000),
+#              FRAMES (number of timed frames, default 60)
+#
+# The baselines must come from the machine that runs the gate: create them
+# there with --update (the frame one is not committed).
+
+set -e
+cd "$(dirname "$0")"
+
+BASELINES=baselines
+RESULTS=results
+STATUS=0
+
+mkdir -p $RESULTS
+
+# micro-benchmarks (OFF loader, grid, math), after the correctness checks
+# of the optimized code (a failure stops the gate: the timings are moot)
+(qmake && make) > /dev/null
+./bench --check
+./bench --json $RESULTS/micro.json --max-faces ${MAX_FACES:-1000000}
+
+# frame benchmark: the model and the tiles (needs an OpenGL
+# 3.3 context, xvfb-run is used without display). Without the progressive
+# cache: every run draws the same levels of detail
+./bench --write-off ${FRAME_FACES:-250000} $RESULTS/frame_model.off
+(cd .. && qmake && make) > /dev/null
+RUN=""
+if [ -z "$DISPLAY" ]; then
+  RUN="xvfb-run -a"
+fi
+(cd .. && SIM_MESH_CACHE=0 $RUN ./tp03 bench/$RESULTS/frame_model.off --bench ${FRAMES:-60} bench/$RESULTS/frames.json)
+
+for suite in micro frames; do
+  if [ "$1" = "--update" ]; then
+    cp $RESULTS/$suite.json $BASELINES/$suite.json
+    echo "Updated $BASELINES/$suite.json"
+  elif [ ! -f $BASELINES/$suite.json ]; then
+    echo "No baseline for $suite (run with --update to create it)"
+    STATUS=1
+  else
+    echo
+    ./bench --compare $BASELINES/$suite.json $RESULTS/$suite.json \
+      --thresholds $BASELINES/thresholds.txt || STATUS=1
+  fi
+done
+
+exit $STATUS
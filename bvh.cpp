@@ -0,0 +1,179 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <math.h>
+
+#if !defined(SIM_NO_SIMD) && (defined(__SSE__) || defined(_M_X64))
+#include <immintrin.h>
+#define BVH_SSE 1
+#endif
+
+Frustum::Frustum(const Mat4f &m) {
+  // rows 3+0, 3-0, 3+1, 3-1, 3+2, 3-2 of the matrix
+  for(int i=0;i<6;++i) {
+    const int   r = i/2;
+    const float s = i%2==0 ? 1.0f : -1.0f;
+
+    for(int j=0;j<4;++j)
+      _p[j][i] = m(3,j)+s*m(r,j);
+  }
+
+  // pad with the first planes
+  for(int j=0;j<4;++j) {
+    _p[j][6] = _p[j][0];
+    _p[j][7] = _p[j][1];
+  }
+
+  for(int j=0;j<3;++j) {
+    for(int i=0;i<8;++i)
+      _p[4+j][i] = fabs(_p[j][i]);
+  }
+}
+
+int Frustum::classify(const Box &b) const {
+  const float cx = 0.5f*(b.min[0]+b.max[0]);
+  const float cy = 0.5f*(b.min[1]+b.max[1]);
+  const float cz = 0.5f*(b.min[2]+b.max[2]);
+  const float ex = 0.5f*(b.max[0]-b.min[0]);
+  const float ey = 0.5f*(b.max[1]-b.min[1]);
+  const float ez = 0.5f*(b.max[2]-b.min[2]);
+
+#ifdef BVH_SSE
+  // distance of the center to 4 planes, and projected extent of the box
+  int outside = 0,intersect = 0;
+  for(int i=0;i<8;i+=4) {
+    __m128 d = _mm_mul_ps(_mm_load_ps(&_p[0][i]),_mm_set1_ps(cx));
+    d = _mm_add_ps(d,_mm_mul_ps(_mm_load_ps(&_p[1][i]),_mm_set1_ps(cy)));
+    d = _mm_add_ps(d,_mm_mul_ps(_mm_load_ps(&_p[2][i]),_mm_set1_ps(cz)));
+    d = _mm_add_ps(d,_mm_load_ps(&_p[3][i]));
+
+    __m128 r = _mm_mul_ps(_mm_load_ps(&_p[4][i]),_mm_set1_ps(ex));
+    r = _mm_add_ps(r,_mm_mul_ps(_mm_load_ps(&_p[5][i]),_mm_set1_ps(ey)));
+    r = _mm_add_ps(r,_mm_mul_ps(_mm_load_ps(&_p[6][i]),_mm_set1_ps(ez)));
+
+    outside   |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(d,r),_mm_setzero_ps()));
+    intersect |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(d,r),_mm_setzero_ps()));
+  }
+#else
+  bool outside = false,intersect = false;
+  for(int i=0;i<6;++i) {
+    const float d = _p[0][i]*cx + _p[1][i]*cy + _p[2][i]*cz + _p[3][i];
+    const float r = _p[4][i]*ex + _p[5][i]*ey + _p[6][i]*ez;
+
+    outside   = outside   || d+r<0.0f;
+    intersect = intersect || d-r<0.0f;
+  }
+#endif
+
+  if(outside)
+    return OUTSIDE;
+  return intersect ? INTERSECT : INSIDE;
+}
+
+void Bvh::build(const std::vector<Box> &boxes) {
+  _boxes = boxes;
+  _nodes.clear();
+  _items.resize(boxes.size());
+  for(unsigned int i=0;i<_items.size();++i)
+    _items[i] = i;
+
+  if(!_items.empty()) {
+    _nodes.reserve(2*_items.size());
+    build(boxes,0,_items.size());
+  }
+}
+
+namespace {
+
+  // order of the items along one axis (centers of their boxes)
+  struct CenterLess {
+    const std::vector<Box> *boxes;
+    int                     axis;
+
+    inline bool operator()(unsigned int a,unsigned int b) const {
+      const Box &ba = (*boxes)[a];
+      const Box &bb = (*boxes)[b];
+      return ba.min[axis]+ba.max[axis] < bb.min[axis]+bb.max[axis];
+    }
+  };
+
+}
+
+unsigned int Bvh::build(const std::vector<Box> &boxes,unsigned int first,unsigned int count) {
+  const unsigned int n = _nodes.size();
+  _nodes.push_back(Node());
+
+  // bounds of the items
+  Box b = boxes[_items[first]];
+  for(unsigned int i=first+1;i<first+count;++i) {
+    const Box &c = boxes[_items[i]];
+    for(int k=0;k<3;++k) {
+      b.min[k] = std::min(b.min[k],c.min[k]);
+      b.max[k] = std::max(b.max[k],c.max[k]);
+    }
+  }
+  _nodes[n].box = b;
+
+  if(count<=4) {
+    _nodes[n].first = first;
+    _nodes[n].count = count;
+    return n;
+  }
+
+  // median of the largest axis
+  const Vec3f size = b.max-b.min;
+  CenterLess less;
+  less.boxes = &boxes;
+  less.axis  = size[0]>size[1] ? (size[0]>size[2] ? 0 : 2) : (size[1]>size[2] ? 1 : 2);
+
+  const unsigned int half = count/2;
+  std::nth_element(_items.begin()+first,_items.begin()+first+half,_items.begin()+first+count,less);
+
+  build(boxes,first,half);
+  const unsigned int right = build(boxes,first+half,count-half);
+  _nodes[n].first = right;
+  _nodes[n].count = 0;
+  return n;
+}
+
+void Bvh::cull(const Frustum &f,std::vector<unsigned int> &visible) const {
+  if(!_nodes.empty())
+    cull(f,0,visible);
+}
+
+void Bvh::cull(const Frustum &f,unsigned int node,std::vector<unsigned int> &visible) const {
+  const Node &n = _nodes[node];
+  const int   c = f.classify(n.box);
+
+  if(c==Frustum::OUTSIDE)
+    return;
+
+  if(c==Frustum::INSIDE) {
+    add(node,visible);
+    return;
+  }
+
+  if(n.count==0) {
+    cull(f,node+1,visible);
+    cull(f,n.first,visible);
+    return;
+  }
+
+  for(unsigned int i=n.first;i<n.first+n.count;++i) {
+    if(f.classify(_boxes[_items[i]])!=Frustum::OUTSIDE)
+      visible.push_back(_items[i]);
+  }
+}
+
+void Bvh::add(unsigned int node,std::vector<unsigned int> &visible) const {
+  const Node &n = _nodes[node];
+
+  if(n.count==0) {
+    add(node+1,visible);
+    add(n.first,visible);
+    return;
+  }
+
+  for(unsigned int i=n.first;i<n.first+n.count;++i)
+    visible.push_back(_items[i]);
+}
@@ -0,0 +1,69 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include "vec3.h"
+#include "mat4.h"
+
+// axis aligned bounding box
+struct Box {
+  Vec3f min;
+  Vec3f max;
+
+  // box around a bounding sphere
+  static inline Box sphere(const Vec3f &c,float r) {
+    Box b;
+    b.min = c-Vec3f(r,r,r);
+    b.max = c+Vec3f(r,r,r);
+    return b;
+  }
+};
+
+// the 6 planes of the frustum of a projection*modelview matrix (Gribb and
+// Hartmann): a point is inside all of them if -w<=x,y,z<=w in clip space.
+// The boxes are tested against 4 planes at once with SSE (2 planes are
+// repeated to fill the second register), scalar code otherwise
+class Frustum {
+ public:
+  Frustum(const Mat4f &m);
+
+  enum {OUTSIDE=-1, INTERSECT=0, INSIDE=1};
+  int classify(const Box &b) const;
+
+ private:
+  // plane i: _p[0][i]*x + _p[1][i]*y + _p[2][i]*z + _p[3][i] >= 0,
+  // with |a|,|b|,|c| in _p[4.. 6] for the extents of the boxes
+  alignas(16) float _p[7][8];
+};
+
+// bounding volume hierarchy over the boxes of the items of a scene (objects,
+// terrain chunks...): binary tree, split at the median of the largest axis
+// of the centers, up to 4 items per leaf. Culling skips whole subtrees
+// outside the frustum, and stops testing inside it
+class Bvh {
+ public:
+  void build(const std::vector<Box> &boxes);
+
+  // appends the indices of the items whose box is not outside (visible is
+  // not cleared, and does not reallocate once its capacity is size())
+  void cull(const Frustum &f,std::vector<unsigned int> &visible) const;
+
+  inline unsigned int size() const {return _items.size();}
+
+ private:
+  struct Node {
+    Box          box;
+    unsigned int first; // in _items (leaf) or right child (inner node, left child is the next one)
+    unsigned int count; // 0 for an inner node
+  };
+
+  unsigned int build(const std::vector<Box> &boxes,unsigned int first,unsigned int count);
+  void cull(const Frustum &f,unsigned int node,std::vector<unsigned int> &visible) const;
+  void add(unsigned int node,std::vector<unsigned int> &visible) const;
+
+  std::vector<Node>         _nodes;
+  std::vector<unsigned int> _items;
+  std::vector<Box>          _boxes; // of the items
+};
+
+#endif // BVH_H
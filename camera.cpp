@@ -1,11 +1,11 @@
 #include "camera.h"
 
-Camera::Camera(float radius,const glm::vec3 &center,int mode) 
+Camera::Camera(float radius,const Vec3d &center,int mode) 
   : _m(NONE),
     _w(0), 
     _h(0), 
     _p(0,0),
-    _c(glmToVec3(center)),
+    _c(center),
     _r(radius),
     _t(),
     _f(45.0f),
@@ -14,7 +14,8 @@ Camera::Camera(float radius,const glm::vec3 &center,int mode)
     _right(0,0,0),
     _view(0,0,0),
     _zmin(0),
-    _zmax(0) {
+    _zmax(0),
+    _eye(center) {
 
 }
 
@@ -35,22 +36,21 @@ void Camera::initialize(int w,int h,bool replace) {
   
   // projection transformations  
   if(_d==PERSP) {
-    _matp = glmToMat4(glm::perspective(_f,(float)_w/(float)_h,_r/tmp1,_r*tmp1));
+    _matp = Mat4f::perspective(_f,(float)_w/(float)_h,_r/tmp1,_r*tmp1);
   } else {
-    _matp = glmToMat4(glm::ortho((float)(-_w),(float)_w,(float)(-_h),(float)_h,0.0f,_r*100.0f));
+    _matp = Mat4f::ortho((float)(-_w),(float)_w,(float)(-_h),(float)_h,0.0f,_r*100.0f);
   }
   
   if(!replace)
     return;
 
   // camera transformations
-  _matm = glmToMat4(glm::lookAt(glm::vec3(_c[0],_c[1],_c[2]-tmp2*_r),
-				glm::vec3(_c[0],_c[1],_c[2]),
-				glm::vec3(0.0,1.0,0.0)));
+  _matm = Mat4d::lookAt(Vec3d(_c[0],_c[1],_c[2]-tmp2*_r),_c,Vec3d(0.0,1.0,0.0));
 
   // update params 
   updateCamVectors(_matm);
   updateCamDists(_matm);
+  updateCamRelative(_matm);
 }
 
 void Camera::setFovy(float f) {
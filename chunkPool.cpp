@@ -0,0 +1,169 @@
+#include "chunkPool.h"
+
+#include <algorithm>
+
+ChunkPool::ChunkPool(MeshArena *arena,GLsizeiptr bytes)
+  : _arena(arena),
+    _frame(1),
+    _full(false) {
+  const GLsizeiptr   slotSize = ChunkedMesh::MAX_VERTICES*3*sizeof(float)+3*ChunkedMesh::MAX_TRIANGLES*sizeof(GLuint);
+  const unsigned int nbSlots  = std::max(bytes/slotSize,(GLsizeiptr)1);
+  const Slot         free     = {-1,0,0};
+
+  _range = _arena->add(NULL,nbSlots*ChunkedMesh::MAX_VERTICES,NULL,nbSlots*3*ChunkedMesh::MAX_TRIANGLES);
+  _slots.assign(nbSlots,free);
+}
+
+ChunkPool::~ChunkPool() {
+  _arena->remove(_range);
+}
+
+void ChunkPool::add(unsigned int mesh,const ChunkedMesh *chunks) {
+  const State none = {-1,0};
+  if(_meshes.size()<=mesh) {
+    _meshes.resize(mesh+1,NULL);
+    _states.resize(mesh+1);
+  }
+  _meshes[mesh] = chunks;
+  _states[mesh].assign(chunks->nbChunks(),none);
+
+  // every chunk is requested at most once per frame
+  unsigned int nbChunks = 0;
+  for(unsigned int i=0;i<_meshes.size();++i)
+    nbChunks += _meshes[i] ? _meshes[i]->nbChunks() : 0;
+  _requests.reserve(nbChunks);
+}
+
+void ChunkPool::beginFrame() {
+  _frame++;
+  _requests.clear();
+  _full = false;
+}
+
+void ChunkPool::cull(unsigned int mesh,const Frustum &f,const Frustum &predicted,const Vec3f &eye,std::vector<Draw> &draws) {
+  if(mesh>=_meshes.size() || _meshes[mesh]==NULL)
+    return;
+
+  cull(mesh,0,f,eye,false,&draws);
+  cull(mesh,0,predicted,eye,true,NULL);
+}
+
+void ChunkPool::cull(unsigned int mesh,unsigned int node,const Frustum &f,const Vec3f &eye,bool prefetched,std::vector<Draw> *draws) {
+  const ChunkedMesh       &m = *_meshes[mesh];
+  const ChunkedMesh::Node &n = m.node(node);
+  if(f.classify(ChunkedMesh::box(n.min,n.max))==Frustum::OUTSIDE)
+    return;
+
+  for(unsigned int i=0;i<n.nbChildren;++i)
+    cull(mesh,n.firstChild+i,f,eye,prefetched,draws);
+
+  for(unsigned int i=n.firstChunk;i<n.firstChunk+n.nbChunks;++i) {
+    const ChunkedMesh::Chunk &c = m.chunk(i);
+    State                    &s = _states[mesh][i];
+    if(n.nbChunks>1 && f.classify(ChunkedMesh::box(c.min,c.max))==Frustum::OUTSIDE)
+      continue;
+
+    // in a slot: drawn (the predicted ones only stay there)
+    if(s.slot>=0) {
+      Slot &slot = _slots[s.slot];
+      if(draws) {
+	const Draw d = {_range.firstIndex+s.slot*3*ChunkedMesh::MAX_TRIANGLES,c.nbIndices,
+			(GLint)(_range.baseVertex+s.slot*ChunkedMesh::MAX_VERTICES)};
+	draws->push_back(d);
+	slot.lastUsed = _frame;
+      }
+      continue;
+    }
+
+    // requested once per frame, at the distance of its box
+    if(s.requested==_frame)
+      continue;
+    s.requested = _frame;
+
+    Vec3f d;
+    for(int k=0;k<3;++k)
+      d[k] = std::max(std::max(c.min[k]-eye[k],eye[k]-c.max[k]),0.0f);
+    const Request r = {prefetched,d.length(),mesh,i};
+    if(_requests.size()<_requests.capacity())
+      _requests.push_back(r);
+  }
+}
+
+int ChunkPool::slot(bool prefetched) const {
+  // a free one, or the least recently drawn: never one drawn in this
+  // frame, nor in the last frames for a prefetched chunk
+  int best = -1;
+  for(unsigned int i=0;i<_slots.size();++i) {
+    const Slot &s = _slots[i];
+    if(s.mesh<0)
+      return i;
+    if(s.lastUsed+(prefetched ? PREFETCH_KEEP : 0)>=_frame)
+      continue;
+    if(best<0 || s.lastUsed<_slots[best].lastUsed)
+      best = i;
+  }
+  return best;
+}
+
+bool ChunkPool::update(GLsizeiptr &budget) {
+  if(_requests.empty())
+    return false;
+
+  // the visible ones, then the prefetched ones, nearest first
+  std::sort(_requests.begin(),_requests.end());
+
+  const GLsizeiptr total   = budget;
+  bool             changed = false;
+  unsigned int     done    = 0;
+  for(;done<_requests.size();++done) {
+    const Request            &r = _requests[done];
+    const ChunkedMesh        &m = *_meshes[r.mesh];
+    const ChunkedMesh::Chunk &c = m.chunk(r.chunk);
+    State                    &s = _states[r.mesh][r.chunk];
+    if(s.slot>=0)
+      continue;
+
+    const GLsizeiptr size = c.nbVertices*3*sizeof(float)+c.nbIndices*sizeof(GLuint);
+    if(size>budget)
+      break;
+
+    const int i = slot(r.prefetched);
+    if(i<0) {
+      _full = true;
+      break;
+    }
+
+    // evicted
+    Slot &slot = _slots[i];
+    if(slot.mesh>=0)
+      _states[slot.mesh][slot.chunk].slot = -1;
+
+    // uploaded, then dropped from the memory (the file is still mapped)
+    _arena->update(_range,i*ChunkedMesh::MAX_VERTICES,m.vertices(r.chunk),c.nbVertices,
+		   i*3*ChunkedMesh::MAX_TRIANGLES,m.indices(r.chunk),c.nbIndices);
+    m.release(r.chunk);
+
+    slot.mesh     = r.mesh;
+    slot.chunk    = r.chunk;
+    slot.lastUsed = _frame; // not evicted by the next requests
+    s.slot        = i;
+    budget       -= size;
+    changed       = true;
+  }
+  _requests.erase(_requests.begin(),_requests.begin()+done);
+
+  // the next ones are read from the disk meanwhile
+  GLsizeiptr next = 0;
+  for(unsigned int i=0;i<_requests.size() && next<total;++i) {
+    const ChunkedMesh        &m = *_meshes[_requests[i].mesh];
+    const ChunkedMesh::Chunk &c = m.chunk(_requests[i].chunk);
+    m.prefetch(_requests[i].chunk);
+    next += c.nbVertices*3*sizeof(float)+c.nbIndices*sizeof(GLuint);
+  }
+
+  return changed;
+}
+
+bool ChunkPool::pending() const {
+  return !_requests.empty() && !_full;
+}
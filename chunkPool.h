@@ -0,0 +1,87 @@
+#ifndef CHUNK_POOL_H
+#define CHUNK_POOL_H
+
+#include <vector>
+#include "meshArena.h"
+#include "chunkedMesh.h"
+
+// the chunks of the out-of-core meshes on the GPU: a range of fixed size
+// in the arena, cut in slots of ChunkedMesh::MAX_VERTICES vertices and
+// 3*MAX_TRIANGLES indices, drawn with the other meshes.
+//
+// Each frame, cull() walks the octree of the visible objects: the chunks
+// in the frustum that are in a slot are drawn, the others are requested,
+// nearest first. The ones that will enter the frustum if the camera keeps
+// moving (same frustum, moved by the motion of the last frame over a few
+// frames) are requested too, after them. Between the frames, update()
+// uploads the requests into free slots, or the least recently drawn ones,
+// and asks the system to read the next ones from the disk.
+class ChunkPool {
+ public:
+  // absolute in the arena
+  struct Draw {
+    GLuint firstIndex;
+    GLuint nbIndices;
+    GLint  baseVertex;
+  };
+
+  // bytes: of the pool, in the arena
+  ChunkPool(MeshArena *arena,GLsizeiptr bytes);
+  ~ChunkPool();
+
+  // chunks of mesh (not owned), outside the frames: allocates
+  void add(unsigned int mesh,const ChunkedMesh *chunks);
+
+  // frame: clears the requests, then for each object: appends the
+  // resident chunks of mesh in f (mesh -> clip space) to draws, and
+  // requests the others and the ones in predicted. eye: in mesh space
+  void beginFrame();
+  void cull(unsigned int mesh,const Frustum &f,const Frustum &predicted,const Vec3f &eye,std::vector<Draw> &draws);
+
+  // uploads the requests, at most budget bytes. True if a chunk was
+  // uploaded (the frame changes)
+  bool update(GLsizeiptr &budget);
+  // requests that update() can still serve
+  bool pending() const;
+
+  inline unsigned int nbSlots() const {return _slots.size();}
+
+ private:
+  enum {PREFETCH_KEEP=30}; // frames a drawn chunk is kept for the prefetched ones
+
+  struct Slot {
+    int          mesh;  // -1: free
+    unsigned int chunk;
+    unsigned int lastUsed;
+  };
+
+  struct State {
+    int          slot;      // -1: not resident
+    unsigned int requested; // last frame
+  };
+
+  struct Request {
+    bool         prefetched; // after all the visible ones
+    float        distance;
+    unsigned int mesh;
+    unsigned int chunk;
+
+    inline bool operator<(const Request &r) const {
+      return prefetched!=r.prefetched ? r.prefetched : distance<r.distance;
+    }
+  };
+
+  void cull(unsigned int mesh,unsigned int node,const Frustum &f,const Vec3f &eye,bool prefetched,std::vector<Draw> *draws);
+  int  slot(bool prefetched) const;
+
+  MeshArena                         *_arena;
+  MeshArena::Range                   _range;
+  std::vector<Slot>                  _slots;
+  std::vector<const ChunkedMesh *>   _meshes; // NULL if in the arena
+  std::vector<std::vector<State> >   _states; // per mesh and per chunk
+  std::vector<Request>               _requests;
+  unsigned int                       _frame;
+  bool                               _full;   // no slot left for the requests
+};
+
+#endif // CHUNK_POOL_H
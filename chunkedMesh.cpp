@@ -0,0 +1,424 @@
+#include "chunkedMesh.h"
+#include "progressiveMesh.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// 2^GRID_LEVELS cells per axis
+enum {GRID_LEVELS=7, NB_CELLS=1<<(3*GRID_LEVELS)};
+
+// cell of a point of [0,1)^3: its coordinates on 7 bits, interleaved
+static uint32_t morton(float x,float y,float z) {
+  const float    n = (float)(1<<GRID_LEVELS);
+  const uint32_t c[3] = {(uint32_t)std::min(std::max(x*n,0.0f),n-1.0f),
+			 (uint32_t)std::min(std::max(y*n,0.0f),n-1.0f),
+			 (uint32_t)std::min(std::max(z*n,0.0f),n-1.0f)};
+  uint32_t m = 0;
+  for(unsigned int b=0;b<GRID_LEVELS;++b) {
+    for(unsigned int k=0;k<3;++k)
+      m |= ((c[k]>>b)&1)<<(3*b+k);
+  }
+  return m;
+}
+
+// file of size bytes (at least 1), mapped read/write: the system keeps
+// in memory the parts in use. Unlinked at once, it disappears with the
+// mapping
+static void *mapTemporary(const std::string &filename,size_t size) {
+  const int fd = ::open(filename.c_str(),O_RDWR|O_CREAT|O_TRUNC,0600);
+  if(fd<0) {
+    printf("Unable to write %s\n",filename.c_str());
+    return NULL;
+  }
+  unlink(filename.c_str());
+
+  void *p = ftruncate(fd,size)==0 ? mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0) : MAP_FAILED;
+  close(fd);
+  if(p==MAP_FAILED) {
+    printf("Unable to map %s\n",filename.c_str());
+    return NULL;
+  }
+  return p;
+}
+
+// the chunks of the triangles of the leaves, written in out
+class ChunkWriter {
+ public:
+  ChunkWriter(FILE *out,uint64_t offset,const float *positions,const uint32_t *triangles,const uint32_t *start)
+    : _out(out),
+      _offset(offset),
+      _positions(positions),
+      _triangles(triangles),
+      _start(start) {
+    _local.reserve(2*ChunkedMesh::MAX_VERTICES);
+    _vertices.reserve(3*ChunkedMesh::MAX_VERTICES);
+    _indices.reserve(3*ChunkedMesh::MAX_TRIANGLES);
+  }
+
+  // node and its subtree: the cells [cell,cell+8^(GRID_LEVELS-level))
+  bool build(unsigned int node,unsigned int level,uint32_t cell);
+
+  std::vector<ChunkedMesh::Node>  nodes;
+  std::vector<ChunkedMesh::Chunk> chunks;
+  uint64_t                        offset() const {return _offset;}
+
+ private:
+  bool leaf(unsigned int node,uint32_t first,uint32_t last);
+  bool flush();
+  static void grow(float *min,float *max,const float *bmin,const float *bmax);
+
+  FILE           *_out;
+  uint64_t        _offset;
+  const float    *_positions;
+  const uint32_t *_triangles; // sorted by cell
+  const uint32_t *_start;     // first triangle of each cell
+
+  std::unordered_map<uint32_t,uint32_t> _local; // vertex of the OFF file -> of the chunk
+  std::vector<float>                    _vertices;
+  std::vector<uint32_t>                 _indices;
+};
+
+void ChunkWriter::grow(float *min,float *max,const float *bmin,const float *bmax) {
+  for(int k=0;k<3;++k) {
+    min[k] = std::min(min[k],bmin[k]);
+    max[k] = std::max(max[k],bmax[k]);
+  }
+}
+
+bool ChunkWriter::build(unsigned int node,unsigned int level,uint32_t cell) {
+  const uint32_t size  = 1u<<(3*(GRID_LEVELS-level));
+  const uint32_t first = _start[cell],last = _start[cell+size];
+
+  for(int k=0;k<3;++k) {
+    nodes[node].min[k] =  HUGE_VALF;
+    nodes[node].max[k] = -HUGE_VALF;
+  }
+
+  if(last-first<=ChunkedMesh::MAX_TRIANGLES || level==GRID_LEVELS)
+    return leaf(node,first,last);
+
+  // the children that have triangles, consecutive
+  const uint32_t sub = size/8;
+  unsigned int   children[8];
+  unsigned int   n = 0;
+  for(unsigned int c=0;c<8;++c) {
+    if(_start[cell+(c+1)*sub]>_start[cell+c*sub])
+      children[n++] = c;
+  }
+
+  const unsigned int firstChild = nodes.size();
+  ChunkedMesh::Node  empty;
+  memset(&empty,0,sizeof(empty));
+  nodes[node].firstChild = firstChild;
+  nodes[node].nbChildren = n;
+  nodes.resize(firstChild+n,empty);
+  for(unsigned int i=0;i<n;++i) {
+    if(!build(firstChild+i,level+1,cell+children[i]*sub))
+      return false;
+    grow(nodes[node].min,nodes[node].max,nodes[firstChild+i].min,nodes[firstChild+i].max);
+  }
+  return true;
+}
+
+bool ChunkWriter::leaf(unsigned int node,uint32_t first,uint32_t last) {
+  nodes[node].firstChunk = chunks.size();
+
+  // greedy: the triangles in the order of their cells, until a chunk is full
+  for(uint32_t t=first;t<last;++t) {
+    const uint32_t *p = &_triangles[3*(size_t)t];
+    unsigned int    added = 0;
+    for(int k=0;k<3;++k)
+      added += _local.count(p[k])==0;
+
+    if(_indices.size()+3>3*ChunkedMesh::MAX_TRIANGLES || _vertices.size()/3+added>ChunkedMesh::MAX_VERTICES) {
+      if(!flush())
+	return false;
+    }
+
+    for(int k=0;k<3;++k) {
+      std::unordered_map<uint32_t,uint32_t>::iterator it = _local.find(p[k]);
+      if(it==_local.end()) {
+	it = _local.insert(std::make_pair(p[k],(uint32_t)(_vertices.size()/3))).first;
+	_vertices.insert(_vertices.end(),&_positions[3*(size_t)p[k]],&_positions[3*(size_t)p[k]+3]);
+      }
+      _indices.push_back(it->second);
+    }
+  }
+  if(!_indices.empty() && !flush())
+    return false;
+
+  nodes[node].nbChunks = chunks.size()-nodes[node].firstChunk;
+  for(unsigned int i=nodes[node].firstChunk;i<chunks.size();++i)
+    grow(nodes[node].min,nodes[node].max,chunks[i].min,chunks[i].max);
+  return true;
+}
+
+bool ChunkWriter::flush() {
+  ChunkedMesh::Chunk c;
+  c.offset     = _offset;
+  c.nbVertices = _vertices.size()/3;
+  c.nbIndices  = _indices.size();
+  for(int k=0;k<3;++k) {
+    c.min[k] =  HUGE_VALF;
+    c.max[k] = -HUGE_VALF;
+  }
+  for(unsigned int i=0;i<c.nbVertices;++i)
+    grow(c.min,c.max,&_vertices[3*i],&_vertices[3*i]);
+
+  if(fwrite(_vertices.data(),sizeof(float),_vertices.size(),_out)!=_vertices.size() ||
+     fwrite(_indices.data(),sizeof(uint32_t),_indices.size(),_out)!=_indices.size())
+    return false;
+
+  _offset += _vertices.size()*sizeof(float)+_indices.size()*sizeof(uint32_t);
+  chunks.push_back(c);
+  _local.clear();
+  _vertices.clear();
+  _indices.clear();
+  return true;
+}
+
+ChunkedMesh::ChunkedMesh()
+  : _data(NULL),
+    _size(0),
+    _header(NULL),
+    _nodes(NULL),
+    _chunks(NULL) {
+}
+
+ChunkedMesh::~ChunkedMesh() {
+  if(_data)
+    munmap((void *)_data,_size);
+}
+
+bool ChunkedMesh::outOfCore(const char *offFilename) {
+  uint64_t size;
+  int64_t  time;
+  if(!ProgressiveMesh::offStat(offFilename,size,time))
+    return false;
+
+  const char  *env   = getenv("SIM_OUT_OF_CORE");
+  const double limit = env && env[0] ? atof(env)*1048576.0 : 0.25*sysconf(_SC_PHYS_PAGES)*(double)sysconf(_SC_PAGESIZE);
+  return size>=limit;
+}
+
+bool ChunkedMesh::convert(const std::string &filename,const char *offFilename,std::atomic<float> *progress,
+			  const std::atomic<bool> *cancel) {
+  TRACE_SCOPE("ChunkedMesh::convert");
+
+  Header h;
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,"OC01",4);
+  if(!ProgressiveMesh::offStat(offFilename,h.offSize,h.offTime))
+    return false;
+
+  setlocale(LC_ALL,"C");
+
+  FILE *file = fopen(offFilename,"r");
+  if(file==NULL) {
+    printf("Unable to read %s\n",offFilename);
+    return false;
+  }
+
+  long size = 0;
+  if(fseek(file,0,SEEK_END)==0) {
+    size = ftell(file);
+    rewind(file);
+  }
+
+  unsigned int tmp;
+  if(fscanf(file,"OFF\n%u %u %u\n",&h.nbVertices,&h.nbTriangles,&tmp)!=3) {
+    printf("Unable to read %s\n",offFilename);
+    fclose(file);
+    return false;
+  }
+
+  // faces: 3 vertices and a cell each
+  const size_t positionsSize = std::max((size_t)h.nbVertices*3*sizeof(float),(size_t)1);
+  const size_t facesSize     = std::max((size_t)h.nbTriangles*4*sizeof(uint32_t),(size_t)1);
+  const size_t trianglesSize = std::max((size_t)h.nbTriangles*3*sizeof(uint32_t),(size_t)1);
+  float    *positions = (float *)mapTemporary(filename+".vertices",positionsSize);
+  uint32_t *faces     = (uint32_t *)mapTemporary(filename+".faces",facesSize);
+  if(positions==NULL || faces==NULL) {
+    if(positions)
+      munmap(positions,positionsSize);
+    if(faces)
+      munmap(faces,facesSize);
+    fclose(file);
+    return false;
+  }
+
+  // positions, bounding box and center (in double: the files are large)
+  float  min[3] = { HUGE_VALF, HUGE_VALF, HUGE_VALF};
+  float  max[3] = {-HUGE_VALF,-HUGE_VALF,-HUGE_VALF};
+  double c[3]   = {0.0,0.0,0.0};
+  bool   stop   = false;
+  for(unsigned int i=0;i<h.nbVertices && !stop;++i) {
+    float *v = &positions[3*(size_t)i];
+    if(fscanf(file,"%f %f %f\n",&v[0],&v[1],&v[2])!=3) {
+      printf("Unable to read vertices of %s\n",offFilename);
+      v[0] = v[1] = v[2] = 0.0f;
+    }
+    for(int k=0;k<3;++k) {
+      min[k] = std::min(min[k],v[k]);
+      max[k] = std::max(max[k],v[k]);
+      c[k]  += v[k];
+    }
+
+    if(progress && size>0 && (i&0xffff)==0)
+      progress->store((float)ftell(file)/size);
+    stop = cancel && (i&0xffff)==0 && cancel->load();
+  }
+  for(int k=0;k<3;++k)
+    h.center[k] = h.nbVertices>0 ? (float)(c[k]/h.nbVertices) : 0.0f;
+  for(unsigned int i=0;i<h.nbVertices;++i) {
+    const float *v = &positions[3*(size_t)i];
+    const float  d = sqrtf((v[0]-h.center[0])*(v[0]-h.center[0])+(v[1]-h.center[1])*(v[1]-h.center[1])+(v[2]-h.center[2])*(v[2]-h.center[2]));
+    h.radius = std::max(h.radius,d);
+  }
+
+  // faces and the cell of their centroid (NB_CELLS: not a valid triangle)
+  float scale[3];
+  for(int k=0;k<3;++k)
+    scale[k] = max[k]>min[k] ? 1.0f/(max[k]-min[k]) : 0.0f;
+
+  std::vector<uint32_t> start(NB_CELLS+2,0);
+  for(unsigned int i=0;i<h.nbTriangles && !stop;++i) {
+    uint32_t *f = &faces[4*(size_t)i];
+    if(fscanf(file,"%u %u %u %u\n",&tmp,&f[0],&f[1],&f[2])!=4)
+      printf("Unable to read faces of %s\n",offFilename);
+
+    if(tmp!=3 || f[0]>=h.nbVertices || f[1]>=h.nbVertices || f[2]>=h.nbVertices) {
+      f[3] = NB_CELLS;
+    } else {
+      const float *v[3] = {&positions[3*(size_t)f[0]],&positions[3*(size_t)f[1]],&positions[3*(size_t)f[2]]};
+      f[3] = morton(((v[0][0]+v[1][0]+v[2][0])/3.0f-min[0])*scale[0],
+		    ((v[0][1]+v[1][1]+v[2][1])/3.0f-min[1])*scale[1],
+		    ((v[0][2]+v[1][2]+v[2][2])/3.0f-min[2])*scale[2]);
+    }
+    start[f[3]+1]++;
+
+    if(progress && size>0 && (i&0xffff)==0)
+      progress->store((float)ftell(file)/size);
+    stop = cancel && (i&0xffff)==0 && cancel->load();
+  }
+  fclose(file);
+
+  // sorted by cell (counting sort): start[cell] is its first triangle
+  for(unsigned int i=0;i<=NB_CELLS;++i)
+    start[i+1] += start[i];
+
+  uint32_t *triangles = stop ? NULL : (uint32_t *)mapTemporary(filename+".triangles",trianglesSize);
+  bool      ok        = triangles!=NULL;
+  if(ok) {
+    std::vector<uint32_t> next(start.begin(),start.end()-1);
+    for(unsigned int i=0;i<h.nbTriangles;++i) {
+      const uint32_t *f = &faces[4*(size_t)i];
+      memcpy(&triangles[3*(size_t)next[f[3]]++],f,3*sizeof(uint32_t));
+    }
+  }
+  munmap(faces,facesSize);
+
+  // the chunks, then the tables (chunks aligned for their 64 bits offsets)
+  const std::string tmpFilename = filename+".tmp";
+  FILE             *out         = ok ? fopen(tmpFilename.c_str(),"wb") : NULL;
+  if(out) {
+    ChunkWriter w(out,sizeof(h),positions,triangles,&start[0]);
+    w.nodes.resize(1);
+    memset(&w.nodes[0],0,sizeof(Node));
+
+    ok = fwrite(&h,sizeof(h),1,out)==1 && w.build(0,0,0);
+    if(ok) {
+      // an empty mesh is a point
+      Node &root = w.nodes[0];
+      if(root.min[0]>root.max[0]) {
+	memcpy(root.min,h.center,sizeof(root.min));
+	memcpy(root.max,h.center,sizeof(root.max));
+      }
+
+      const char padding[8] = {0};
+      h.nbNodes     = w.nodes.size();
+      h.nbChunks    = w.chunks.size();
+      h.tableOffset = (w.offset()+7)&~(uint64_t)7;
+      ok = fwrite(padding,1,h.tableOffset-w.offset(),out)==h.tableOffset-w.offset() &&
+	fwrite(w.chunks.data(),sizeof(Chunk),w.chunks.size(),out)==w.chunks.size() &&
+	fwrite(w.nodes.data(),sizeof(Node),w.nodes.size(),out)==w.nodes.size() &&
+	fseek(out,0,SEEK_SET)==0 && fwrite(&h,sizeof(h),1,out)==1;
+    }
+    ok = fclose(out)==0 && ok;
+  } else {
+    if(!stop)
+      printf("Unable to write %s\n",tmpFilename.c_str());
+    ok = false;
+  }
+
+  munmap(positions,positionsSize);
+  if(triangles)
+    munmap(triangles,trianglesSize);
+
+  // complete, or nothing
+  if(!ok || rename(tmpFilename.c_str(),filename.c_str())!=0) {
+    remove(tmpFilename.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ChunkedMesh::open(const std::string &filename,const char *offFilename) {
+  const int fd = ::open(filename.c_str(),O_RDONLY);
+  if(fd<0)
+    return false;
+
+  struct stat s;
+  void *p = fstat(fd,&s)==0 && s.st_size>=(off_t)sizeof(Header) ?
+    mmap(NULL,s.st_size,PROT_READ,MAP_SHARED,fd,0) : MAP_FAILED;
+  close(fd);
+  if(p==MAP_FAILED)
+    return false;
+
+  _data   = (const char *)p;
+  _size   = s.st_size;
+  _header = (const Header *)_data;
+
+  uint64_t size;
+  int64_t  time;
+  const Header &h = *_header;
+  if(memcmp(h.magic,"OC01",4)!=0 || h.nbNodes==0 ||
+     h.tableOffset%8!=0 || h.tableOffset+h.nbChunks*sizeof(Chunk)+h.nbNodes*sizeof(Node)>_size ||
+     !ProgressiveMesh::offStat(offFilename,size,time) ||
+     (offFilename && (size!=h.offSize || time!=h.offTime))) {
+    munmap(p,_size);
+    _data   = NULL;
+    _header = NULL;
+    return false;
+  }
+
+  _chunks = (const Chunk *)(_data+h.tableOffset);
+  _nodes  = (const Node *)(_data+h.tableOffset+h.nbChunks*sizeof(Chunk));
+  return true;
+}
+
+void ChunkedMesh::madvise(unsigned int i,int advice) const {
+  const uint64_t page  = sysconf(_SC_PAGESIZE);
+  const uint64_t first = _chunks[i].offset&~(page-1);
+  const uint64_t last  = _chunks[i].offset+_chunks[i].nbVertices*3*sizeof(float)+_chunks[i].nbIndices*sizeof(uint32_t);
+  ::madvise((void *)(_data+first),last-first,advice);
+}
+
+void ChunkedMesh::prefetch(unsigned int i) const {
+  madvise(i,MADV_WILLNEED);
+}
+
+void ChunkedMesh::release(unsigned int i) const {
+  madvise(i,MADV_DONTNEED);
+}
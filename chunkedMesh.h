@@ -0,0 +1,110 @@
+#ifndef CHUNKED_MESH_H
+#define CHUNKED_MESH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <atomic>
+#include "bvh.h"
+
+// out-of-core mesh: an OFF file too large for the memory, converted once
+// into chunks of neighbour triangles (each with its own vertices, at most
+// MAX_VERTICES and MAX_TRIANGLES) under an octree, in a binary file that
+// is memory mapped: only the chunks being uploaded are read from the disk.
+//
+// The triangles go to the cells of a 128^3 grid by their centroid, sorted
+// in Morton order: each octree node is a range of cells, and of sorted
+// triangles. The octree is split until its leaves have at most
+// MAX_TRIANGLES, the triangles of each leaf are then cut in chunks. The
+// conversion only keeps the grid in memory, the positions and faces go
+// through memory mapped temporary files.
+//
+// File: Header, the data of each chunk (positions, xyz per vertex, then
+// indices relative to the chunk), then Chunk per chunk (the ones of a leaf
+// are consecutive) and Node per node (root first, the children of a node
+// are consecutive): the tables are written once the data is.
+class ChunkedMesh {
+ public:
+  enum {MAX_VERTICES=32768, MAX_TRIANGLES=32768};
+
+  struct Node {
+    float    min[3];      // around its chunks
+    float    max[3];
+    uint32_t firstChild;  // 0 for a leaf (the root is never a child)
+    uint32_t nbChildren;
+    uint32_t firstChunk;  // of a leaf
+    uint32_t nbChunks;
+  };
+
+  struct Chunk {
+    uint64_t offset;      // in the file
+    uint32_t nbVertices;
+    uint32_t nbIndices;
+    float    min[3];
+    float    max[3];
+  };
+
+  ChunkedMesh();
+  ~ChunkedMesh();
+
+  // OFF files larger than SIM_OUT_OF_CORE megabytes are rendered out of
+  // core (by default: a quarter of the physical memory, 0: all of them)
+  static bool outOfCore(const char *offFilename);
+
+  // converts the OFF file (progress: if not NULL, the part of the file
+  // already parsed, read by another thread). cancel: if not NULL and set
+  // (by another thread), stops without writing
+  static bool convert(const std::string &filename,const char *offFilename,std::atomic<float> *progress=NULL,
+		      const std::atomic<bool> *cancel=NULL);
+
+  // maps the file. False if it is missing, invalid or out of date
+  bool open(const std::string &filename,const char *offFilename);
+
+  inline unsigned int nbNodes()  const {return _header->nbNodes;}
+  inline unsigned int nbChunks() const {return _header->nbChunks;}
+  inline const Node  &node(unsigned int i)  const {return _nodes[i];}
+  inline const Chunk &chunk(unsigned int i) const {return _chunks[i];}
+
+  // data of a chunk, in the mapped file (read from the disk when used)
+  inline const float *vertices(unsigned int i) const {return (const float *)(_data+_chunks[i].offset);}
+  inline const unsigned int *indices(unsigned int i) const {return (const unsigned int *)(_data+_chunks[i].offset+_chunks[i].nbVertices*3*sizeof(float));}
+
+  // asks the system to read the chunk in the background, or to drop it
+  // from the memory once it is on the GPU
+  void prefetch(unsigned int i) const;
+  void release(unsigned int i) const;
+
+  inline const float *center() const {return _header->center;}
+  inline float        radius() const {return _header->radius;}
+
+  static inline Box box(const float *min,const float *max) {
+    Box b;
+    b.min = Vec3f(min[0],min[1],min[2]);
+    b.max = Vec3f(max[0],max[1],max[2]);
+    return b;
+  }
+
+ private:
+  struct Header {
+    char     magic[4];
+    uint32_t nbVertices;  // of the OFF file
+    uint32_t nbTriangles;
+    uint32_t nbNodes;
+    uint32_t nbChunks;
+    float    center[3];
+    float    radius;
+    uint64_t offSize;
+    int64_t  offTime;
+    uint64_t tableOffset; // of the chunks, then the nodes
+  };
+
+  void madvise(unsigned int i,int advice) const;
+
+  const char   *_data;   // the whole file
+  size_t        _size;
+  const Header *_header;
+  const Node   *_nodes;
+  const Chunk  *_chunks;
+};
+
+#endif // CHUNKED_MESH_H
@@ -1,8 +1,13 @@
 #include "grid.h"
+#include "trace.h"
+#include "perfcounters.h"
 
 using namespace std;
 
 Grid::Grid(unsigned int size,float minval,float maxval) {
+  TRACE_SCOPE("Grid::Grid");
+  PERF_SCOPE("Grid::Grid",size*size);
+
   const float w = maxval-minval;
   const float h = w;
 
@@ -2,33 +2,67 @@
 #include <QString>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <iostream>
 #include "viewer.h"
+#include "trace.h"
+#include "perfcounters.h"
+#include "alloctracker.h"
 
 
 using namespace std;
 
-char *getFilename(int argc,char **argv) {
-  if(argc<2) {
-    cout << "Usage: " << argv[0] << " offFile" << endl;
+// the OFF files, up to the first option
+std::vector<char *> getFilenames(int argc,char **argv,int &next) {
+  std::vector<char *> filenames;
+
+  for(next=1;next<argc && strncmp(argv[next],"--",2);++next)
+    filenames.push_back(argv[next]);
+
+  if(filenames.empty()) {
+    cout << "Usage: " << argv[0] << " offFile [offFile ...] [--bench nbFrames output.json]" << endl;
     exit(0);
   }
 
-  return argv[1];
+  return filenames;
 }
 
 int main(int argc,char** argv) {
   QApplication application(argc,argv);
 
+  // SIM_TRACE=file.json records from start-up and dumps the trace on exit
+  if(getenv("SIM_TRACE"))
+    Trace::enable();
+
   QGLFormat fmt;
   fmt.setVersion(3,3);
   fmt.setProfile(QGLFormat::CoreProfile);
   fmt.setSampleBuffers(true);
 
-  Viewer viewer(getFilename(argc,argv),fmt);
+  int next = 0;
+  Viewer viewer(getFilenames(argc,argv,next),fmt);
 
   viewer.setWindowTitle("Exercice 03 - Pipeline");
   viewer.show();
+
+  // frame benchmark used by bench/regress.sh
+  if(next+3<=argc && !strcmp(argv[next],"--bench"))
+    viewer.startBenchmark(atoi(argv[next+1]),argv[next+2]);
   
-  return application.exec();
+  const int result = application.exec();
+
+  if(Trace::enabled()) {
+    Trace::disable();
+    Trace::dump(Trace::outputFilename());
+  }
+
+  // SIM_PERF=1 reports the hardware counters of the load phases
+  if(PerfCounters::enabled())
+    PerfReport::print();
+
+#ifdef SIM_TRACK_ALLOCS
+  AllocTracker::print();
+#endif
+
+  return result;
 }
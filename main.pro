@@ -9,9 +9,31 @@ LIBS     += -lGLEW -lGL -lGLU -lm
 INCLUDEPATH  += $${GLM_PATH}
 
 SOURCES   = shader.cpp meshLoader.cpp trackball.cpp camera.cpp main.cpp viewer.cpp \
-    grid.cpp
+    grid.cpp trace.cpp perfcounters.cpp alloctracker.cpp bench/benchmark.cpp \
+    transform.cpp streambuffer.cpp meshArena.cpp bvh.cpp occlusion.cpp occlusionQueries.cpp \
+    meshlets.cpp simplify.cpp progressiveMesh.cpp backgroundLoader.cpp \
+    chunkedMesh.cpp chunkPool.cpp pointCloud.cpp
 HEADERS   = shader.h meshLoader.h trackball.h camera.h viewer.h \
-    grid.h
+    grid.h trace.h perfcounters.h alloctracker.h bench/benchmark.h \
+    mat4.h mat4simd.h vec4.h transform.h streambuffer.h meshArena.h bvh.h occlusion.h occlusionQueries.h \
+    meshlets.h simplify.h progressiveMesh.h backgroundLoader.h \
+    chunkedMesh.h chunkPool.h pointCloud.h
 
 CONFIG   += qt opengl warn_on thread uic4 release
 QT       *= xml opengl core
+QMAKE_CXXFLAGS += -std=c++14
+
+# heap allocation tracking (see alloctracker.h): qmake CONFIG+=track_allocs
+track_allocs {
+  DEFINES      += SIM_TRACK_ALLOCS
+  QMAKE_LFLAGS += -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc
+}
+
+# SIMD matrices (see mat4simd.h): SSE by default on x86,
+# qmake CONFIG+=avx for the Mat4d versions, CONFIG+=no_simd for the scalar code
+avx {
+  QMAKE_CXXFLAGS += -mavx
+}
+no_simd {
+  DEFINES += SIM_NO_SIMD
+}
@@ -3,6 +3,7 @@
 
 #include "vec3.h"
 #include <math.h>
+#include <type_traits>
 
 /*==============================================================================
   CLASS Mat3
@@ -25,7 +26,7 @@ class Mat3
 
   /*----- static methods -----*/
 
-  static Mat3 identity();
+  static constexpr Mat3 identity();
 
   /*----- methods -----*/
 
@@ -42,38 +43,35 @@ class Mat3
       _e[8] = m._e[8];
     }
 
-  Mat3(){}
-  Mat3( const Mat3<T>& m );
-  Mat3( const T& e00, const T& e01, const T& e02,
-        const T& e10, const T& e11, const T& e12,
-        const T& e20, const T& e21, const T& e22
-        );
-  ~Mat3(){}
+  Mat3() = default; // uninitialized
+  constexpr Mat3( const T& e00, const T& e01, const T& e02,
+                  const T& e10, const T& e11, const T& e12,
+                  const T& e20, const T& e21, const T& e22
+                  ) noexcept;
 
-  T* ptr();
-  const T* ptr() const;
+  constexpr T* ptr();
+  constexpr const T* ptr() const;
 
   Mat3  inverse() const;
   Mat3& inverseEq();
-  Mat3  transpose() const;
+  constexpr Mat3  transpose() const;
 
-  Mat3 operator+( const Mat3<T>& m ) const;
-  Mat3 operator-( const Mat3<T>& m ) const;
-  Mat3 operator*( const T& val ) const;
-  Mat3 operator*( const Mat3<T>& m ) const;
-  Mat3 operator/( const T& val ) const;
+  constexpr Mat3 operator+( const Mat3<T>& m ) const;
+  constexpr Mat3 operator-( const Mat3<T>& m ) const;
+  constexpr Mat3 operator*( const T& val ) const;
+  constexpr Mat3 operator*( const Mat3<T>& m ) const;
+  constexpr Mat3 operator/( const T& val ) const;
 
-  Vec3<T> operator*( const Vec3<T>& vec ) const;
+  constexpr Vec3<T> operator*( const Vec3<T>& vec ) const;
 
-  Mat3& operator+=( const Mat3<T>& m );
-  Mat3& operator-=( const Mat3<T>& m );
-  Mat3& operator*=( const T& val );
-  Mat3& operator*=( const Mat3<T>& m );
-  Mat3& operator/=( const T& val );
-  Mat3& operator=( const Mat3<T>& m );
+  constexpr Mat3& operator+=( const Mat3<T>& m );
+  constexpr Mat3& operator-=( const Mat3<T>& m );
+  constexpr Mat3& operator*=( const T& val );
+  constexpr Mat3& operator*=( const Mat3<T>& m );
+  constexpr Mat3& operator/=( const T& val );
 
-  T& operator()( int line, int col );
-  const T& operator()( int line, int col ) const;
+  constexpr T& operator()( int line, int col );
+  constexpr const T& operator()( int line, int col ) const;
 
  private:
 
@@ -85,7 +83,7 @@ class Mat3
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T> Mat3<T>::identity()
+inline constexpr Mat3<T> Mat3<T>::identity()
 {
   return Mat3<T>(
                  1, 0, 0,
@@ -97,35 +95,21 @@ inline Mat3<T> Mat3<T>::identity()
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T>::Mat3( const Mat3<T>& m )
+inline constexpr Mat3<T>::Mat3(
+                               const T& e00, const T& e01, const T& e02,
+                               const T& e10, const T& e11, const T& e12,
+                               const T& e20, const T& e21, const T& e22
+                               ) noexcept
+  : _e{ e00, e10, e20,
+        e01, e11, e21,
+        e02, e12, e22 }
 {
-  *this = m;
 }
 
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T>::Mat3(
-                     const T& e00, const T& e01, const T& e02,
-                     const T& e10, const T& e11, const T& e12,
-                     const T& e20, const T& e21, const T& e22
-                     )
-{
-  _e[0] = e00;
-  _e[1] = e10;
-  _e[2] = e20;
-  _e[3] = e01;
-  _e[4] = e11;
-  _e[5] = e21;
-  _e[6] = e02;
-  _e[7] = e12;
-  _e[8] = e22;
-}
-
-//------------------------------------------------------------------------------
-//!
-template< class T >
-inline T* Mat3<T>::ptr()
+inline constexpr T* Mat3<T>::ptr()
 {
   return _e;
 }
@@ -133,7 +117,7 @@ inline T* Mat3<T>::ptr()
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T* Mat3<T>::ptr() const
+inline constexpr const T* Mat3<T>::ptr() const
 {
   return _e;
 }
@@ -205,7 +189,7 @@ inline Mat3<T>& Mat3<T>::inverseEq()
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T> Mat3<T>::transpose() const
+inline constexpr Mat3<T> Mat3<T>::transpose() const
 {
   return Mat3<T>(_e[0],_e[1],_e[2],
                  _e[3],_e[4],_e[5],
@@ -215,7 +199,7 @@ inline Mat3<T> Mat3<T>::transpose() const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T> Mat3<T>::operator+( const Mat3<T>& m ) const
+inline constexpr Mat3<T> Mat3<T>::operator+( const Mat3<T>& m ) const
 {
   return Mat3<T>(
                  _e[0] + m._e[0],
@@ -235,7 +219,7 @@ inline Mat3<T> Mat3<T>::operator+( const Mat3<T>& m ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T> Mat3<T>::operator-( const Mat3<T>& m ) const
+inline constexpr Mat3<T> Mat3<T>::operator-( const Mat3<T>& m ) const
 {
   return Mat3<T>(
                  _e[0] - m._e[0],
@@ -255,7 +239,7 @@ inline Mat3<T> Mat3<T>::operator-( const Mat3<T>& m ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T> Mat3<T>::operator*( const T& val ) const
+inline constexpr Mat3<T> Mat3<T>::operator*( const T& val ) const
 {
   return Mat3<T>(
                  _e[0] * val,
@@ -275,7 +259,7 @@ inline Mat3<T> Mat3<T>::operator*( const T& val ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T> Mat3<T>::operator*( const Mat3<T>& m ) const
+inline constexpr Mat3<T> Mat3<T>::operator*( const Mat3<T>& m ) const
 {
   return Mat3<T>(
                  _e[0]*m._e[0] + _e[3]*m._e[1] + _e[6]*m._e[2],
@@ -295,7 +279,7 @@ inline Mat3<T> Mat3<T>::operator*( const Mat3<T>& m ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T> Mat3<T>::operator/( const T& val ) const
+inline constexpr Mat3<T> Mat3<T>::operator/( const T& val ) const
 {
   T ival = (T)1 / val;
   return Mat3<T>(
@@ -316,7 +300,7 @@ inline Mat3<T> Mat3<T>::operator/( const T& val ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec3<T> Mat3<T>::operator*( const Vec3<T>& vec ) const
+inline constexpr Vec3<T> Mat3<T>::operator*( const Vec3<T>& vec ) const
 {
   return Vec3<T>(
                  _e[0]*vec(0) + _e[3]*vec(1) + _e[6]*vec(2),
@@ -328,7 +312,7 @@ inline Vec3<T> Mat3<T>::operator*( const Vec3<T>& vec ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T>& Mat3<T>::operator+=( const Mat3<T>& m )
+inline constexpr Mat3<T>& Mat3<T>::operator+=( const Mat3<T>& m )
 {
   _e[0] += m._e[0];
   _e[1] += m._e[1];
@@ -345,7 +329,7 @@ inline Mat3<T>& Mat3<T>::operator+=( const Mat3<T>& m )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T>& Mat3<T>::operator-=( const Mat3<T>& m )
+inline constexpr Mat3<T>& Mat3<T>::operator-=( const Mat3<T>& m )
 {
   _e[0] -= m._e[0];
   _e[1] -= m._e[1];
@@ -362,7 +346,7 @@ inline Mat3<T>& Mat3<T>::operator-=( const Mat3<T>& m )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T>& Mat3<T>::operator*=( const T& val )
+inline constexpr Mat3<T>& Mat3<T>::operator*=( const T& val )
 {
   _e[0] *= val;
   _e[1] *= val;
@@ -379,7 +363,7 @@ inline Mat3<T>& Mat3<T>::operator*=( const T& val )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T>& Mat3<T>::operator*=( const Mat3<T>& m )
+inline constexpr Mat3<T>& Mat3<T>::operator*=( const Mat3<T>& m )
 {
   T e0 = _e[0];
   T e1 = _e[1];
@@ -405,7 +389,7 @@ inline Mat3<T>& Mat3<T>::operator*=( const Mat3<T>& m )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat3<T>& Mat3<T>::operator/=( const T& val )
+inline constexpr Mat3<T>& Mat3<T>::operator/=( const T& val )
 {
   T ival = (T)1 / val;
 
@@ -421,27 +405,10 @@ inline Mat3<T>& Mat3<T>::operator/=( const T& val )
   return *this;
 }
 
-//------------------------------------------------------------------------------
-//!
-template< class T >
-inline Mat3<T>& Mat3<T>::operator=( const Mat3<T>& m )
-{
-  _e[0] = m._e[0];
-  _e[1] = m._e[1];
-  _e[2] = m._e[2];
-  _e[3] = m._e[3];
-  _e[4] = m._e[4];
-  _e[5] = m._e[5];
-  _e[6] = m._e[6];
-  _e[7] = m._e[7];
-  _e[8] = m._e[8];
-  return *this;
-}
-
 //------------------------------------------------------------------------------
 //!
   template< class T >
-  inline T& Mat3<T>::operator()( int line, int col )
+  inline constexpr T& Mat3<T>::operator()( int line, int col )
   {
     return _e[ line + (col*3) ];
   }
@@ -449,7 +416,7 @@ inline Mat3<T>& Mat3<T>::operator=( const Mat3<T>& m )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T& Mat3<T>::operator()( int line, int col ) const
+inline constexpr const T& Mat3<T>::operator()( int line, int col ) const
 {
   return _e[ line + (col*3) ];
 }
@@ -482,5 +449,7 @@ typedef Mat3< int >    Mat3i;
 typedef Mat3< float >  Mat3f;
 typedef Mat3< double > Mat3d;
 
+static_assert( std::is_trivially_copyable< Mat3f >::value, "Mat3f must stay trivially copyable" );
+
 
 #endif
@@ -4,6 +4,7 @@
 #include "mat3.h"
 #include "vec4.h"
 #include <math.h>
+#include <type_traits>
 #include <stdio.h>
 #include <string.h>
 
@@ -21,6 +22,9 @@
 //!             ( 2 6 10 14 )            (  8  9 10 11 )
 //!             ( 3 7 11 15 )            ( 12 13 14 15 )
 //!
+//!  Mat4f (SSE) and Mat4d (AVX) have SIMD versions of the products,
+//!  transpose and inverses, see mat4simd.h.
+//!
 
 template< class T >
 class Mat4
@@ -30,15 +34,21 @@ class Mat4
 
   /*----- static methods -----*/
 
-  static Mat4 identity();
+  static constexpr Mat4 identity();
   static Mat4 rotationX( const T& angle ); // pitch
   static Mat4 rotationY( const T& angle ); // heading
   static Mat4 rotationZ( const T& angle ); // roll
-  static Mat4 rotationX( const T& cos, const T& sin );
-  static Mat4 rotationY( const T& cos, const T& sin );
-  static Mat4 rotationZ( const T& cos, const T& sin );
-  static Mat4 shearY( const T& tanyx, const T& tanyz );
-  static Mat4 scale( T const & sx, T const & sy , T const & sz );
+  static constexpr Mat4 rotationX( const T& cos, const T& sin );
+  static constexpr Mat4 rotationY( const T& cos, const T& sin );
+  static constexpr Mat4 rotationZ( const T& cos, const T& sin );
+  static constexpr Mat4 shearY( const T& tanyx, const T& tanyz );
+  static constexpr Mat4 scale( T const & sx, T const & sy , T const & sz );
+
+  // same matrices as gluPerspective (fovy in degrees), glOrtho and gluLookAt
+  static Mat4 perspective( const T& fovy, const T& aspect, const T& zNear, const T& zFar );
+  static constexpr Mat4 ortho( const T& left, const T& right, const T& bottom, const T& top,
+                               const T& zNear, const T& zFar );
+  static Mat4 lookAt( const Vec3<T>& eye, const Vec3<T>& center, const Vec3<T>& up );
 
   /*----- methods -----*/
 
@@ -62,65 +72,61 @@ class Mat4
       _e[15] = m(15);
     }
 
-  Mat4(){
-    memset( _e, 0, 16 * sizeof(T) );
-  }
-  Mat4( const Mat4<T>& m );
-  Mat4( const T& e00, const T& e01, const T& e02, const T& e03,
-        const T& e10, const T& e11, const T& e12, const T& e13,
-        const T& e20, const T& e21, const T& e22, const T& e23,
-        const T& e30, const T& e31, const T& e32, const T& e33
-        );
-  Mat4( const Mat3<T>& m );
+  constexpr Mat4() noexcept : _e{} {}
+  constexpr Mat4( const T& e00, const T& e01, const T& e02, const T& e03,
+                  const T& e10, const T& e11, const T& e12, const T& e13,
+                  const T& e20, const T& e21, const T& e22, const T& e23,
+                  const T& e30, const T& e31, const T& e32, const T& e33
+                  ) noexcept;
+  constexpr Mat4( const Mat3<T>& m ) noexcept;
   Mat4( const T& m );
-  ~Mat4(){}
 
-  T* ptr();
-  const T* ptr() const;
+  constexpr T* ptr();
+  constexpr const T* ptr() const;
 
   Mat4  inverse() const;
+  Mat4  affineInverse() const; // last row must be ( 0 0 0 1 )
   Mat4& inverseEq();
-  Mat4& translateEq( const Vec3<T>& vec );
-  Mat4& translateBeforeEq( const Vec3<T>& vec );
-  Mat4  transpose() const;
-
-  Mat4 operator+( const Mat4<T>& m ) const;
-  Mat4 operator-( const Mat4<T>& m ) const;
-  Mat4 operator*( const T& val ) const;
-  Mat4 operator*( const Mat4<T>& m ) const;
-  Mat4 operator/( const T& val ) const;
-
-  Vec4<T> operator*( const Vec4<T>& vec ) const;
-  Vec3<T> operator*( const Vec3<T>& vec ) const;
-  Vec3<T> operator^( const Vec3<T>& vec ) const;
-  Vec3<T> operator|( const Vec3<T>& vec ) const;
-
-  Mat4& operator+=( const Mat4<T>& m );
-  Mat4& operator-=( const Mat4<T>& m );
-  Mat4& operator*=( const T& val );
-  Mat4& operator*=( const Mat4<T>& m );
-  Mat4& operator/=( const T& val );
-  Mat4& operator=( const Mat4<T>& m );
-
-  T& operator[]( int pos );
-  const T& operator[]( int pos ) const;
-
-  T& operator()( int pos );
-  const T& operator()( int pos ) const;
-  T& operator()( int line, int col );
-  const T& operator()( int line, int col ) const;
+  constexpr Mat4& translateEq( const Vec3<T>& vec );
+  constexpr Mat4& translateBeforeEq( const Vec3<T>& vec );
+  constexpr Mat4  transpose() const;
+
+  constexpr Mat4 operator+( const Mat4<T>& m ) const;
+  constexpr Mat4 operator-( const Mat4<T>& m ) const;
+  constexpr Mat4 operator*( const T& val ) const;
+  constexpr Mat4 operator*( const Mat4<T>& m ) const;
+  constexpr Mat4 operator/( const T& val ) const;
+
+  constexpr Vec4<T> operator*( const Vec4<T>& vec ) const;
+  constexpr Vec3<T> operator*( const Vec3<T>& vec ) const;
+  constexpr Vec3<T> operator^( const Vec3<T>& vec ) const;
+  constexpr Vec3<T> operator|( const Vec3<T>& vec ) const;
+
+  constexpr Mat4& operator+=( const Mat4<T>& m );
+  constexpr Mat4& operator-=( const Mat4<T>& m );
+  constexpr Mat4& operator*=( const T& val );
+  constexpr Mat4& operator*=( const Mat4<T>& m );
+  constexpr Mat4& operator/=( const T& val );
+
+  constexpr T& operator[]( int pos );
+  constexpr const T& operator[]( int pos ) const;
+
+  constexpr T& operator()( int pos );
+  constexpr const T& operator()( int pos ) const;
+  constexpr T& operator()( int line, int col );
+  constexpr const T& operator()( int line, int col ) const;
 
  private:
 
   /*----- data members -----*/
 
-  T _e[16];
+  alignas(16) T _e[16];
 };
 
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T> Mat4<T>::identity()
+inline constexpr Mat4<T> Mat4<T>::identity()
 {
   return Mat4<T>(
                  1, 0, 0, 0,
@@ -157,7 +163,7 @@ inline Mat4<T> Mat4<T>::rotationZ( const T& angle )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T> Mat4<T>::rotationX( const T& cos, const T& sin )
+inline constexpr Mat4<T> Mat4<T>::rotationX( const T& cos, const T& sin )
 {
   return Mat4<T>(
                  1,   0,    0, 0,
@@ -171,7 +177,7 @@ inline Mat4<T> Mat4<T>::rotationX( const T& cos, const T& sin )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T> Mat4<T>::rotationY( const T& cos, const T& sin )
+inline constexpr Mat4<T> Mat4<T>::rotationY( const T& cos, const T& sin )
 {
   return Mat4<T>(
                  cos, 0, sin, 0,
@@ -184,7 +190,7 @@ inline Mat4<T> Mat4<T>::rotationY( const T& cos, const T& sin )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T> Mat4<T>::rotationZ( const T& cos, const T& sin )
+inline constexpr Mat4<T> Mat4<T>::rotationZ( const T& cos, const T& sin )
 {
   return Mat4<T>(
                  cos, -sin, 0, 0,
@@ -197,7 +203,7 @@ inline Mat4<T> Mat4<T>::rotationZ( const T& cos, const T& sin )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T> Mat4<T>::shearY( const T& tanyx, const T& tanyz )
+inline constexpr Mat4<T> Mat4<T>::shearY( const T& tanyx, const T& tanyz )
 {
   return Mat4<T>(
                  1,  0,     0, 0,
@@ -208,7 +214,7 @@ inline Mat4<T> Mat4<T>::shearY( const T& tanyx, const T& tanyz )
 }
 
 template< class T >
-inline Mat4<T> Mat4<T>::scale( T const & sx, T const & sy , T const & sz )
+inline constexpr Mat4<T> Mat4<T>::scale( T const & sx, T const & sy , T const & sz )
 {
   return Mat4<T>(
                  sx,  0, 0, 0,
@@ -222,66 +228,75 @@ inline Mat4<T> Mat4<T>::scale( T const & sx, T const & sy , T const & sz )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T>::Mat4( const Mat4<T>& m )
+inline Mat4<T> Mat4<T>::perspective( const T& fovy, const T& aspect, const T& zNear, const T& zFar )
 {
-  *this = m;
+  const T range = tan( fovy * (T)M_PI / (T)360 ) * zNear;
+  const T right = range * aspect;
+
+  return Mat4<T>(
+                 zNear / right, 0,             0,                               0,
+                 0,             zNear / range, 0,                               0,
+                 0,             0,             -(zFar + zNear) / (zFar - zNear), -(2 * zFar * zNear) / (zFar - zNear),
+                 0,             0,             -1,                              0
+                 );
 }
 
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T>::Mat4(
-                     const T& e00, const T& e01, const T& e02, const T& e03,
-                     const T& e10, const T& e11, const T& e12, const T& e13,
-                     const T& e20, const T& e21, const T& e22, const T& e23,
-                     const T& e30, const T& e31, const T& e32, const T& e33
-                     )
+inline constexpr Mat4<T> Mat4<T>::ortho( const T& left, const T& right, const T& bottom, const T& top,
+                               const T& zNear, const T& zFar )
 {
-  _e[0] = e00;
-  _e[1] = e10;
-  _e[2] = e20;
-  _e[3] = e30;
-
-  _e[4] = e01;
-  _e[5] = e11;
-  _e[6] = e21;
-  _e[7] = e31;
-
-  _e[8] = e02;
-  _e[9] = e12;
-  _e[10]= e22;
-  _e[11]= e32;
-
-  _e[12]= e03;
-  _e[13]= e13;
-  _e[14]= e23;
-  _e[15]= e33;
+  return Mat4<T>(
+                 2 / (right - left), 0,                  0,                   -(right + left) / (right - left),
+                 0,                  2 / (top - bottom), 0,                   -(top + bottom) / (top - bottom),
+                 0,                  0,                  -2 / (zFar - zNear), -(zFar + zNear) / (zFar - zNear),
+                 0,                  0,                  0,                   1
+                 );
 }
 
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T>::Mat4( const Mat3<T>& m )
+inline Mat4<T> Mat4<T>::lookAt( const Vec3<T>& eye, const Vec3<T>& center, const Vec3<T>& up )
 {
-  _e[0]  = m(0,0);
-  _e[1]  = m(1,0);
-  _e[2]  = m(2,0);
-  _e[3]  = 0;
+  const Vec3<T> f = ( center - eye ).normal();
+  const Vec3<T> s = ( f ^ up ).normal();
+  const Vec3<T> u = s ^ f;
 
-  _e[4]  = m(0,1);
-  _e[5]  = m(1,1);
-  _e[6]  = m(2,1);
-  _e[7]  = 0;
+  return Mat4<T>(
+                  s(0),  s(1),  s(2), -s.dot( eye ),
+                  u(0),  u(1),  u(2), -u.dot( eye ),
+                 -f(0), -f(1), -f(2),  f.dot( eye ),
+                  0,     0,     0,     1
+                 );
+}
 
-  _e[8]  = m(0,2);
-  _e[9]  = m(1,2);
-  _e[10] = m(2,2);
-  _e[11] = 0;
+//------------------------------------------------------------------------------
+//!
+template< class T >
+inline constexpr Mat4<T>::Mat4(
+                               const T& e00, const T& e01, const T& e02, const T& e03,
+                               const T& e10, const T& e11, const T& e12, const T& e13,
+                               const T& e20, const T& e21, const T& e22, const T& e23,
+                               const T& e30, const T& e31, const T& e32, const T& e33
+                               ) noexcept
+  : _e{ e00, e10, e20, e30,
+        e01, e11, e21, e31,
+        e02, e12, e22, e32,
+        e03, e13, e23, e33 }
+{
+}
 
-  _e[12] = 0;
-  _e[13] = 0;
-  _e[14] = 0;
-  _e[15] = 1;
+//------------------------------------------------------------------------------
+//!
+template< class T >
+inline constexpr Mat4<T>::Mat4( const Mat3<T>& m ) noexcept
+  : _e{ m(0,0), m(1,0), m(2,0), 0,
+        m(0,1), m(1,1), m(2,1), 0,
+        m(0,2), m(1,2), m(2,2), 0,
+        0,      0,      0,      1 }
+{
 }
 
 //------------------------------------------------------------------------------
@@ -295,7 +310,7 @@ inline Mat4<T>::Mat4( const T& m )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline T* Mat4<T>::ptr()
+inline constexpr T* Mat4<T>::ptr()
 {
   return _e;
 }
@@ -303,7 +318,7 @@ inline T* Mat4<T>::ptr()
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T* Mat4<T>::ptr() const
+inline constexpr const T* Mat4<T>::ptr() const
 {
   return _e;
 }
@@ -423,12 +438,45 @@ inline Mat4<T>& Mat4<T>::inverseEq()
   return *this;
 }
 
+//------------------------------------------------------------------------------
+//! Inverse of a rotation/scale/shear + translation: the 3x3 part is inverted
+//! with cross products and the translation is transformed by the result.
+template< class T >
+inline Mat4<T> Mat4<T>::affineInverse() const
+{
+  // rows of the inverse 3x3 part (times det)
+  T r0[3] = { _e[5]*_e[10] - _e[6]*_e[9],  _e[6]*_e[8] - _e[4]*_e[10], _e[4]*_e[9] - _e[5]*_e[8] };
+  T r1[3] = { _e[9]*_e[2]  - _e[10]*_e[1], _e[10]*_e[0] - _e[8]*_e[2], _e[8]*_e[1] - _e[9]*_e[0] };
+  T r2[3] = { _e[1]*_e[6]  - _e[2]*_e[5],  _e[2]*_e[4] - _e[0]*_e[6],  _e[0]*_e[5] - _e[1]*_e[4] };
+
+  T det = _e[0]*r0[0] + _e[1]*r0[1] + _e[2]*r0[2];
+
+  if( fabs( det ) < 1e-12 ) return Mat4<T>();
+
+  T idet = 1.0/det;
+
+  Mat4<T> m;
+  for ( int i = 0; i < 3; ++i )
+    {
+      m._e[4*i]   = r0[i]*idet;
+      m._e[4*i+1] = r1[i]*idet;
+      m._e[4*i+2] = r2[i]*idet;
+    }
+
+  m._e[12] = -(m._e[0]*_e[12] + m._e[4]*_e[13] + m._e[8]*_e[14]);
+  m._e[13] = -(m._e[1]*_e[12] + m._e[5]*_e[13] + m._e[9]*_e[14]);
+  m._e[14] = -(m._e[2]*_e[12] + m._e[6]*_e[13] + m._e[10]*_e[14]);
+  m._e[15] = 1;
+
+  return m;
+}
+
 //------------------------------------------------------------------------------
 //! Apply  (T) * (this)
 //! This operation suppose that the last row of the matrix
 //! is ( 0 0 0 1 )
 template< class T >
-inline Mat4<T>& Mat4<T>::translateEq( const Vec3<T>& vec )
+inline constexpr Mat4<T>& Mat4<T>::translateEq( const Vec3<T>& vec )
 {
   _e[12] += vec(0);
   _e[13] += vec(1);
@@ -439,21 +487,22 @@ inline Mat4<T>& Mat4<T>::translateEq( const Vec3<T>& vec )
 
 //------------------------------------------------------------------------------
 //! Apply (this) * T
-//! This operation suppose that the last row of the matrix
-//! is ( 0 0 0 1 )
+//! Valid for any matrix (the last row is updated too): also
+//! for projective ones
 template< class T >
-inline Mat4<T>& Mat4<T>::translateBeforeEq( const Vec3<T>& vec )
+inline constexpr Mat4<T>& Mat4<T>::translateBeforeEq( const Vec3<T>& vec )
 {
   _e[12] += _e[0] * vec(0) + _e[4] * vec(1) + _e[8]  * vec(2);
   _e[13] += _e[1] * vec(0) + _e[5] * vec(1) + _e[9]  * vec(2);
   _e[14] += _e[2] * vec(0) + _e[6] * vec(1) + _e[10] * vec(2);
+  _e[15] += _e[3] * vec(0) + _e[7] * vec(1) + _e[11] * vec(2);
   return *this;
 }
 
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T> Mat4<T>::transpose() const
+inline constexpr Mat4<T> Mat4<T>::transpose() const
 {
   return Mat4<T>(
                  _e[0],  _e[1],  _e[2],  _e[3],
@@ -466,7 +515,7 @@ inline Mat4<T> Mat4<T>::transpose() const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T> Mat4<T>::operator+( const Mat4<T>& m ) const
+inline constexpr Mat4<T> Mat4<T>::operator+( const Mat4<T>& m ) const
 {
   return Mat4<T>(
                  _e[0]  + m._e[0],
@@ -494,7 +543,7 @@ inline Mat4<T> Mat4<T>::operator+( const Mat4<T>& m ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T> Mat4<T>::operator-( const Mat4<T>& m ) const
+inline constexpr Mat4<T> Mat4<T>::operator-( const Mat4<T>& m ) const
 {
   return Mat4<T>(
                  _e[0]  - m._e[0],
@@ -522,7 +571,7 @@ inline Mat4<T> Mat4<T>::operator-( const Mat4<T>& m ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T> Mat4<T>::operator*( const T& val ) const
+inline constexpr Mat4<T> Mat4<T>::operator*( const T& val ) const
 {
   return Mat4<T>(
                  _e[0]  * val,
@@ -550,7 +599,7 @@ inline Mat4<T> Mat4<T>::operator*( const T& val ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T> Mat4<T>::operator*( const Mat4<T>& m ) const
+inline constexpr Mat4<T> Mat4<T>::operator*( const Mat4<T>& m ) const
 {
   return Mat4<T>(
                  _e[0]*m._e[0] + _e[4]*m._e[1] + _e[8]*m._e[2]  + _e[12]*m._e[3],
@@ -578,7 +627,7 @@ inline Mat4<T> Mat4<T>::operator*( const Mat4<T>& m ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T> Mat4<T>::operator/( const T& val ) const
+inline constexpr Mat4<T> Mat4<T>::operator/( const T& val ) const
 {
   T ival = (T)1 / val;
   return Mat4<T>(
@@ -607,7 +656,7 @@ inline Mat4<T> Mat4<T>::operator/( const T& val ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec4<T> Mat4<T>::operator*( const Vec4<T>& vec ) const
+inline constexpr Vec4<T> Mat4<T>::operator*( const Vec4<T>& vec ) const
 {
   return Vec4<T>(
                  _e[0]*vec(0) + _e[4]*vec(1) + _e[8]*vec(2) + _e[12]*vec(3),
@@ -620,7 +669,7 @@ inline Vec4<T> Mat4<T>::operator*( const Vec4<T>& vec ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec3<T> Mat4<T>::operator*( const Vec3<T>& vec ) const
+inline constexpr Vec3<T> Mat4<T>::operator*( const Vec3<T>& vec ) const
 {
   return Vec3<T>(
                  _e[0]*vec(0) + _e[4]*vec(1) + _e[8]*vec(2) + _e[12],
@@ -633,7 +682,7 @@ inline Vec3<T> Mat4<T>::operator*( const Vec3<T>& vec ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec3<T> Mat4<T>::operator^( const Vec3<T>& vec ) const
+inline constexpr Vec3<T> Mat4<T>::operator^( const Vec3<T>& vec ) const
 {
   return Vec3<T>(
                  _e[0]*vec(0) + _e[4]*vec(1) + _e[8]*vec(2),
@@ -645,7 +694,7 @@ inline Vec3<T> Mat4<T>::operator^( const Vec3<T>& vec ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec3<T> Mat4<T>::operator|( const Vec3<T>& vec ) const
+inline constexpr Vec3<T> Mat4<T>::operator|( const Vec3<T>& vec ) const
 {
   float div = (T)(1) /
     ( _e[3]*vec(0) + _e[7]*vec(1) + _e[11]*vec(2)+ _e[15] );
@@ -660,7 +709,7 @@ inline Vec3<T> Mat4<T>::operator|( const Vec3<T>& vec ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T>& Mat4<T>::operator+=( const Mat4<T>& m )
+inline constexpr Mat4<T>& Mat4<T>::operator+=( const Mat4<T>& m )
 {
   _e[0] += m._e[0];
   _e[1] += m._e[1];
@@ -687,7 +736,7 @@ inline Mat4<T>& Mat4<T>::operator+=( const Mat4<T>& m )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T>& Mat4<T>::operator-=( const Mat4<T>& m )
+inline constexpr Mat4<T>& Mat4<T>::operator-=( const Mat4<T>& m )
 {
   _e[0] -= m._e[0];
   _e[1] -= m._e[1];
@@ -714,7 +763,7 @@ inline Mat4<T>& Mat4<T>::operator-=( const Mat4<T>& m )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T>& Mat4<T>::operator*=( const T& val )
+inline constexpr Mat4<T>& Mat4<T>::operator*=( const T& val )
 {
   _e[0] *= val;
   _e[1] *= val;
@@ -741,7 +790,7 @@ inline Mat4<T>& Mat4<T>::operator*=( const T& val )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T>& Mat4<T>::operator*=( const Mat4<T>& m )
+inline constexpr Mat4<T>& Mat4<T>::operator*=( const Mat4<T>& m )
 {
   T e0  = _e[0];
   T e1  = _e[1];
@@ -782,7 +831,7 @@ inline Mat4<T>& Mat4<T>::operator*=( const Mat4<T>& m )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Mat4<T>& Mat4<T>::operator/=( const T& val )
+inline constexpr Mat4<T>& Mat4<T>::operator/=( const T& val )
 {
   T ival = (T)1 / val;
   _e[0]  *= ival;
@@ -807,37 +856,10 @@ inline Mat4<T>& Mat4<T>::operator/=( const T& val )
   return *this;
 }
 
-//------------------------------------------------------------------------------
-//!
-template< class T >
-inline Mat4<T>& Mat4<T>::operator=( const Mat4<T>& m )
-{
-  _e[0]  = m._e[0];
-  _e[1]  = m._e[1];
-  _e[2]  = m._e[2];
-  _e[3]  = m._e[3];
-
-  _e[4]  = m._e[4];
-  _e[5]  = m._e[5];
-  _e[6]  = m._e[6];
-  _e[7]  = m._e[7];
-
-  _e[8]  = m._e[8];
-  _e[9]  = m._e[9];
-  _e[10] = m._e[10];
-  _e[11] = m._e[11];
-
-  _e[12] = m._e[12];
-  _e[13] = m._e[13];
-  _e[14] = m._e[14];
-  _e[15] = m._e[15];
-  return *this;
-}
-
 //------------------------------------------------------------------------------
 //!
   template< class T >
-  inline T& Mat4<T>::operator[]( int pos )
+  inline constexpr T& Mat4<T>::operator[]( int pos )
   {
     return _e[pos];
   }
@@ -845,7 +867,7 @@ inline Mat4<T>& Mat4<T>::operator=( const Mat4<T>& m )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T& Mat4<T>::operator[]( int pos ) const
+inline constexpr const T& Mat4<T>::operator[]( int pos ) const
 {
   return _e[pos];
 }
@@ -853,7 +875,7 @@ inline const T& Mat4<T>::operator[]( int pos ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline T& Mat4<T>::operator()( int pos )
+inline constexpr T& Mat4<T>::operator()( int pos )
 {
   return _e[pos];
 }
@@ -861,7 +883,7 @@ inline T& Mat4<T>::operator()( int pos )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T& Mat4<T>::operator()( int pos ) const
+inline constexpr const T& Mat4<T>::operator()( int pos ) const
 {
   return _e[pos];
 }
@@ -871,7 +893,7 @@ inline const T& Mat4<T>::operator()( int pos ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline T& Mat4<T>::operator()( int line, int col )
+inline constexpr T& Mat4<T>::operator()( int line, int col )
 {
   return _e[ line + (col<<2) ];
 }
@@ -879,7 +901,7 @@ inline T& Mat4<T>::operator()( int line, int col )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T& Mat4<T>::operator()( int line, int col ) const
+inline constexpr const T& Mat4<T>::operator()( int line, int col ) const
 {
   return _e[ line + (col<<2) ];
 }
@@ -920,6 +942,14 @@ typedef Mat4< int >    Mat4i;
 typedef Mat4< float >  Mat4f;
 typedef Mat4< double > Mat4d;
 
-       
+// copied as is into uniform buffers (std140 mat4)
+static_assert( std::is_trivially_copyable< Mat4f >::value, "Mat4f must stay trivially copyable" );
+
+#include "mat4simd.h"
+
+// with or without the SIMD versions
+static_assert( ( Mat4f::scale( 2, 3, 4 ) * Mat4f::identity() * Mat4f::ortho( -1, 1, -1, 1, -1, 1 ) ).transpose()( 2, 2 ) == -4 &&
+               ( Mat4f::scale( 2, 3, 4 ) * Vec4f( 1, 1, 1, 1 ) )( 1 ) == 3,
+               "Mat4f products must stay constant expressions" );
 
 #endif
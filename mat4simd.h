@@ -0,0 +1,352 @@
+#ifndef MAT4SIMD_H
+#define MAT4SIMD_H
+
+// included by mat4.h
+
+/*==============================================================================
+  SIMD specializations of Mat4f (SSE) and Mat4d (AVX)
+  ==============================================================================*/
+
+//! Each column is one register. The operations are done in the same order
+//! as the scalar versions of mat4.h (no reassociation, no fma), so that both
+//! give the same bits: build with -DSIM_NO_SIMD to get the scalar code back.
+//! Do not build with -mfma and -ffp-contract=fast, the compiler would then
+//! fuse the scalar and the SIMD products differently.
+//!
+//! The products and transposes stay constexpr: in a constant expression
+//! they use the scalar loops of Mat4Simd, in the same order as mat4.h.
+//! Compilers without __builtin_is_constant_evaluated get the scalar code.
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define MAT4SIMD_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#elif (defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define MAT4SIMD_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+#if !defined(SIM_NO_SIMD) && (defined(__SSE__) || defined(_M_X64)) && defined(MAT4SIMD_CONSTANT_EVALUATED)
+
+#include <immintrin.h>
+
+namespace Mat4Simd
+{
+  // scalar versions for the constant expressions, same bits as mat4.h
+  template< class T >
+  inline constexpr Mat4<T> product( const Mat4<T>& a, const Mat4<T>& b )
+  {
+    Mat4<T> r;
+    for( int j = 0; j < 4; ++j )
+      for( int i = 0; i < 4; ++i )
+        r[4*j+i] = a[i]*b[4*j] + a[4+i]*b[4*j+1] + a[8+i]*b[4*j+2] + a[12+i]*b[4*j+3];
+    return r;
+  }
+
+  template< class T >
+  inline constexpr Vec4<T> product( const Mat4<T>& a, const Vec4<T>& v )
+  {
+    Vec4<T> r;
+    for( int i = 0; i < 4; ++i )
+      r(i) = a[i]*v(0) + a[4+i]*v(1) + a[8+i]*v(2) + a[12+i]*v(3);
+    return r;
+  }
+
+  template< class T >
+  inline constexpr Mat4<T> transpose( const Mat4<T>& a )
+  {
+    Mat4<T> r;
+    for( int j = 0; j < 4; ++j )
+      for( int i = 0; i < 4; ++i )
+        r[4*j+i] = a[4*i+j];
+    return r;
+  }
+
+  // a.yzx*b.zxy - a.zxy*b.yzx, same order as a scalar cross product
+  inline __m128 cross( __m128 a, __m128 b )
+  {
+    return _mm_sub_ps(
+                      _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE(3,0,2,1) ), _mm_shuffle_ps( b, b, _MM_SHUFFLE(3,1,0,2) ) ),
+                      _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE(3,1,0,2) ), _mm_shuffle_ps( b, b, _MM_SHUFFLE(3,0,2,1) ) )
+                      );
+  }
+
+  // ((c0*v0 + c1*v1) + c2*v2) + c3*v3
+  inline __m128 combine( __m128 c0, __m128 c1, __m128 c2, __m128 c3, const float *v )
+  {
+    __m128 r = _mm_mul_ps( c0, _mm_set1_ps( v[0] ) );
+    r = _mm_add_ps( r, _mm_mul_ps( c1, _mm_set1_ps( v[1] ) ) );
+    r = _mm_add_ps( r, _mm_mul_ps( c2, _mm_set1_ps( v[2] ) ) );
+    return _mm_add_ps( r, _mm_mul_ps( c3, _mm_set1_ps( v[3] ) ) );
+  }
+
+  // 2x2 sub-determinants of the columns a and b used by the Cramer's rule:
+  // p = ( a2b3-a3b2, a1b3-a3b1, a1b2-a2b1, a0b3-a3b0 ), q = ( a0b2-a2b0, a0b1-a1b0, -, - )
+  inline void minors( __m128 a, __m128 b, __m128& p, __m128& q )
+  {
+    p = _mm_sub_ps(
+                   _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE(0,1,1,2) ), _mm_shuffle_ps( b, b, _MM_SHUFFLE(3,2,3,3) ) ),
+                   _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE(3,2,3,3) ), _mm_shuffle_ps( b, b, _MM_SHUFFLE(0,1,1,2) ) )
+                   );
+    q = _mm_sub_ps(
+                   _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE(0,0,0,0) ), _mm_shuffle_ps( b, b, _MM_SHUFFLE(1,1,1,2) ) ),
+                   _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE(1,1,1,2) ), _mm_shuffle_ps( b, b, _MM_SHUFFLE(0,0,0,0) ) )
+                   );
+  }
+
+  // one row of the adjugate: (( c[1000]*t[0012] - c[2211]*t[1334] ) + c[3332]*t[2455] )
+  // with alternate signs, negated for the rows 1 and 3
+  inline __m128 adjugate( __m128 c, __m128 p, __m128 q, __m128 sign )
+  {
+    const __m128 t1 = _mm_shuffle_ps( p, p, _MM_SHUFFLE(2,1,0,0) );
+    const __m128 t2 = _mm_shuffle_ps( p, _mm_shuffle_ps( p, q, _MM_SHUFFLE(0,0,3,3) ), _MM_SHUFFLE(2,1,3,1) );
+    const __m128 t3 = _mm_shuffle_ps( _mm_shuffle_ps( p, q, _MM_SHUFFLE(1,0,2,2) ), q, _MM_SHUFFLE(1,1,2,0) );
+    const __m128 flip = _mm_set1_ps( -0.0f );
+
+    __m128 r = _mm_xor_ps( _mm_mul_ps( _mm_shuffle_ps( c, c, _MM_SHUFFLE(0,0,0,1) ), t1 ), sign );
+    r = _mm_add_ps( r, _mm_xor_ps( _mm_mul_ps( _mm_shuffle_ps( c, c, _MM_SHUFFLE(1,1,2,2) ), t2 ), _mm_xor_ps( sign, flip ) ) );
+    return _mm_add_ps( r, _mm_xor_ps( _mm_mul_ps( _mm_shuffle_ps( c, c, _MM_SHUFFLE(2,3,3,3) ), t3 ), sign ) );
+  }
+}
+
+//------------------------------------------------------------------------------
+//!
+template<>
+inline constexpr Mat4<float> Mat4<float>::operator*( const Mat4<float>& m ) const
+{
+  if( MAT4SIMD_CONSTANT_EVALUATED() ) return Mat4Simd::product( *this, m );
+
+  const __m128 c0 = _mm_load_ps( _e );
+  const __m128 c1 = _mm_load_ps( _e + 4 );
+  const __m128 c2 = _mm_load_ps( _e + 8 );
+  const __m128 c3 = _mm_load_ps( _e + 12 );
+
+  Mat4<float> r;
+  _mm_store_ps( r._e,      Mat4Simd::combine( c0, c1, c2, c3, m._e ) );
+  _mm_store_ps( r._e + 4,  Mat4Simd::combine( c0, c1, c2, c3, m._e + 4 ) );
+  _mm_store_ps( r._e + 8,  Mat4Simd::combine( c0, c1, c2, c3, m._e + 8 ) );
+  _mm_store_ps( r._e + 12, Mat4Simd::combine( c0, c1, c2, c3, m._e + 12 ) );
+  return r;
+}
+
+//------------------------------------------------------------------------------
+//!
+template<>
+inline constexpr Mat4<float>& Mat4<float>::operator*=( const Mat4<float>& m )
+{
+  return *this = *this * m;
+}
+
+//------------------------------------------------------------------------------
+//!
+template<>
+inline constexpr Vec4<float> Mat4<float>::operator*( const Vec4<float>& vec ) const
+{
+  if( MAT4SIMD_CONSTANT_EVALUATED() ) return Mat4Simd::product( *this, vec );
+
+  Vec4<float> r;
+  _mm_store_ps( r.ptr(), Mat4Simd::combine( _mm_load_ps( _e ), _mm_load_ps( _e + 4 ),
+                                            _mm_load_ps( _e + 8 ), _mm_load_ps( _e + 12 ), vec.ptr() ) );
+  return r;
+}
+
+//------------------------------------------------------------------------------
+//!
+template<>
+inline constexpr Mat4<float> Mat4<float>::transpose() const
+{
+  if( MAT4SIMD_CONSTANT_EVALUATED() ) return Mat4Simd::transpose( *this );
+
+  __m128 c0 = _mm_load_ps( _e );
+  __m128 c1 = _mm_load_ps( _e + 4 );
+  __m128 c2 = _mm_load_ps( _e + 8 );
+  __m128 c3 = _mm_load_ps( _e + 12 );
+  _MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+
+  Mat4<float> r;
+  _mm_store_ps( r._e,      c0 );
+  _mm_store_ps( r._e + 4,  c1 );
+  _mm_store_ps( r._e + 8,  c2 );
+  _mm_store_ps( r._e + 12, c3 );
+  return r;
+}
+
+//------------------------------------------------------------------------------
+//! Cramer's rule, element by element as the scalar version.
+template<>
+inline Mat4<float> Mat4<float>::inverse() const
+{
+  const __m128 c0 = _mm_load_ps( _e );
+  const __m128 c1 = _mm_load_ps( _e + 4 );
+  const __m128 c2 = _mm_load_ps( _e + 8 );
+  const __m128 c3 = _mm_load_ps( _e + 12 );
+
+  // t0..t5 from the columns 2 and 3, t6..t11 from the columns 0 and 1
+  __m128 p0, q0, p1, q1;
+  Mat4Simd::minors( c2, c3, p0, q0 );
+  Mat4Simd::minors( c0, c1, p1, q1 );
+
+  alignas(16) float t[16];
+  _mm_store_ps( t,      p0 );
+  _mm_store_ps( t + 4,  q0 );
+  _mm_store_ps( t + 8,  p1 );
+  _mm_store_ps( t + 12, q1 );
+
+  // t0*t11 - t1*t10 + t2*t9 + t3*t8 - t4*t7 + t5*t6
+  float det = t[0]*t[13] - t[1]*t[12] + t[2]*t[11] + t[3]*t[10] - t[4]*t[9] + t[5]*t[8];
+
+  if( fabs( det ) < 1e-12 ) return Mat4<float>();
+
+  float idet = 1.0/det;
+
+  const __m128 sign  = _mm_setr_ps( 0.0f, -0.0f, 0.0f, -0.0f );
+  const __m128 nsign = _mm_setr_ps( -0.0f, 0.0f, -0.0f, 0.0f );
+  const __m128 s     = _mm_set1_ps( idet );
+
+  // rows of the result (scaled by det)
+  __m128 r0 = Mat4Simd::adjugate( c1, p0, q0, sign );
+  __m128 r1 = Mat4Simd::adjugate( c0, p0, q0, nsign );
+  __m128 r2 = Mat4Simd::adjugate( c3, p1, q1, sign );
+  __m128 r3 = Mat4Simd::adjugate( c2, p1, q1, nsign );
+  _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+
+  Mat4<float> m;
+  _mm_store_ps( m._e,      _mm_mul_ps( r0, s ) );
+  _mm_store_ps( m._e + 4,  _mm_mul_ps( r1, s ) );
+  _mm_store_ps( m._e + 8,  _mm_mul_ps( r2, s ) );
+  _mm_store_ps( m._e + 12, _mm_mul_ps( r3, s ) );
+  return m;
+}
+
+//------------------------------------------------------------------------------
+//!
+template<>
+inline Mat4<float> Mat4<float>::affineInverse() const
+{
+  const __m128 c0 = _mm_load_ps( _e );
+  const __m128 c1 = _mm_load_ps( _e + 4 );
+  const __m128 c2 = _mm_load_ps( _e + 8 );
+
+  // rows of the inverse 3x3 part (times det)
+  __m128 r0 = Mat4Simd::cross( c1, c2 );
+  __m128 r1 = Mat4Simd::cross( c2, c0 );
+  __m128 r2 = Mat4Simd::cross( c0, c1 );
+
+  alignas(16) float d[4];
+  _mm_store_ps( d, _mm_mul_ps( c0, r0 ) );
+  float det = d[0] + d[1] + d[2];
+
+  if( fabs( det ) < 1e-12 ) return Mat4<float>();
+
+  float idet = 1.0/det;
+  const __m128 s = _mm_set1_ps( idet );
+
+  r0 = _mm_mul_ps( r0, s );
+  r1 = _mm_mul_ps( r1, s );
+  r2 = _mm_mul_ps( r2, s );
+  __m128 r3 = _mm_setzero_ps();
+  _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+
+  // -(A^-1 t), the w lane is set to 1 afterwards
+  __m128 t = _mm_mul_ps( r0, _mm_set1_ps( _e[12] ) );
+  t = _mm_add_ps( t, _mm_mul_ps( r1, _mm_set1_ps( _e[13] ) ) );
+  t = _mm_add_ps( t, _mm_mul_ps( r2, _mm_set1_ps( _e[14] ) ) );
+  t = _mm_xor_ps( t, _mm_set1_ps( -0.0f ) );
+
+  Mat4<float> m;
+  _mm_store_ps( m._e,      r0 );
+  _mm_store_ps( m._e + 4,  r1 );
+  _mm_store_ps( m._e + 8,  r2 );
+  _mm_store_ps( m._e + 12, t );
+  m._e[3] = m._e[7] = m._e[11] = 0;
+  m._e[15] = 1;
+  return m;
+}
+
+#ifdef __AVX__
+
+namespace Mat4Simd
+{
+  // ((c0*v0 + c1*v1) + c2*v2) + c3*v3
+  inline __m256d combine( __m256d c0, __m256d c1, __m256d c2, __m256d c3, const double *v )
+  {
+    __m256d r = _mm256_mul_pd( c0, _mm256_broadcast_sd( v ) );
+    r = _mm256_add_pd( r, _mm256_mul_pd( c1, _mm256_broadcast_sd( v + 1 ) ) );
+    r = _mm256_add_pd( r, _mm256_mul_pd( c2, _mm256_broadcast_sd( v + 2 ) ) );
+    return _mm256_add_pd( r, _mm256_mul_pd( c3, _mm256_broadcast_sd( v + 3 ) ) );
+  }
+}
+
+// Mat4d is only 16 bytes aligned: unaligned loads
+
+//------------------------------------------------------------------------------
+//!
+template<>
+inline constexpr Mat4<double> Mat4<double>::operator*( const Mat4<double>& m ) const
+{
+  if( MAT4SIMD_CONSTANT_EVALUATED() ) return Mat4Simd::product( *this, m );
+
+  const __m256d c0 = _mm256_loadu_pd( _e );
+  const __m256d c1 = _mm256_loadu_pd( _e + 4 );
+  const __m256d c2 = _mm256_loadu_pd( _e + 8 );
+  const __m256d c3 = _mm256_loadu_pd( _e + 12 );
+
+  Mat4<double> r;
+  _mm256_storeu_pd( r._e,      Mat4Simd::combine( c0, c1, c2, c3, m._e ) );
+  _mm256_storeu_pd( r._e + 4,  Mat4Simd::combine( c0, c1, c2, c3, m._e + 4 ) );
+  _mm256_storeu_pd( r._e + 8,  Mat4Simd::combine( c0, c1, c2, c3, m._e + 8 ) );
+  _mm256_storeu_pd( r._e + 12, Mat4Simd::combine( c0, c1, c2, c3, m._e + 12 ) );
+  return r;
+}
+
+//------------------------------------------------------------------------------
+//!
+template<>
+inline constexpr Mat4<double>& Mat4<double>::operator*=( const Mat4<double>& m )
+{
+  return *this = *this * m;
+}
+
+//------------------------------------------------------------------------------
+//!
+template<>
+inline constexpr Vec4<double> Mat4<double>::operator*( const Vec4<double>& vec ) const
+{
+  if( MAT4SIMD_CONSTANT_EVALUATED() ) return Mat4Simd::product( *this, vec );
+
+  Vec4<double> r;
+  _mm256_storeu_pd( r.ptr(), Mat4Simd::combine( _mm256_loadu_pd( _e ), _mm256_loadu_pd( _e + 4 ),
+                                                _mm256_loadu_pd( _e + 8 ), _mm256_loadu_pd( _e + 12 ), vec.ptr() ) );
+  return r;
+}
+
+//------------------------------------------------------------------------------
+//!
+template<>
+inline constexpr Mat4<double> Mat4<double>::transpose() const
+{
+  if( MAT4SIMD_CONSTANT_EVALUATED() ) return Mat4Simd::transpose( *this );
+
+  const __m256d c0 = _mm256_loadu_pd( _e );
+  const __m256d c1 = _mm256_loadu_pd( _e + 4 );
+  const __m256d c2 = _mm256_loadu_pd( _e + 8 );
+  const __m256d c3 = _mm256_loadu_pd( _e + 12 );
+
+  // ( 0 4 2 6 ) ( 1 5 3 7 ) ( 8 12 10 14 ) ( 9 13 11 15 )
+  const __m256d l0 = _mm256_unpacklo_pd( c0, c1 );
+  const __m256d h0 = _mm256_unpackhi_pd( c0, c1 );
+  const __m256d l1 = _mm256_unpacklo_pd( c2, c3 );
+  const __m256d h1 = _mm256_unpackhi_pd( c2, c3 );
+
+  Mat4<double> r;
+  _mm256_storeu_pd( r._e,      _mm256_permute2f128_pd( l0, l1, 0x20 ) );
+  _mm256_storeu_pd( r._e + 4,  _mm256_permute2f128_pd( h0, h1, 0x20 ) );
+  _mm256_storeu_pd( r._e + 8,  _mm256_permute2f128_pd( l0, l1, 0x31 ) );
+  _mm256_storeu_pd( r._e + 12, _mm256_permute2f128_pd( h0, h1, 0x31 ) );
+  return r;
+}
+
+#endif // __AVX__
+
+#endif // SIM_NO_SIMD
+
+#endif // MAT4SIMD_H
@@ -0,0 +1,174 @@
+#include "meshArena.h"
+
+#include <stddef.h>
+
+RangeAllocator::RangeAllocator(GLuint size)
+  : _size(0) {
+  grow(size);
+}
+
+bool RangeAllocator::alloc(GLuint size,GLuint &offset) {
+  // nothing (point clouds have no indices)
+  if(size==0) {
+    offset = 0;
+    return true;
+  }
+
+  for(std::map<GLuint,GLuint>::iterator it=_free.begin();it!=_free.end();++it) {
+    if(it->second<size)
+      continue;
+
+    // take the beginning of the free range
+    offset = it->first;
+    if(it->second>size)
+      _free[it->first+size] = it->second-size;
+    _free.erase(it);
+    return true;
+  }
+
+  return false;
+}
+
+void RangeAllocator::release(GLuint offset,GLuint size) {
+  if(size==0)
+    return;
+
+  std::map<GLuint,GLuint>::iterator it = _free.insert(std::make_pair(offset,size)).first;
+
+  // merge with the next free range
+  std::map<GLuint,GLuint>::iterator next = it;
+  ++next;
+  if(next!=_free.end() && it->first+it->second==next->first) {
+    it->second += next->second;
+    _free.erase(next);
+  }
+
+  // and with the previous one
+  if(it!=_free.begin()) {
+    std::map<GLuint,GLuint>::iterator prev = it;
+    --prev;
+    if(prev->first+prev->second==it->first) {
+      prev->second += it->second;
+      _free.erase(it);
+    }
+  }
+}
+
+void RangeAllocator::grow(GLuint size) {
+  if(size<=_size)
+    return;
+
+  const GLuint old = _size;
+  _size = size;
+  release(old,size-old);
+}
+
+MeshArena::MeshArena(GLuint nbVertices,GLuint nbIndices)
+  : _vertices(nbVertices),
+    _indices(nbIndices) {
+
+  glGenVertexArrays(1,&_vao);
+  glGenBuffers(1,&_vertexBuffer);
+  glGenBuffers(1,&_indexBuffer);
+
+  glBindBuffer(GL_ARRAY_BUFFER,_vertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER,nbVertices*3*sizeof(float),NULL,GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER,_indexBuffer);
+  glBufferData(GL_ARRAY_BUFFER,nbIndices*sizeof(GLuint),NULL,GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER,0);
+
+  bindBuffers();
+}
+
+MeshArena::~MeshArena() {
+  glDeleteBuffers(1,&_vertexBuffer);
+  glDeleteBuffers(1,&_indexBuffer);
+  glDeleteVertexArrays(1,&_vao);
+}
+
+void MeshArena::bindBuffers() {
+  glBindVertexArray(_vao);
+  glBindBuffer(GL_ARRAY_BUFFER,_vertexBuffer);
+  glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,0,(void *)0);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,_indexBuffer);
+  glBindVertexArray(0);
+}
+
+GLuint MeshArena::resize(GLuint buffer,GLsizeiptr oldSize,GLsizeiptr size) {
+  GLuint newBuffer;
+  glGenBuffers(1,&newBuffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER,newBuffer);
+  glBufferData(GL_COPY_WRITE_BUFFER,size,NULL,GL_STATIC_DRAW);
+
+  // GPU to GPU, the meshes are not uploaded again
+  glBindBuffer(GL_COPY_READ_BUFFER,buffer);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER,GL_COPY_WRITE_BUFFER,0,0,oldSize);
+
+  glBindBuffer(GL_COPY_READ_BUFFER,0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER,0);
+  glDeleteBuffers(1,&buffer);
+  return newBuffer;
+}
+
+MeshArena::Range MeshArena::add(const float *vertices,GLuint nbVertices,const GLuint *indices,GLuint nbIndices) {
+  Range r;
+  GLuint offset = 0;
+
+  // vertices (the buffers double until the mesh fits)
+  while(!_vertices.alloc(nbVertices,offset)) {
+    const GLuint size = 2*_vertices.size()>nbVertices ? 2*_vertices.size() : _vertices.size()+nbVertices;
+    _vertexBuffer = resize(_vertexBuffer,_vertices.size()*3*sizeof(float),size*3*sizeof(float));
+    _vertices.grow(size);
+    bindBuffers();
+  }
+  r.baseVertex = offset;
+  r.nbVertices = nbVertices;
+
+  // indices
+  r.firstIndex = allocIndices(nbIndices);
+  r.nbIndices  = nbIndices;
+
+  update(r,0,vertices,vertices ? nbVertices : 0,0,indices,indices ? nbIndices : 0);
+  return r;
+}
+
+GLuint MeshArena::allocIndices(GLuint nbIndices) {
+  GLuint offset = 0;
+  while(!_indices.alloc(nbIndices,offset)) {
+    const GLuint size = 2*_indices.size()>nbIndices ? 2*_indices.size() : _indices.size()+nbIndices;
+    _indexBuffer = resize(_indexBuffer,_indices.size()*sizeof(GLuint),size*sizeof(GLuint));
+    _indices.grow(size);
+    bindBuffers();
+  }
+  return offset;
+}
+
+void MeshArena::remove(const Range &r) {
+  _vertices.release(r.baseVertex,r.nbVertices);
+  _indices.release(r.firstIndex,r.nbIndices);
+}
+
+void MeshArena::update(const Range &r,GLuint firstVertex,const float *vertices,GLuint nbVertices,
+		       GLuint firstIndex,const GLuint *indices,GLuint nbIndices) {
+  if(nbVertices>0) {
+    glBindBuffer(GL_ARRAY_BUFFER,_vertexBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER,(r.baseVertex+firstVertex)*3*sizeof(float),nbVertices*3*sizeof(float),vertices);
+  }
+  if(nbIndices>0) {
+    glBindBuffer(GL_ARRAY_BUFFER,_indexBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER,(r.firstIndex+firstIndex)*sizeof(GLuint),nbIndices*sizeof(GLuint),indices);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER,0);
+}
+
+MeshArena::Range MeshArena::reserveIndices(const Range &r,GLuint nbIndices) {
+  Range n = r;
+  n.firstIndex = allocIndices(nbIndices);
+  n.nbIndices  = nbIndices;
+  return n;
+}
+
+void MeshArena::releaseIndices(const Range &r) {
+  _indices.release(r.firstIndex,r.nbIndices);
+}
@@ -0,0 +1,94 @@
+#ifndef MESH_ARENA_H
+#define MESH_ARENA_H
+
+// GLEW lib: needs to be included first!!
+#include <GL/glew.h>
+
+#include <map>
+
+// sub-allocation of [0,size) (in vertices, indices...): first fit in the
+// free ranges, which are merged with their neighbours when released
+class RangeAllocator {
+ public:
+  RangeAllocator(GLuint size=0);
+
+  // false if there is no free range of this size
+  bool alloc(GLuint size,GLuint &offset);
+  void release(GLuint offset,GLuint size);
+
+  // [size(),size) becomes free
+  void grow(GLuint size);
+
+  inline GLuint size() const {return _size;}
+
+ private:
+  std::map<GLuint,GLuint> _free; // offset -> size
+  GLuint                  _size;
+};
+
+// vertices and indices of many meshes in one vertex buffer and one index
+// buffer, with one VAO: drawing any of them needs no bind, only its range
+// (glDrawElementsBaseVertex, glMultiDrawElementsIndirect...).
+// Positions are attribute 0 (3 floats), indices are unsigned ints relative
+// to the first vertex of the mesh. Buffers that are full are replaced by
+// twice larger ones (copied on the GPU), ranges stay valid.
+class MeshArena {
+ public:
+  struct Range {
+    GLint  baseVertex;
+    GLuint nbVertices;
+    GLuint firstIndex;
+    GLuint nbIndices;
+  };
+
+  // glMultiDrawElementsIndirect command
+  struct DrawCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+  };
+
+  static inline DrawCommand command(const Range &r,GLuint nbInstances,GLuint baseInstance) {
+    const DrawCommand c = {r.nbIndices,nbInstances,r.firstIndex,r.baseVertex,baseInstance};
+    return c;
+  }
+
+  MeshArena(GLuint nbVertices,GLuint nbIndices);
+  ~MeshArena();
+
+  // vertices: 3*nbVertices floats. NULL vertices or indices are only
+  // allocated, for update()
+  Range add(const float *vertices,GLuint nbVertices,const GLuint *indices,GLuint nbIndices);
+  void  remove(const Range &r);
+
+  // part of a range: vertices [firstVertex,firstVertex+nbVertices) and
+  // indices [firstIndex,firstIndex+nbIndices), relative to r
+  void update(const Range &r,GLuint firstVertex,const float *vertices,GLuint nbVertices,
+	      GLuint firstIndex,const GLuint *indices,GLuint nbIndices);
+
+  // r with nbIndices new indices (uploaded with update()), same vertices:
+  // r is drawn until they are complete, then its indices are released
+  Range reserveIndices(const Range &r,GLuint nbIndices);
+  void  releaseIndices(const Range &r);
+
+  // offset of the first index of r, for the draw calls
+  static inline void *indexOffset(const Range &r) {return (void *)(r.firstIndex*sizeof(GLuint));}
+
+  inline GLuint vao() const {return _vao;}
+
+ private:
+  // new buffer of size bytes, with the content of the old one
+  static GLuint resize(GLuint buffer,GLsizeiptr oldSize,GLsizeiptr size);
+  void bindBuffers();
+  GLuint allocIndices(GLuint nbIndices); // offset, the buffer grows if needed
+
+  GLuint         _vao;
+  GLuint         _vertexBuffer;
+  GLuint         _indexBuffer;
+  RangeAllocator _vertices;
+  RangeAllocator _indices;
+};
+
+#endif // MESH_ARENA_H
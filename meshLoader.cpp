@@ -1,4 +1,6 @@
 #include "meshLoader.h"
+#include "trace.h"
+#include "perfcounters.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -22,7 +24,7 @@ float *Mesh::get_color(unsigned int i) {
 }
 
 
-Mesh::Mesh(char *filename) {
+Mesh::Mesh(char *filename,std::atomic<float> *progress,const std::atomic<bool> *cancel) {
   unsigned int tmp;
   unsigned int i,j;
   unsigned int *f;
@@ -37,13 +39,25 @@ Mesh::Mesh(char *filename) {
   int   error;
   float c[3] = {0.0,0.0,0.0};
   float r;
+  long  size = 0;
+
+  TRACE_SCOPE("Mesh::Mesh");
 
   setlocale(LC_ALL,"C");
 
+  TraceScope parseTrace("Mesh::parse");
+  PerfScope  parsePerf("Mesh::parse");
+
   if((file=fopen(filename,"r"))==NULL) {
     printf("Unable to read %s\n",filename);
   }
 
+  // for the progress
+  if(progress && file && fseek(file,0,SEEK_END)==0) {
+    size = ftell(file);
+    rewind(file);
+  }
+
   // create mesh
   vertices = NULL;
   normals  = NULL;
@@ -57,10 +71,13 @@ Mesh::Mesh(char *filename) {
 
   //printf("Found %d vertices and %d faces",nb_vertices,nb_faces);
 
+  // point clouds (no faces) only have positions
   vertices = (float *)malloc(3*nb_vertices*sizeof(float));
-  normals  = (float *)malloc(3*nb_vertices*sizeof(float));
-  colors   = (float *)malloc(3*nb_vertices*sizeof(float));
-  faces    = (unsigned int *)malloc(3*nb_faces*sizeof(unsigned int));
+  if(nb_faces>0) {
+    normals = (float *)malloc(3*nb_vertices*sizeof(float));
+    colors  = (float *)malloc(3*nb_vertices*sizeof(float));
+    faces   = (unsigned int *)malloc(3*nb_faces*sizeof(unsigned int));
+  }
 
   // reading vertices
   j = 0;
@@ -73,6 +90,13 @@ Mesh::Mesh(char *filename) {
     }
 
     j += 3;
+
+    if(progress && size>0 && (i&0xffff)==0)
+      progress->store((float)ftell(file)/size);
+    if(cancel && (i&0xffff)==0 && cancel->load()) {
+      nb_vertices = i+1;
+      nb_faces    = 0;
+    }
   }
 
   // reading faces
@@ -91,9 +115,30 @@ Mesh::Mesh(char *filename) {
       // return NULL;
     }
     j += 3;
+
+    if(progress && size>0 && (i&0xffff)==0)
+      progress->store((float)ftell(file)/size);
+    if(cancel && (i&0xffff)==0 && cancel->load())
+      nb_faces = 0;
+  }
+
+  // cancelled: no faces, as a point cloud
+  if(nb_faces==0 && faces) {
+    free(normals);
+    free(colors);
+    free(faces);
+    normals = NULL;
+    colors  = NULL;
+    faces   = NULL;
   }
   
   fclose(file); 
+  parsePerf.setElements(nb_vertices+nb_faces);
+  parsePerf.end();
+  parseTrace.end();
+
+  TraceScope centerTrace("Mesh::center");
+  PerfScope  centerPerf("Mesh::center",nb_vertices);
 
   // computing center
   for(i=0;i<nb_vertices*3;i+=3) {
@@ -115,6 +160,15 @@ Mesh::Mesh(char *filename) {
     r = sqrt(c[0]*c[0]+c[1]*c[1]+c[2]*c[2]);
     radius = r>radius ? r : radius;
   }
+  centerPerf.end();
+  centerTrace.end();
+
+  // no normals (nor colors) without faces
+  if(nb_faces==0)
+    return;
+
+  TraceScope normalsTrace("Mesh::normals");
+  PerfScope  normalsPerf("Mesh::normals",nb_faces);
 
   // computing normals per faces
   nf = (float *)malloc(3*nb_faces*sizeof(float));
@@ -185,6 +239,11 @@ Mesh::Mesh(char *filename) {
 
   free(nf);
   free(nv);
+  normalsPerf.end();
+  normalsTrace.end();
+
+  TraceScope colorsTrace("Mesh::colors");
+  PerfScope  colorsPerf("Mesh::colors",nb_vertices);
 
   // computing colors as normals 
   for(i=0;i<3*nb_vertices;++i) {
@@ -1,9 +1,16 @@
 #ifndef MESH_LOADER_H
 #define MESH_LOADER_H
 
+#include <stddef.h>
+#include <atomic>
+
 class Mesh {
  public:
-  Mesh(char *filename);
+  // progress: if not NULL, the part of the file already parsed (0 to 1),
+  // updated while it loads (read by another thread). cancel: if not NULL
+  // and set (by another thread), the parsing stops, the mesh keeps the
+  // vertices read so far and no face
+  Mesh(char *filename,std::atomic<float> *progress=NULL,const std::atomic<bool> *cancel=NULL);
   ~Mesh();
 
   unsigned int *get_face(unsigned int i);
@@ -15,7 +22,7 @@ class Mesh {
   unsigned int  nb_vertices;
   unsigned int  nb_faces;
   
-  // data
+  // data (normals, colors and faces are NULL for a point cloud)
   float        *vertices;
   float        *normals;
   float        *colors;
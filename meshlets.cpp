@@ -0,0 +1,136 @@
+#include "meshlets.h"
+
+#include <algorithm>
+#include <math.h>
+
+static inline Vec3f vertex(const float *vertices,unsigned int i) {
+  return Vec3f(vertices[3*i],vertices[3*i+1],vertices[3*i+2]);
+}
+
+void Meshlets::build(const float *vertices,unsigned int nbVertices,
+		     const unsigned int *faces,unsigned int nbFaces,
+		     std::vector<unsigned int> &indices) {
+  _meshlets.clear();
+  indices.clear();
+  indices.reserve(3*nbFaces);
+
+  // triangles around each vertex
+  std::vector<unsigned int> first(nbVertices+1,0);
+  for(unsigned int i=0;i<3*nbFaces;++i)
+    first[faces[i]+1]++;
+  for(unsigned int v=0;v<nbVertices;++v)
+    first[v+1] += first[v];
+  std::vector<unsigned int> around(3*nbFaces);
+  std::vector<unsigned int> next(first.begin(),first.end()-1);
+  for(unsigned int i=0;i<3*nbFaces;++i)
+    around[next[faces[i]]++] = i/3;
+
+  std::vector<bool>         used(nbFaces,false);
+  std::vector<unsigned int> stamp(nbVertices,~0u); // meshlet that has the vertex
+  std::vector<unsigned int> candidates;
+
+  for(unsigned int seed=0;seed<nbFaces;++seed) {
+    if(used[seed])
+      continue;
+
+    // grows from the seed through the neighbour triangles, as long as
+    // they fit (the others are left for the next meshlets)
+    const unsigned int id = _meshlets.size();
+    Meshlet m;
+    m.firstIndex = indices.size();
+    m.nbIndices  = 0;
+
+    unsigned int nbUsedVertices = 0;
+    candidates.clear();
+    candidates.push_back(seed);
+
+    for(unsigned int c=0;c<candidates.size() && m.nbIndices<3*MAX_TRIANGLES;++c) {
+      const unsigned int  t = candidates[c];
+      const unsigned int *f = faces+3*t;
+      if(used[t])
+	continue;
+
+      unsigned int added = 0;
+      for(int k=0;k<3;++k)
+	added += stamp[f[k]]!=id && (k<1 || f[k]!=f[0]) && (k<2 || f[k]!=f[1]);
+      if(nbUsedVertices+added>MAX_VERTICES)
+	continue;
+
+      used[t] = true;
+      nbUsedVertices += added;
+      for(int k=0;k<3;++k) {
+	stamp[f[k]] = id;
+	indices.push_back(f[k]);
+	for(unsigned int j=first[f[k]];j<first[f[k]+1];++j) {
+	  if(!used[around[j]])
+	    candidates.push_back(around[j]);
+	}
+      }
+      m.nbIndices += 3;
+    }
+
+    bounds(vertices,&indices[m.firstIndex],m);
+    _meshlets.push_back(m);
+  }
+}
+
+void Meshlets::bounds(const float *vertices,const unsigned int *indices,Meshlet &m) {
+  // sphere around the bounding box
+  Vec3f min = vertex(vertices,indices[0]),max = min;
+  for(unsigned int i=1;i<m.nbIndices;++i) {
+    const float *v = vertices+3*indices[i];
+    for(int k=0;k<3;++k) {
+      min[k] = std::min(min[k],v[k]);
+      max[k] = std::max(max[k],v[k]);
+    }
+  }
+  m.center = (min+max)*0.5f;
+  m.radius = 0.0f;
+  for(unsigned int i=0;i<m.nbIndices;++i)
+    m.radius = std::max(m.radius,(vertex(vertices,indices[i])-m.center).length());
+
+  // cone: average of the unit normals, and the largest angle to it
+  std::vector<Vec3f> normals;
+  normals.reserve(m.nbIndices/3);
+  Vec3f axis(0.0f,0.0f,0.0f);
+  for(unsigned int i=0;i<m.nbIndices;i+=3) {
+    const Vec3f v0 = vertex(vertices,indices[i]);
+    const Vec3f n = (vertex(vertices,indices[i+1])-v0).cross(vertex(vertices,indices[i+2])-v0);
+    const float l = n.length();
+    if(l>0.0f) {
+      normals.push_back(n/l);
+      axis += normals.back();
+    }
+  }
+
+  m.axis   = axis;
+  m.cutoff = 1.0f;
+  const float l = axis.length();
+  if(l==0.0f)
+    return;
+  m.axis = axis/l;
+
+  float mindp = 1.0f;
+  for(unsigned int i=0;i<normals.size();++i)
+    mindp = std::min(mindp,normals[i].dot(m.axis));
+
+  // wider than a half sphere (almost): always seen from the front somewhere
+  if(mindp>0.1f)
+    m.cutoff = sqrt(1.0f-mindp*mindp);
+}
+
+void Meshlets::cull(const Frustum &f,const Vec3f &eye,bool backfaces,std::vector<unsigned int> &visible) const {
+  for(unsigned int i=0;i<_meshlets.size();++i) {
+    const Meshlet &m = _meshlets[i];
+
+    // every triangle faces away from any point of the sphere
+    if(backfaces) {
+      const Vec3f d = m.center-eye;
+      if(d.dot(m.axis)>=m.cutoff*d.length()+m.radius)
+	continue;
+    }
+
+    if(f.classify(Box::sphere(m.center,m.radius))!=Frustum::OUTSIDE)
+      visible.push_back(i);
+  }
+}
@@ -0,0 +1,48 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <vector>
+#include "vec3.h"
+#include "bvh.h"
+
+// small clusters of neighbour triangles (up to 64 vertices and 124
+// triangles), culled one by one on the CPU before drawing the rest:
+//  - bounding sphere against the frustum
+//  - normal cone: all the triangle normals are within a cone around the
+//    axis, the whole cluster faces away from the eye when it sees the
+//    sphere from inside the "back" cone (triangles counter clockwise seen
+//    from the front, as OpenGL)
+// The faces of the mesh are reordered so that each meshlet is a contiguous
+// range of indices: a draw (or a command of a multi-draw) per meshlet.
+struct Meshlet {
+  unsigned int firstIndex; // in the reordered indices
+  unsigned int nbIndices;  // 3 per triangle
+  Vec3f        center;     // bounding sphere
+  float        radius;
+  Vec3f        axis;       // normal cone
+  float        cutoff;     // sin of the cone angle, 1 if it can never be culled
+};
+
+class Meshlets {
+ public:
+  enum {MAX_VERTICES=64, MAX_TRIANGLES=124};
+
+  // indices: the nbFaces triangles of faces, in the order of the meshlets
+  void build(const float *vertices,unsigned int nbVertices,
+	     const unsigned int *faces,unsigned int nbFaces,
+	     std::vector<unsigned int> &indices);
+
+  // appends the meshlets in f (mesh -> clip space) and, if backfaces is
+  // set, not facing away from eye (in mesh space)
+  void cull(const Frustum &f,const Vec3f &eye,bool backfaces,std::vector<unsigned int> &visible) const;
+
+  inline unsigned int   size() const {return _meshlets.size();}
+  inline const Meshlet &operator[](unsigned int i) const {return _meshlets[i];}
+
+ private:
+  void bounds(const float *vertices,const unsigned int *indices,Meshlet &m);
+
+  std::vector<Meshlet> _meshlets;
+};
+
+#endif // MESHLETS_H
@@ -0,0 +1,339 @@
+#include "occlusion.h"
+#include "transform.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define OCCLUSION_AVX2 1
+#define AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+  std::atomic<bool> simdEnabled(true);
+
+  // triangle in pixels: edge functions a*x+b*y+c >= 0 inside, and depth
+  // plane z = dzdx*x+(dzdy*y+z0), evaluated at the pixel centers
+  struct Setup {
+    float a[3],b[3],c[3];
+    float dzdx,dzdy,z0;
+    int   xmin,xmax,ymin,ymax; // inclusive
+  };
+
+  // same operation order as the AVX2 version
+  void rowScalar(const Setup &s,float *row,int y,int x0,int x1) {
+    const float py = (float)y+0.5f;
+    const float e0 = s.b[0]*py+s.c[0];
+    const float e1 = s.b[1]*py+s.c[1];
+    const float e2 = s.b[2]*py+s.c[2];
+    const float zy = s.dzdy*py+s.z0;
+
+    for(int x=x0;x<=x1;++x) {
+      const float px = (float)x+0.5f;
+      if(s.a[0]*px+e0>=0.0f && s.a[1]*px+e1>=0.0f && s.a[2]*px+e2>=0.0f)
+	row[x] = std::min(row[x],s.dzdx*px+zy);
+    }
+  }
+
+#ifdef OCCLUSION_AVX2
+
+  // 8 pixels at once, the lanes out of [x0,x1] are masked
+  AVX2 void rowAvx2(const Setup &s,float *row,int y,int x0,int x1) {
+    const float  py   = (float)y+0.5f;
+    const __m256 e0   = _mm256_set1_ps(s.b[0]*py+s.c[0]);
+    const __m256 e1   = _mm256_set1_ps(s.b[1]*py+s.c[1]);
+    const __m256 e2   = _mm256_set1_ps(s.b[2]*py+s.c[2]);
+    const __m256 zy   = _mm256_set1_ps(s.dzdy*py+s.z0);
+    const __m256 a0   = _mm256_set1_ps(s.a[0]);
+    const __m256 a1   = _mm256_set1_ps(s.a[1]);
+    const __m256 a2   = _mm256_set1_ps(s.a[2]);
+    const __m256 dzdx = _mm256_set1_ps(s.dzdx);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 offs = _mm256_setr_ps(0.5f,1.5f,2.5f,3.5f,4.5f,5.5f,6.5f,7.5f);
+    const __m256 lo   = _mm256_set1_ps((float)x0);
+    const __m256 hi   = _mm256_set1_ps((float)x1+1.0f);
+
+    for(int x=x0&~7;x<=x1;x+=8) {
+      const __m256 px = _mm256_add_ps(_mm256_set1_ps((float)x),offs);
+
+      __m256 in = _mm256_and_ps(_mm256_cmp_ps(px,lo,_CMP_GT_OQ),_mm256_cmp_ps(px,hi,_CMP_LT_OQ));
+      in = _mm256_and_ps(in,_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a0,px),e0),zero,_CMP_GE_OQ));
+      in = _mm256_and_ps(in,_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a1,px),e1),zero,_CMP_GE_OQ));
+      in = _mm256_and_ps(in,_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a2,px),e2),zero,_CMP_GE_OQ));
+      if(_mm256_movemask_ps(in)==0)
+	continue;
+
+      const __m256 old = _mm256_loadu_ps(row+x);
+      const __m256 z   = _mm256_min_ps(_mm256_add_ps(_mm256_mul_ps(dzdx,px),zy),old);
+      _mm256_storeu_ps(row+x,_mm256_blendv_ps(old,z,in));
+    }
+  }
+
+  // farthest depth of the 8x8 tiles of the rows y..y+7
+  AVX2 void tilesAvx2(const float *depth,unsigned int w,float *tiles) {
+    for(unsigned int x=0;x<w;x+=8) {
+      __m256 m = _mm256_loadu_ps(depth+x);
+      for(unsigned int j=1;j<8;++j)
+	m = _mm256_max_ps(m,_mm256_loadu_ps(depth+j*w+x));
+
+      // horizontal max
+      __m128 h = _mm_max_ps(_mm256_castps256_ps128(m),_mm256_extractf128_ps(m,1));
+      h = _mm_max_ps(h,_mm_movehl_ps(h,h));
+      h = _mm_max_ss(h,_mm_shuffle_ps(h,h,1));
+      tiles[x/8] = _mm_cvtss_f32(h);
+    }
+  }
+
+#endif
+
+}
+
+bool Occlusion::simd() {
+#ifdef OCCLUSION_AVX2
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2 && simdEnabled.load(std::memory_order_relaxed);
+#else
+  return false;
+#endif
+}
+
+void Occlusion::setSimd(bool enabled) {
+  simdEnabled.store(enabled);
+}
+
+Occlusion::Occlusion(unsigned int w,unsigned int h)
+  : _w(w),
+    _h(h),
+    _depth(w*h,1.0f),
+    _tiles((w/8)*(h/8),1.0f),
+    _mvp(Mat4f::identity()),
+    _pending(false),
+    _quit(false) {
+
+  _thread = std::thread(&Occlusion::run,this);
+}
+
+Occlusion::~Occlusion() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _quit = true;
+  }
+  _cond.notify_all();
+  _thread.join();
+}
+
+void Occlusion::addOccluder(const float *vertices,unsigned int nbVertices,
+			    const unsigned int *faces,unsigned int nbFaces,
+			    const Mat4f &m,unsigned int maxFaces) {
+  const unsigned int first = _vertices.size()/3;
+  const unsigned int step  = nbFaces>maxFaces ? (nbFaces+maxFaces-1)/maxFaces : 1;
+
+  for(unsigned int i=0;i<nbVertices;++i) {
+    const Vec4f v = m*Vec4f(vertices[3*i],vertices[3*i+1],vertices[3*i+2],1.0f);
+    _vertices.push_back(v[0]);
+    _vertices.push_back(v[1]);
+    _vertices.push_back(v[2]);
+  }
+
+  for(unsigned int i=0;i<nbFaces;i+=step) {
+    _faces.push_back(first+faces[3*i]);
+    _faces.push_back(first+faces[3*i+1]);
+    _faces.push_back(first+faces[3*i+2]);
+  }
+
+  _clip.resize(4*_vertices.size()/3);
+}
+
+void Occlusion::clearOccluders() {
+  _vertices.clear();
+  _faces.clear();
+  _clip.clear();
+}
+
+void Occlusion::render(const Mat4f &mvp) {
+  _mvp = mvp;
+  rasterize(mvp);
+}
+
+void Occlusion::renderAsync(const Mat4f &mvp) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _mvp     = mvp;
+    _pending = true;
+  }
+  _cond.notify_all();
+}
+
+void Occlusion::wait() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _cond.wait(lock,[this]() {return !_pending;});
+}
+
+void Occlusion::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  for(;;) {
+    _cond.wait(lock,[this]() {return _pending || _quit;});
+    if(_quit)
+      return;
+
+    const Mat4f mvp = _mvp;
+    lock.unlock();
+    rasterize(mvp);
+    lock.lock();
+
+    _pending = false;
+    _cond.notify_all();
+  }
+}
+
+void Occlusion::rasterize(const Mat4f &mvp) {
+  TRACE_SCOPE("Occlusion::rasterize");
+
+  std::fill(_depth.begin(),_depth.end(),1.0f);
+
+  // all the occluder vertices at once (batched, AVX2)
+  const unsigned int n = _vertices.size()/3;
+  if(n>0)
+    Transform::points(mvp,&_vertices[0],&_clip[0],n);
+
+  for(unsigned int i=0;i<_faces.size();i+=3)
+    triangle(&_clip[4*_faces[i]],&_clip[4*_faces[i+1]],&_clip[4*_faces[i+2]]);
+
+  buildTiles();
+}
+
+void Occlusion::triangle(const float *c0,const float *c1,const float *c2) {
+  // crossing the near plane: dropped (no clipping, occluders are optional)
+  if(c0[2]<-c0[3] || c1[2]<-c1[3] || c2[2]<-c2[3])
+    return;
+
+  // pixels (origin at the bottom left, as OpenGL) and ndc depth
+  const float *c[3] = {c0,c1,c2};
+  float x[3],y[3],z[3];
+  for(int i=0;i<3;++i) {
+    x[i] = (c[i][0]/c[i][3]*0.5f+0.5f)*_w;
+    y[i] = (c[i][1]/c[i][3]*0.5f+0.5f)*_h;
+    z[i] = c[i][2]/c[i][3];
+  }
+
+  // counter clockwise
+  float area = (x[1]-x[0])*(y[2]-y[0])-(x[2]-x[0])*(y[1]-y[0]);
+  if(area==0.0f)
+    return;
+  if(area<0.0f) {
+    std::swap(x[1],x[2]);
+    std::swap(y[1],y[2]);
+    std::swap(z[1],z[2]);
+    area = -area;
+  }
+
+  Setup s;
+  s.xmin = std::max(0,(int)floorf(std::min(x[0],std::min(x[1],x[2]))));
+  s.xmax = std::min((int)_w-1,(int)ceilf(std::max(x[0],std::max(x[1],x[2]))));
+  s.ymin = std::max(0,(int)floorf(std::min(y[0],std::min(y[1],y[2]))));
+  s.ymax = std::min((int)_h-1,(int)ceilf(std::max(y[0],std::max(y[1],y[2]))));
+  if(s.xmin>s.xmax || s.ymin>s.ymax)
+    return;
+
+  // edge i goes from vertex i to vertex i+1
+  for(int i=0;i<3;++i) {
+    const int j = (i+1)%3;
+    s.a[i] = y[i]-y[j];
+    s.b[i] = x[j]-x[i];
+    s.c[i] = x[i]*y[j]-x[j]*y[i];
+  }
+
+  s.dzdx = ((z[1]-z[0])*(y[2]-y[0])-(z[2]-z[0])*(y[1]-y[0]))/area;
+  s.dzdy = ((x[1]-x[0])*(z[2]-z[0])-(x[2]-x[0])*(z[1]-z[0]))/area;
+  s.z0   = z[0]-s.dzdx*x[0]-s.dzdy*y[0];
+
+#ifdef OCCLUSION_AVX2
+  if(simd()) {
+    for(int py=s.ymin;py<=s.ymax;++py)
+      rowAvx2(s,&_depth[py*_w],py,s.xmin,s.xmax);
+    return;
+  }
+#endif
+
+  for(int py=s.ymin;py<=s.ymax;++py)
+    rowScalar(s,&_depth[py*_w],py,s.xmin,s.xmax);
+}
+
+void Occlusion::buildTiles() {
+  const unsigned int tw = _w/8;
+
+  for(unsigned int ty=0;ty<_h/8;++ty) {
+    const float *rows = &_depth[8*ty*_w];
+
+#ifdef OCCLUSION_AVX2
+    if(simd()) {
+      tilesAvx2(rows,_w,&_tiles[ty*tw]);
+      continue;
+    }
+#endif
+
+    for(unsigned int tx=0;tx<tw;++tx) {
+      float m = rows[8*tx];
+      for(unsigned int j=0;j<8;++j) {
+	for(unsigned int i=0;i<8;++i)
+	  m = std::max(m,rows[j*_w+8*tx+i]);
+      }
+      _tiles[ty*tw+tx] = m;
+    }
+  }
+}
+
+bool Occlusion::visible(const Box &b) const {
+  // screen rectangle and nearest depth of the 8 corners
+  float xmin = (float)_w,xmax = 0.0f,ymin = (float)_h,ymax = 0.0f,zmin = 1.0f;
+
+  for(int i=0;i<8;++i) {
+    const Vec4f c = _mvp*Vec4f(i&1 ? b.max[0] : b.min[0],
+			       i&2 ? b.max[1] : b.min[1],
+			       i&4 ? b.max[2] : b.min[2],1.0f);
+    if(c[2]<-c[3])
+      return true;
+
+    const float x = (c[0]/c[3]*0.5f+0.5f)*_w;
+    const float y = (c[1]/c[3]*0.5f+0.5f)*_h;
+    xmin = std::min(xmin,x);
+    xmax = std::max(xmax,x);
+    ymin = std::min(ymin,y);
+    ymax = std::max(ymax,y);
+    zmin = std::min(zmin,c[2]/c[3]);
+  }
+
+  // pixels whose center may be covered
+  const int x0 = std::max(0,(int)floorf(xmin));
+  const int x1 = std::min((int)_w-1,(int)ceilf(xmax));
+  const int y0 = std::max(0,(int)floorf(ymin));
+  const int y1 = std::min((int)_h-1,(int)ceilf(ymax));
+  if(x0>x1 || y0>y1)
+    return false;
+
+  const unsigned int tw = _w/8;
+  for(int ty=y0/8;ty<=y1/8;++ty) {
+    for(int tx=x0/8;tx<=x1/8;++tx) {
+      // whole tile in front of the box
+      if(_tiles[ty*tw+tx]<zmin)
+	continue;
+
+      // the pixels of the rectangle in this tile
+      const int px0 = std::max(x0,8*tx),px1 = std::min(x1,8*tx+7);
+      const int py0 = std::max(y0,8*ty),py1 = std::min(y1,8*ty+7);
+      for(int py=py0;py<=py1;++py) {
+	for(int px=px0;px<=px1;++px) {
+	  if(_depth[py*_w+px]>=zmin)
+	    return true;
+	}
+      }
+    }
+  }
+
+  return false;
+}
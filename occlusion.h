@@ -0,0 +1,82 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "mat4.h"
+#include "bvh.h"
+
+// software occlusion culling: a few occluder meshes are rasterized on the
+// CPU in a small depth-only buffer (no color, no perspective correction:
+// z/w is linear in screen space), then the boxes of the objects are tested
+// against it. The buffer is split in 8x8 tiles keeping their farthest
+// depth: a box is hidden if its nearest depth is behind the farthest depth
+// of every tile it covers (the pixels are only read for the tiles where
+// this is not enough).
+//
+// Conservative: occluder triangles crossing the near plane are dropped,
+// boxes crossing it are visible. Rows of 8 pixels are rasterized with AVX2
+// when the CPU has it, with the same results as the scalar code.
+//
+// The rasterization runs on a worker thread (renderAsync), while the main
+// thread does something else (culling, first draws, the GPU still working
+// on the previous frame...), wait() before testing.
+class Occlusion {
+ public:
+  // width and height: multiples of 8
+  Occlusion(unsigned int w=256,unsigned int h=128);
+  ~Occlusion();
+
+  // m: from the mesh to the space of the boxes. At most maxFaces triangles
+  // are kept (one every nbFaces/maxFaces): fewer occluders only hide less
+  void addOccluder(const float *vertices,unsigned int nbVertices,
+		   const unsigned int *faces,unsigned int nbFaces,
+		   const Mat4f &m,unsigned int maxFaces=4096);
+  void clearOccluders();
+
+  // mvp: from the space of the boxes to clip space
+  void render(const Mat4f &mvp);
+  void renderAsync(const Mat4f &mvp);
+  void wait();
+
+  // false if b is hidden by the occluders of the last render (or out of the
+  // screen)
+  bool visible(const Box &b) const;
+
+  inline unsigned int w() const {return _w;}
+  inline unsigned int h() const {return _h;}
+  inline unsigned int nbOccluderFaces() const {return _faces.size()/3;}
+  inline const float *depth() const {return &_depth[0];} // ndc z, row by row
+
+  // true if the AVX2 rasterizer is used
+  static bool simd();
+
+  // false: the scalar code even with AVX2 (bench --check compares both)
+  static void setSimd(bool enabled);
+
+ private:
+  void rasterize(const Mat4f &mvp);
+  void triangle(const float *c0,const float *c1,const float *c2);
+  void buildTiles();
+  void run(); // worker thread
+
+  unsigned int       _w;
+  unsigned int       _h;
+  std::vector<float> _depth; // w*h
+  std::vector<float> _tiles; // (w/8)*(h/8), farthest depth of each tile
+
+  std::vector<float>        _vertices; // xyz
+  std::vector<unsigned int> _faces;
+  std::vector<float>        _clip;     // xyzw of the vertices
+
+  Mat4f                   _mvp; // of the last render
+  std::thread             _thread;
+  std::mutex              _mutex;
+  std::condition_variable _cond;
+  bool                    _pending;
+  bool                    _quit;
+};
+
+#endif // OCCLUSION_H
@@ -0,0 +1,58 @@
+#include "occlusionQueries.h"
+
+OcclusionQueries::OcclusionQueries(unsigned int nbItems)
+  : _queries(2*nbItems,0),
+    _issued(2*nbItems,false),
+    _visible(nbItems,true),
+    _frame(0) {
+
+  if(nbItems>0)
+    glGenQueries(2*nbItems,&_queries[0]);
+}
+
+OcclusionQueries::~OcclusionQueries() {
+  if(!_queries.empty())
+    glDeleteQueries(_queries.size(),&_queries[0]);
+}
+
+void OcclusionQueries::newFrame() {
+  _frame++;
+
+  const unsigned int previous = _frame-1;
+  for(unsigned int i=0;i<_visible.size();++i) {
+    bool visible = true;
+
+    // not issued (culled by the frustum...) or not available yet: visible
+    if(_issued[2*i+previous%2]) {
+      GLuint available = GL_FALSE;
+      glGetQueryObjectuiv(query(i,previous),GL_QUERY_RESULT_AVAILABLE,&available);
+      if(available) {
+	GLuint passed = GL_TRUE;
+	glGetQueryObjectuiv(query(i,previous),GL_QUERY_RESULT,&passed);
+	visible = passed!=GL_FALSE;
+      }
+    }
+
+    _visible[i] = visible;
+
+    // set again by begin() if the item is drawn in this frame
+    _issued[2*i+_frame%2] = false;
+  }
+}
+
+void OcclusionQueries::begin(unsigned int i) {
+  _issued[2*i+_frame%2] = true;
+  glBeginQuery(GL_ANY_SAMPLES_PASSED,query(i,_frame));
+}
+
+void OcclusionQueries::end() {
+  glEndQuery(GL_ANY_SAMPLES_PASSED);
+}
+
+void OcclusionQueries::beginConditional(unsigned int i) {
+  glBeginConditionalRender(query(i,_frame),GL_QUERY_NO_WAIT);
+}
+
+void OcclusionQueries::endConditional() {
+  glEndConditionalRender();
+}
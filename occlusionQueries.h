@@ -0,0 +1,50 @@
+#ifndef OCCLUSION_QUERIES_H
+#define OCCLUSION_QUERIES_H
+
+// GLEW lib: needs to be included first!!
+#include <GL/glew.h>
+
+#include <vector>
+
+// GPU occlusion culling with temporal coherence: one GL_ANY_SAMPLES_PASSED
+// query per item (object, terrain chunk...) and per frame parity. The
+// results of the previous frame are only polled (never waited for):
+//  - items visible in the previous frame (or not known yet) are drawn
+//    normally, inside their query, which tells whether they still are
+//  - the others draw their bounding box in the query (no color, no depth
+//    writes) and are then drawn with glBeginConditionalRender: the GPU
+//    skips them if no sample of the box passed, without any readback
+class OcclusionQueries {
+ public:
+  OcclusionQueries(unsigned int nbItems);
+  ~OcclusionQueries();
+
+  // once per frame, before any begin(): reads the available results of
+  // the previous frame
+  void newFrame();
+
+  // false if no sample of the item passed in the previous frame
+  inline bool wasVisible(unsigned int i) const {return _visible[i];}
+
+  // query of the item for the current frame
+  void begin(unsigned int i);
+  void end();
+
+  // the draws until endConditional are skipped if the current query of
+  // the item had no sample. The GPU does not wait for the result: the
+  // item is drawn if the result is not ready yet
+  void beginConditional(unsigned int i);
+  void endConditional();
+
+  inline unsigned int size() const {return _visible.size();}
+
+ private:
+  inline GLuint query(unsigned int i,unsigned int frame) const {return _queries[2*i+frame%2];}
+
+  std::vector<GLuint> _queries; // 2 per item
+  std::vector<bool>   _issued;  // 2 per item: query in flight or done
+  std::vector<bool>   _visible;
+  unsigned int        _frame;
+};
+
+#endif // OCCLUSION_QUERIES_H
@@ -0,0 +1,265 @@
+#include "perfcounters.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+  // -1: not decided yet (SIM_PERF is read on first use)
+  std::atomic<int> perfEnabled(-1);
+
+  struct PerfEntry {
+    PerfEntry() : calls(0), ns(0), elements(0) {}
+
+    uint64_t             calls;
+    uint64_t             ns;
+    uint64_t             elements;
+    PerfCounters::Values counters;
+  };
+
+  std::mutex                       reportMutex;
+  std::map<std::string,PerfEntry>  report;
+
+  uint64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+#ifdef __linux__
+  int openCounter(uint32_t type,uint64_t config,int groupFd) {
+    struct perf_event_attr attr;
+
+    memset(&attr,0,sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = type;
+    attr.config         = config;
+    attr.disabled       = groupFd<0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open,&attr,0,-1,groupFd,0);
+  }
+
+  uint64_t cacheConfig(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ<<8) | (PERF_COUNT_HW_CACHE_RESULT_MISS<<16);
+  }
+#endif
+
+}
+
+PerfCounters::Values::Values() {
+  for(int i=0;i<NB_COUNTERS;++i) {
+    value[i] = 0;
+    valid[i] = false;
+  }
+}
+
+PerfCounters::Values PerfCounters::Values::operator-(const Values &v) const {
+  Values r;
+  for(int i=0;i<NB_COUNTERS;++i) {
+    r.valid[i] = valid[i] && v.valid[i];
+    r.value[i] = r.valid[i] ? value[i]-v.value[i] : 0;
+  }
+  return r;
+}
+
+PerfCounters::Values &PerfCounters::Values::operator+=(const Values &v) {
+  for(int i=0;i<NB_COUNTERS;++i) {
+    value[i] += v.value[i];
+    valid[i]  = valid[i] || v.valid[i];
+  }
+  return *this;
+}
+
+PerfCounters::PerfCounters()
+  : _nbOpened(0) {
+  for(int i=0;i<NB_COUNTERS;++i) {
+    _fds[i]     = -1;
+    _indices[i] = -1;
+  }
+
+#ifdef __linux__
+  const uint32_t types[NB_COUNTERS] = {
+    PERF_TYPE_HARDWARE,PERF_TYPE_HARDWARE,PERF_TYPE_HW_CACHE,PERF_TYPE_HARDWARE,PERF_TYPE_HW_CACHE
+  };
+  const uint64_t configs[NB_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    cacheConfig(PERF_COUNT_HW_CACHE_LL),
+    PERF_COUNT_HW_BRANCH_MISSES,
+    cacheConfig(PERF_COUNT_HW_CACHE_DTLB)
+  };
+
+  // the first counter that opens leads the group, the others are optional
+  int leader = -1;
+  for(int i=0;i<NB_COUNTERS;++i) {
+    _fds[i] = openCounter(types[i],configs[i],leader);
+    if(_fds[i]<0)
+      continue;
+
+    if(leader<0)
+      leader = _fds[i];
+    _indices[i] = _nbOpened++;
+  }
+
+  if(leader>=0) {
+    ioctl(leader,PERF_EVENT_IOC_RESET,PERF_IOC_FLAG_GROUP);
+    ioctl(leader,PERF_EVENT_IOC_ENABLE,PERF_IOC_FLAG_GROUP);
+  } else {
+    printf("Warning: hardware performance counters unavailable (check /proc/sys/kernel/perf_event_paranoid)\n");
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for(int i=NB_COUNTERS-1;i>=0;--i)
+    if(_fds[i]>=0)
+      close(_fds[i]);
+#endif
+}
+
+PerfCounters::Values PerfCounters::read() {
+  Values v;
+
+#ifdef __linux__
+  if(!available())
+    return v;
+
+  // layout of a group read: nr, time_enabled, time_running, values[nr]
+  uint64_t data[3+NB_COUNTERS];
+  int leader = -1;
+  for(int i=0;i<NB_COUNTERS && leader<0;++i)
+    leader = _fds[i];
+
+  if(::read(leader,data,sizeof(data))<(ssize_t)(3*sizeof(uint64_t)))
+    return v;
+
+  // extrapolate when the kernel had to multiplex the counters
+  const double scale = data[2]>0 ? (double)data[1]/(double)data[2] : 1.0;
+  for(int i=0;i<NB_COUNTERS;++i) {
+    if(_indices[i]<0 || (uint64_t)_indices[i]>=data[0])
+      continue;
+    v.value[i] = (uint64_t)((double)data[3+_indices[i]]*scale);
+    v.valid[i] = true;
+  }
+#endif
+
+  return v;
+}
+
+bool PerfCounters::enabled() {
+  int e = perfEnabled.load(std::memory_order_relaxed);
+
+  if(e<0) {
+    const char *env = getenv("SIM_PERF");
+    e = (env && env[0] && strcmp(env,"0")) ? 1 : 0;
+    perfEnabled.store(e,std::memory_order_relaxed);
+  }
+
+  return e==1;
+}
+
+void PerfCounters::setEnabled(bool e) {
+  perfEnabled.store(e ? 1 : 0,std::memory_order_relaxed);
+}
+
+const char *PerfCounters::name(int counter) {
+  static const char *names[NB_COUNTERS] = {
+    "cycles","instructions","llc_misses","branch_misses","dtlb_misses"
+  };
+  return names[counter];
+}
+
+PerfCounters &PerfCounters::thread() {
+  static thread_local PerfCounters counters;
+  return counters;
+}
+
+void PerfReport::add(const std::string &phase,uint64_t ns,uint64_t elements,
+                     const PerfCounters::Values &v) {
+  std::lock_guard<std::mutex> lock(reportMutex);
+  PerfEntry &e = report[phase];
+
+  e.calls++;
+  e.ns       += ns;
+  e.elements += elements;
+  e.counters += v;
+}
+
+void PerfReport::clear() {
+  std::lock_guard<std::mutex> lock(reportMutex);
+  report.clear();
+}
+
+void PerfReport::print() {
+  std::lock_guard<std::mutex> lock(reportMutex);
+
+  if(report.empty())
+    return;
+
+  printf("%-24s %6s %10s %12s %6s %10s %10s %10s\n",
+         "phase","calls","time(ms)","elements","IPC","LLC/elt","brmiss/elt","dTLB/elt");
+
+  for(std::map<std::string,PerfEntry>::const_iterator it=report.begin();it!=report.end();++it) {
+    const PerfEntry &e = it->second;
+    const PerfCounters::Values &c = e.counters;
+    const double elements = e.elements>0 ? (double)e.elements : 1.0;
+
+    printf("%-24s %6llu %10.2f %12llu",it->first.c_str(),
+           (unsigned long long)e.calls,(double)e.ns/1e6,(unsigned long long)e.elements);
+
+    if(c.valid[PerfCounters::CYCLES] && c.valid[PerfCounters::INSTRUCTIONS] && c.value[PerfCounters::CYCLES]>0)
+      printf(" %6.2f",(double)c.value[PerfCounters::INSTRUCTIONS]/(double)c.value[PerfCounters::CYCLES]);
+    else
+      printf(" %6s","n/a");
+
+    const int misses[3] = {PerfCounters::LLC_MISSES,PerfCounters::BRANCH_MISSES,PerfCounters::DTLB_MISSES};
+    for(int i=0;i<3;++i) {
+      if(c.valid[misses[i]])
+        printf(" %10.4f",(double)c.value[misses[i]]/elements);
+      else
+        printf(" %10s","n/a");
+    }
+    printf("\n");
+  }
+}
+
+PerfScope::PerfScope(const char *phase,uint64_t elements)
+  : _phase(PerfCounters::enabled() ? phase : 0),
+    _elements(elements),
+    _start(0) {
+  if(!_phase)
+    return;
+
+  _counters = PerfCounters::thread().read();
+  _start    = nowNs();
+}
+
+PerfScope::~PerfScope() {
+  end();
+}
+
+void PerfScope::end() {
+  if(!_phase)
+    return;
+
+  const uint64_t end = nowNs();
+  const PerfCounters::Values counters = PerfCounters::thread().read();
+  PerfReport::add(_phase,end-_start,_elements,counters-_counters);
+  _phase = 0;
+}
@@ -0,0 +1,93 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <stdint.h>
+#include <string>
+
+// Hardware performance counters (Linux perf_event_open) around named phases.
+//
+// Enabled by the SIM_PERF environment variable (or PerfCounters::setEnabled),
+// a no-op elsewhere. Counters the CPU/kernel refuses (VMs, paranoid
+// settings) are reported as unavailable instead of failing.
+//
+//   {
+//     PERF_SCOPE("Mesh::normals",nb_faces);
+//     ...
+//   }
+//   PerfReport::print(); // IPC and misses per element for every phase
+
+class PerfCounters {
+ public:
+  enum {CYCLES, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, DTLB_MISSES, NB_COUNTERS};
+
+  struct Values {
+    Values();
+    Values  operator-(const Values &v) const;
+    Values &operator+=(const Values &v);
+
+    uint64_t value[NB_COUNTERS];
+    bool     valid[NB_COUNTERS];
+  };
+
+  // counting the calling thread only
+  PerfCounters();
+  ~PerfCounters();
+
+  inline bool available() const {return _nbOpened>0;}
+
+  // current counts since the counters were opened (scaled when multiplexed)
+  Values read();
+
+  static bool enabled();
+  static void setEnabled(bool e);
+  static const char *name(int counter);
+
+  // counters of the calling thread (opened on first use)
+  static PerfCounters &thread();
+
+ private:
+  PerfCounters(const PerfCounters &);
+  PerfCounters &operator=(const PerfCounters &);
+
+  int _fds[NB_COUNTERS];
+  int _indices[NB_COUNTERS]; // position in the group read, -1 if not opened
+  int _nbOpened;
+};
+
+class PerfReport {
+ public:
+  // accumulate the counters of one run of a phase over elements items
+  static void add(const std::string &phase,uint64_t ns,uint64_t elements,
+                  const PerfCounters::Values &v);
+
+  // one line per phase: time, IPC and misses per element
+  static void print();
+  static void clear();
+};
+
+class PerfScope {
+ public:
+  PerfScope(const char *phase,uint64_t elements=1);
+  ~PerfScope();
+
+  // when the number of elements is only known at the end of the phase
+  inline void setElements(uint64_t elements) {_elements = elements;}
+  // the phase ends before the end of the block (once)
+  void end();
+
+ private:
+  PerfScope(const PerfScope &);
+  PerfScope &operator=(const PerfScope &);
+
+  const char           *_phase;
+  uint64_t              _elements;
+  uint64_t              _start;
+  PerfCounters::Values  _counters;
+};
+
+#define PERF_CONCAT_(a,b) a##b
+#define PERF_CONCAT(a,b)  PERF_CONCAT_(a,b)
+
+#define PERF_SCOPE(phase,elements) PerfScope PERF_CONCAT(_perfScope,__LINE__)(phase,elements)
+
+#endif // PERFCOUNTERS_H
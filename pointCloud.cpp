@@ -0,0 +1,303 @@
+#include "pointCloud.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <locale.h>
+#include <math.h>
+#include <algorithm>
+#include <thread>
+#include <unistd.h>
+
+bool PointCloud::isPointCloud(const char *filename) {
+  FILE *file = fopen(filename,"r");
+  if(file==NULL)
+    return false;
+
+  unsigned int nbVertices,nbFaces,tmp;
+  const bool   points = fscanf(file,"OFF\n%u %u %u\n",&nbVertices,&nbFaces,&tmp)==3 && nbFaces==0 && nbVertices>0;
+  fclose(file);
+  return points;
+}
+
+unsigned int PointCloud::maxPoints() {
+  const char  *env = getenv("SIM_MAX_POINTS");
+  const double n   = env && env[0] ? atof(env)*1e6 : 0.25*sysconf(_SC_PHYS_PAGES)*(double)sysconf(_SC_PAGESIZE)/(3*sizeof(float));
+  return (unsigned int)std::min(std::max(n,1.0),4294967295.0);
+}
+
+PointCloud::PointCloud(const char *filename,std::atomic<float> *progress,const std::atomic<bool> *cancel,
+		       unsigned int maxPoints,unsigned int nbThreads)
+  : _nbPoints(0),
+    _radius(0.0f) {
+  TRACE_SCOPE("PointCloud::PointCloud");
+
+  setlocale(LC_ALL,"C");
+
+  FILE *file = fopen(filename,"r");
+  if(file==NULL) {
+    printf("Unable to read %s\n",filename);
+    build(nbThreads);
+    return;
+  }
+
+  long size = 0;
+  if(fseek(file,0,SEEK_END)==0) {
+    size = ftell(file);
+    rewind(file);
+  }
+
+  unsigned int nbVertices = 0,nbFaces,tmp;
+  if(fscanf(file,"OFF\n%u %u %u\n",&nbVertices,&nbFaces,&tmp)!=3)
+    printf("Unable to read %s\n",filename);
+
+  // the first maxPoints points, then each next one replaces a random one
+  // with a probability of maxPoints/i (xorshift: rand() is too short)
+  _nbPoints = std::min(nbVertices,maxPoints);
+  _points.resize(3*(size_t)_nbPoints);
+  uint64_t random = 88172645463325252ULL;
+  for(unsigned int i=0;i<nbVertices;++i) {
+    float p[3];
+    if(fscanf(file,"%f %f %f\n",&p[0],&p[1],&p[2])!=3) {
+      printf("Unable to read vertices of %s\n",filename);
+      _nbPoints = std::min(i,_nbPoints);
+      break;
+    }
+
+    size_t j = i;
+    if(i>=_nbPoints) {
+      random ^= random<<13;
+      random ^= random>>7;
+      random ^= random<<17;
+      j = random%(i+1);
+    }
+    if(j<_nbPoints)
+      memcpy(&_points[3*j],p,sizeof(p));
+
+    if(progress && size>0 && (i&0xffff)==0)
+      progress->store((float)ftell(file)/size);
+    if(cancel && (i&0xffff)==0 && cancel->load()) {
+      _nbPoints = 0;
+      break;
+    }
+  }
+  fclose(file);
+
+  _points.resize(3*(size_t)_nbPoints);
+  build(nbThreads);
+}
+
+PointCloud::PointCloud(const float *points,unsigned int nbPoints,unsigned int nbThreads)
+  : _points(points,points+3*(size_t)nbPoints),
+    _nbPoints(nbPoints),
+    _radius(0.0f) {
+  build(nbThreads);
+}
+
+void PointCloud::releasePoints() {
+  std::vector<float>().swap(_points);
+}
+
+void PointCloud::build(unsigned int nbThreads) {
+  TRACE_SCOPE("PointCloud::build");
+
+  if(nbThreads==0)
+    nbThreads = std::max(1u,std::thread::hardware_concurrency());
+
+  // center and radius as Mesh, the cube around the points
+  double c[3]   = {0.0,0.0,0.0};
+  Vec3f  min(HUGE_VALF,HUGE_VALF,HUGE_VALF),max(-HUGE_VALF,-HUGE_VALF,-HUGE_VALF);
+  for(size_t i=0;i<_nbPoints;++i) {
+    for(int k=0;k<3;++k) {
+      c[k]  += _points[3*i+k];
+      min[k] = std::min(min[k],_points[3*i+k]);
+      max[k] = std::max(max[k],_points[3*i+k]);
+    }
+  }
+  for(int k=0;k<3;++k)
+    _center[k] = _nbPoints>0 ? (float)(c[k]/_nbPoints) : 0.0f;
+  for(size_t i=0;i<_nbPoints;++i) {
+    const float *p = &_points[3*i];
+    const float  d = sqrtf((p[0]-_center[0])*(p[0]-_center[0])+(p[1]-_center[1])*(p[1]-_center[1])+(p[2]-_center[2])*(p[2]-_center[2]));
+    _radius = std::max(_radius,d);
+  }
+
+  Node root;
+  float side = 0.0f;
+  if(_nbPoints==0)
+    min = max = Vec3f(0.0f,0.0f,0.0f);
+  for(int k=0;k<3;++k)
+    side = std::max(side,max[k]-min[k]);
+  side = side>0.0f ? side*1.0001f : 1.0f; // the points on the max faces stay inside
+  root.box.min    = min;
+  root.box.max    = min+Vec3f(side,side,side);
+  root.spacing    = side/GRID;
+  root.first      = 0;
+  root.count      = _nbPoints;
+  root.firstChild = 0;
+  root.nbChildren = 0;
+  _nodes.assign(1,root);
+
+  // the first levels here, until there are enough subtrees for the threads
+  unsigned int taskDepth = 0;
+  for(unsigned int n=1;n<nbThreads;n*=8)
+    taskDepth++;
+
+  std::vector<Task> tasks;
+  build(_nodes,0,0,nbThreads>1 ? &tasks : NULL,taskDepth);
+
+  // then the subtrees, largest first
+  std::vector<unsigned int> order(tasks.size());
+  for(unsigned int i=0;i<tasks.size();++i)
+    order[i] = i;
+  std::sort(order.begin(),order.end(),[&tasks](unsigned int a,unsigned int b) {
+      return tasks[a].nodes[0].count>tasks[b].nodes[0].count;
+    });
+
+  std::atomic<unsigned int> next(0);
+  std::vector<std::thread>  threads;
+  for(unsigned int i=0;i<std::min(nbThreads,(unsigned int)tasks.size());++i) {
+    threads.push_back(std::thread([this,&tasks,&order,&next]() {
+	  for(unsigned int t=next++;t<tasks.size();t=next++)
+	    build(tasks[order[t]].nodes,0,tasks[order[t]].depth,NULL,0);
+	}));
+  }
+  for(unsigned int i=0;i<threads.size();++i)
+    threads[i].join();
+
+  // their nodes after the first levels: the root of each one replaces its
+  // place holder, the others are appended (children stay consecutive)
+  for(unsigned int i=0;i<tasks.size();++i) {
+    const std::vector<Node> &nodes  = tasks[i].nodes;
+    const unsigned int       offset = _nodes.size()-1;
+    for(unsigned int j=0;j<nodes.size();++j) {
+      Node n = nodes[j];
+      if(n.nbChildren>0)
+	n.firstChild += offset;
+      if(j==0)
+	_nodes[tasks[i].node] = n;
+      else
+	_nodes.push_back(n);
+    }
+  }
+}
+
+void PointCloud::build(std::vector<Node> &nodes,unsigned int node,unsigned int depth,
+		       std::vector<Task> *tasks,unsigned int taskDepth) {
+  const unsigned int first = nodes[node].first;
+  const unsigned int last  = first+nodes[node].count;
+  Point             *p     = (Point *)_points.data();
+
+  if(last-first<=LEAF_POINTS || depth==MAX_DEPTH)
+    return;
+
+  // one point per cell, moved to the front
+  const Box   b     = nodes[node].box;
+  const float scale = GRID/(b.max[0]-b.min[0]);
+  uint32_t    taken[GRID*GRID*GRID/32] = {0};
+  unsigned int n = first;
+  for(unsigned int i=first;i<last;++i) {
+    unsigned int c[3];
+    for(int k=0;k<3;++k)
+      c[k] = std::min((unsigned int)std::max((p[i].p[k]-b.min[k])*scale,0.0f),(unsigned int)GRID-1);
+
+    const unsigned int cell = (c[2]*GRID+c[1])*GRID+c[0];
+    if(taken[cell/32]&(1u<<(cell%32)))
+      continue;
+    taken[cell/32] |= 1u<<(cell%32);
+    std::swap(p[i],p[n++]);
+  }
+  nodes[node].count = n-first;
+
+  // the rest in the 8 octants (x, then y, then z halves): child c has
+  // the bits x=4, y=2, z=1
+  const Vec3f  mid = (b.min+b.max)*0.5f;
+  unsigned int bounds[9];
+  bounds[0] = n;
+  bounds[8] = last;
+  bounds[4] = std::partition(p+bounds[0],p+bounds[8],[&mid](const Point &q) {return q.p[0]<mid[0];})-p;
+  for(unsigned int h=0;h<8;h+=4)
+    bounds[h+2] = std::partition(p+bounds[h],p+bounds[h+4],[&mid](const Point &q) {return q.p[1]<mid[1];})-p;
+  for(unsigned int h=0;h<8;h+=2)
+    bounds[h+1] = std::partition(p+bounds[h],p+bounds[h+2],[&mid](const Point &q) {return q.p[2]<mid[2];})-p;
+
+  const unsigned int firstChild = nodes.size();
+  unsigned int       nbChildren = 0;
+  for(unsigned int c=0;c<8;++c) {
+    if(bounds[c+1]==bounds[c])
+      continue;
+
+    Node child;
+    for(int k=0;k<3;++k) {
+      const bool upper = c&(4>>k);
+      child.box.min[k] = upper ? mid[k] : b.min[k];
+      child.box.max[k] = upper ? b.max[k] : mid[k];
+    }
+    child.spacing    = nodes[node].spacing*0.5f;
+    child.first      = bounds[c];
+    child.count      = bounds[c+1]-bounds[c];
+    child.firstChild = 0;
+    child.nbChildren = 0;
+    nodes.push_back(child);
+    nbChildren++;
+  }
+  nodes[node].firstChild = firstChild;
+  nodes[node].nbChildren = nbChildren;
+
+  for(unsigned int c=firstChild;c<firstChild+nbChildren;++c) {
+    if(tasks && depth+1==taskDepth) {
+      Task t;
+      t.node  = c;
+      t.depth = depth+1;
+      t.nodes.assign(1,nodes[c]);
+      tasks->push_back(t);
+    } else {
+      build(nodes,c,depth+1,tasks,taskDepth);
+    }
+  }
+}
+
+unsigned int PointCloud::select(const Frustum &f,const Vec3f &eye,float pixelsPerUnit,float scale,float zmin,
+				unsigned int budget,Queue &queue,std::vector<unsigned int> &selected) const {
+  queue.clear();
+  if(_nodes.empty())
+    return 0;
+
+  // spacing of a node on the screen, at the nearest point of its cube
+  auto size = [&](const Node &n) {
+    float d = 0.0f;
+    for(int k=0;k<3;++k) {
+      const float e = std::max(std::max(n.box.min[k]-eye[k],eye[k]-n.box.max[k]),0.0f);
+      d += e*e;
+    }
+    return n.spacing*scale*pixelsPerUnit/std::max(sqrtf(d)*scale,zmin);
+  };
+
+  unsigned int total = 0;
+  queue.push_back(std::make_pair(size(_nodes[0]),0u));
+  while(!queue.empty()) {
+    std::pop_heap(queue.begin(),queue.end());
+    const float        pixels = queue.back().first;
+    const unsigned int i      = queue.back().second;
+    const Node        &n      = _nodes[i];
+    queue.pop_back();
+
+    if(f.classify(n.box)==Frustum::OUTSIDE)
+      continue;
+    if(total+n.count>budget)
+      break;
+    selected.push_back(i);
+    total += n.count;
+
+    // children finer than a pixel: nothing more to see
+    if(pixels<2.0f)
+      continue;
+    for(unsigned int c=n.firstChild;c<n.firstChild+n.nbChildren;++c) {
+      queue.push_back(std::make_pair(size(_nodes[c]),c));
+      std::push_heap(queue.begin(),queue.end());
+    }
+  }
+  return total;
+}
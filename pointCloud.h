@@ -0,0 +1,97 @@
+#ifndef POINT_CLOUD_H
+#define POINT_CLOUD_H
+
+#include <vector>
+#include <utility>
+#include <atomic>
+#include "bvh.h"
+
+// point cloud: an OFF file without faces, in a multi-resolution octree
+// (as Potree). Each node keeps at most one point per cell of a GRID^3 grid
+// over its cube, the other points go down to its children: the nodes down
+// to any depth are an even subsample of the cloud, drawn coarse to fine
+// until a budget of points on the screen is reached.
+//
+// The points are reordered so that the ones of each node are consecutive
+// (one range per draw). The first levels are built on the calling thread,
+// the subtrees under them in parallel, in place: the points are never
+// copied.
+//
+// Files with more than maxPoints points are subsampled while they are read
+// (reservoir sampling, uniform): the memory stays bounded, whatever the
+// size of the file.
+class PointCloud {
+ public:
+  enum {GRID=32, LEAF_POINTS=4096, MAX_DEPTH=20};
+
+  struct Node {
+    Box          box;        // cube
+    float        spacing;    // between its points: size of a cell
+    unsigned int first;      // its points
+    unsigned int count;
+    unsigned int firstChild; // 0 for a leaf (the root is never a child)
+    unsigned int nbChildren;
+  };
+
+  // nodes waiting in select(), by size on the screen
+  typedef std::vector<std::pair<float,unsigned int> > Queue;
+
+  // true for an OFF file without faces
+  static bool isPointCloud(const char *filename);
+  // SIM_MAX_POINTS=<millions>, by default what a quarter of the physical
+  // memory holds
+  static unsigned int maxPoints();
+
+  // progress: if not NULL, the part of the file already read (read by
+  // another thread). cancel: if not NULL and set (by another thread), the
+  // reading stops and the cloud is empty
+  PointCloud(const char *filename,std::atomic<float> *progress=NULL,const std::atomic<bool> *cancel=NULL,
+	     unsigned int maxPoints=PointCloud::maxPoints(),unsigned int nbThreads=0);
+  PointCloud(const float *points,unsigned int nbPoints,unsigned int nbThreads=0);
+
+  // once they are on the GPU: the nodes are enough to draw them
+  void releasePoints();
+
+  // nodes in f (mesh -> clip space) appended to selected, from the root,
+  // largest on the screen first (spacing at its distance from eye, in mesh
+  // space), until their points reach budget or their children would be
+  // finer than a pixel. pixelsPerUnit: pixels of one unit at distance 1,
+  // scale: from the mesh to the world, zmin: nearest distance. queue is
+  // cleared, and does not reallocate once its capacity is nbNodes().
+  // Returns the number of points selected
+  unsigned int select(const Frustum &f,const Vec3f &eye,float pixelsPerUnit,float scale,float zmin,
+		      unsigned int budget,Queue &queue,std::vector<unsigned int> &selected) const;
+
+  inline const float *points()   const {return _points.data();}
+  inline unsigned int nbPoints() const {return _nbPoints;}
+  inline unsigned int nbNodes()  const {return _nodes.size();}
+  inline const Node  &node(unsigned int i) const {return _nodes[i];}
+  inline const float *center()   const {return _center;}
+  inline float        radius()   const {return _radius;}
+
+ private:
+  struct Point {
+    float p[3];
+  };
+
+  // subtree below the first levels, built by a worker
+  struct Task {
+    unsigned int      node;  // in _nodes, its children are in nodes
+    unsigned int      depth;
+    std::vector<Node> nodes;
+  };
+
+  void build(unsigned int nbThreads);
+  // node and its subtree, in nodes. tasks: if not NULL, the nodes at depth
+  // taskDepth are left to them
+  void build(std::vector<Node> &nodes,unsigned int node,unsigned int depth,
+	     std::vector<Task> *tasks,unsigned int taskDepth);
+
+  std::vector<float> _points;
+  unsigned int       _nbPoints;
+  std::vector<Node>  _nodes;
+  float              _center[3];
+  float              _radius;
+};
+
+#endif // POINT_CLOUD_H
@@ -0,0 +1,399 @@
+#include "progressiveMesh.h"
+#include "trace.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <string.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t fnv1a(const char *data,size_t size,uint64_t hash=14695981039346656037ULL) {
+  for(size_t i=0;i<size;++i) {
+    hash ^= (unsigned char)data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+ProgressiveMesh::ProgressiveMesh()
+  : _file(NULL),
+    _firstVertex(0),
+    _firstIndex(0),
+    _nbSplits(0),
+    _nbCorners(0),
+    _ready(false),
+    _finished(false),
+    _quit(false) {
+  memset(&_header,0,sizeof(_header));
+}
+
+ProgressiveMesh::~ProgressiveMesh() {
+  if(_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _quit = true;
+    }
+    _cond.notify_all();
+    _thread.join();
+  }
+
+  if(_file)
+    fclose(_file);
+}
+
+std::string ProgressiveMesh::cacheFilename(const char *offFilename,const char *extension) {
+  const char *env  = getenv("SIM_MESH_CACHE");
+  const char *home = getenv("HOME");
+  std::string dir;
+
+  if(env && !strcmp(env,"0"))
+    return "";
+
+  if(env && env[0]) {
+    dir = env;
+  } else if(home && home[0]) {
+    dir = std::string(home)+"/.cache";
+    mkdir(dir.c_str(),0755);
+    dir += "/tp03-meshes";
+  } else {
+    return "";
+  }
+  mkdir(dir.c_str(),0755);
+
+  // one cache per OFF file, wherever it is run from
+  char path[PATH_MAX];
+  const char *key = realpath(offFilename,path) ? path : offFilename;
+
+  char name[64];
+  snprintf(name,sizeof(name),"/%016llx%s",(unsigned long long)fnv1a(key,strlen(key)),extension);
+  return dir+name;
+}
+
+std::string ProgressiveMesh::temporaryFilename(const char *extension) {
+  const char *tmp  = getenv("TMPDIR");
+  std::string name = std::string(tmp && tmp[0] ? tmp : "/tmp")+"/tp03-XXXXXX"+extension;
+
+  const int fd = mkstemps(&name[0],strlen(extension));
+  if(fd<0)
+    return "";
+  close(fd);
+  return name;
+}
+
+bool ProgressiveMesh::offStat(const char *offFilename,uint64_t &size,int64_t &time) {
+  size = 0;
+  time = 0;
+  if(offFilename==NULL)
+    return true;
+
+  struct stat s;
+  if(stat(offFilename,&s)!=0)
+    return false;
+
+  size = s.st_size;
+  time = s.st_mtime;
+  return true;
+}
+
+bool ProgressiveMesh::write(const std::string &filename,const char *offFilename,
+			    const float *vertices,unsigned int nbVertices,
+			    const unsigned int *faces,unsigned int nbFaces,
+			    const float *center,float radius,
+			    const std::atomic<bool> *cancel,unsigned int baseTriangles) {
+  TRACE_SCOPE("ProgressiveMesh::write");
+
+  Header h;
+  memcpy(h.magic,"PM01",4);
+  memcpy(h.center,center,sizeof(h.center));
+  h.radius = radius;
+  if(!offStat(offFilename,h.offSize,h.offTime))
+    return false;
+
+  // the collapses down to the base mesh (from, to)
+  std::vector<unsigned int> base,log;
+  Simplifier::simplify(vertices,nbVertices,faces,3*nbFaces,3*baseTriangles,1e30f,base,0,&log,cancel);
+  const unsigned int nbCollapses = log.size()/2;
+  if(cancel && cancel->load())
+    return false;
+
+  // replayed on the faces: the collapse removing each triangle, the corners
+  // each collapse moves from "from" to "to". Degenerate faces are dropped
+  const unsigned int        kept = ~0u,dropped = ~1u;
+  std::vector<unsigned int> triangles(faces,faces+3*nbFaces);
+  std::vector<unsigned int> removedBy(nbFaces,kept);
+  std::vector<std::vector<unsigned int> > around(nbVertices);
+  for(unsigned int t=0;t<nbFaces;++t) {
+    const unsigned int *p = &triangles[3*t];
+    if(p[0]==p[1] || p[1]==p[2] || p[0]==p[2] || p[0]>=nbVertices || p[1]>=nbVertices || p[2]>=nbVertices) {
+      removedBy[t] = dropped;
+      continue;
+    }
+    for(int k=0;k<3;++k)
+      around[p[k]].push_back(t);
+  }
+
+  std::vector<unsigned int> corners,firstCorner(nbCollapses+1);
+  for(unsigned int i=0;i<nbCollapses;++i) {
+    const unsigned int from = log[2*i],to = log[2*i+1];
+    firstCorner[i] = corners.size();
+    if((i&0xffff)==0 && cancel && cancel->load())
+      return false;
+
+    for(unsigned int j=0;j<around[from].size();++j) {
+      const unsigned int t = around[from][j];
+      unsigned int      *p = &triangles[3*t];
+      if(removedBy[t]!=kept)
+	continue;
+
+      if(p[0]==to || p[1]==to || p[2]==to) {
+	removedBy[t] = i;
+	continue;
+      }
+
+      for(int k=0;k<3;++k) {
+	if(p[k]==from) {
+	  p[k] = to;
+	  corners.push_back(3*t+k);
+	}
+      }
+      around[to].push_back(t);
+    }
+    std::vector<unsigned int>().swap(around[from]);
+  }
+  firstCorner[nbCollapses] = corners.size();
+  std::vector<std::vector<unsigned int> >().swap(around);
+
+  // vertices: the base ones, then the last removed first
+  std::vector<unsigned int> vertex(nbVertices,kept);
+  for(unsigned int i=0;i<nbCollapses;++i)
+    vertex[log[2*i]] = 0;
+  unsigned int n = 0;
+  for(unsigned int v=0;v<nbVertices;++v) {
+    if(vertex[v]==kept)
+      vertex[v] = n++;
+  }
+  h.nbBaseVertices = n;
+  for(unsigned int i=nbCollapses;i-->0;)
+    vertex[log[2*i]] = n++;
+  h.nbVertices = n;
+
+  // triangles: the base ones, then the ones of each split (counting sort
+  // on the collapse removing them, the last one first)
+  std::vector<unsigned int> first(nbCollapses+2,0);
+  for(unsigned int t=0;t<nbFaces;++t) {
+    if(removedBy[t]!=dropped)
+      first[removedBy[t]==kept ? 1 : nbCollapses-removedBy[t]+1]++;
+  }
+  for(unsigned int i=0;i<=nbCollapses;++i)
+    first[i+1] += first[i];
+  h.nbBaseTriangles = first[1];
+  h.nbTriangles     = first[nbCollapses+1];
+  h.nbCorners       = corners.size();
+
+  std::vector<unsigned int> triangle(nbFaces);
+  std::vector<unsigned int> next(first.begin(),first.end()-1);
+  std::vector<unsigned int> sorted(3*h.nbTriangles);
+  for(unsigned int t=0;t<nbFaces;++t) {
+    if(removedBy[t]==dropped)
+      continue;
+    triangle[t] = next[removedBy[t]==kept ? 0 : nbCollapses-removedBy[t]]++;
+    for(int k=0;k<3;++k)
+      sorted[3*triangle[t]+k] = vertex[triangles[3*t+k]];
+  }
+
+  std::vector<float> positions(3*nbVertices);
+  for(unsigned int v=0;v<nbVertices;++v)
+    memcpy(&positions[3*vertex[v]],vertices+3*v,3*sizeof(float));
+
+  std::vector<Split> splits(nbCollapses);
+  for(unsigned int s=0;s<nbCollapses;++s) {
+    const unsigned int i = nbCollapses-1-s;
+    splits[s].nbTriangles = first[s+2]-first[s+1];
+    splits[s].nbCorners   = firstCorner[i+1]-firstCorner[i];
+  }
+  std::vector<unsigned int> splitCorners;
+  splitCorners.reserve(corners.size());
+  for(unsigned int i=nbCollapses;i-->0;) {
+    for(unsigned int j=firstCorner[i];j<firstCorner[i+1];++j)
+      splitCorners.push_back(3*triangle[corners[j]/3]+corners[j]%3);
+  }
+
+  if(cancel && cancel->load())
+    return false;
+
+  // write a temporary file first so that a concurrent run never reads half of it
+  const std::string tmpFilename = filename+".tmp";
+  FILE *file;
+
+  if((file=fopen(tmpFilename.c_str(),"wb"))==NULL) {
+    printf("Unable to write %s\n",tmpFilename.c_str());
+    return false;
+  }
+
+  const bool ok = fwrite(&h,sizeof(h),1,file)==1 &&
+    fwrite(positions.data(),sizeof(float),positions.size(),file)==positions.size() &&
+    fwrite(sorted.data(),sizeof(unsigned int),sorted.size(),file)==sorted.size() &&
+    fwrite(splits.data(),sizeof(Split),splits.size(),file)==splits.size() &&
+    fwrite(splitCorners.data(),sizeof(unsigned int),splitCorners.size(),file)==splitCorners.size();
+  fclose(file);
+
+  if(!ok || rename(tmpFilename.c_str(),filename.c_str())!=0) {
+    remove(tmpFilename.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+bool ProgressiveMesh::open(const std::string &filename,const char *offFilename) {
+  TRACE_SCOPE("ProgressiveMesh::open");
+
+  if((_file=fopen(filename.c_str(),"rb"))==NULL)
+    return false;
+
+  uint64_t size;
+  int64_t  time;
+  bool ok = fread(&_header,sizeof(_header),1,_file)==1 && !memcmp(_header.magic,"PM01",4) &&
+    offStat(offFilename,size,time) && (offFilename==NULL || (size==_header.offSize && time==_header.offTime)) &&
+    _header.nbBaseVertices<=_header.nbVertices && _header.nbBaseTriangles<=_header.nbTriangles;
+
+  // room for the whole mesh: the pointers never change
+  if(ok) {
+    _vertices.reserve(3*_header.nbVertices);
+    _indices.reserve(3*_header.nbTriangles);
+    _vertices.resize(3*_header.nbBaseVertices);
+    _indices.resize(3*_header.nbBaseTriangles);
+
+    ok = fread(_vertices.data(),sizeof(float),_vertices.size(),_file)==_vertices.size() &&
+      fseek(_file,sizeof(Header)+3*sizeof(float)*_header.nbVertices,SEEK_SET)==0 &&
+      fread(_indices.data(),sizeof(unsigned int),_indices.size(),_file)==_indices.size();
+  }
+
+  if(!ok) {
+    fclose(_file);
+    _file = NULL;
+    return false;
+  }
+
+  // the base mesh is the first batch
+  _ready  = true;
+  _thread = std::thread(&ProgressiveMesh::run,this);
+  return true;
+}
+
+bool ProgressiveMesh::ready() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _ready;
+}
+
+void ProgressiveMesh::next() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _ready = false;
+  }
+  _cond.notify_all();
+}
+
+bool ProgressiveMesh::finished() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _finished;
+}
+
+bool ProgressiveMesh::refine() {
+  TRACE_SCOPE("ProgressiveMesh::refine");
+
+  const unsigned int nbSplits    = _header.nbVertices-_header.nbBaseVertices;
+  const unsigned int oldVertices = nbVertices();
+  const unsigned int oldIndices  = nbIndices();
+  const unsigned int nbBatch     = std::min(nbSplits-_nbSplits,std::max(oldVertices,64u));
+
+  // sections of the file
+  const long positions = sizeof(Header);
+  const long triangles = positions+3*sizeof(float)*_header.nbVertices;
+  const long splits    = triangles+3*sizeof(unsigned int)*_header.nbTriangles;
+  const long corners   = splits+sizeof(Split)*nbSplits;
+
+  _splits.resize(nbBatch);
+  if(fseek(_file,splits+sizeof(Split)*_nbSplits,SEEK_SET)!=0 ||
+     fread(_splits.data(),sizeof(Split),nbBatch,_file)!=nbBatch)
+    return false;
+
+  unsigned int nbNewTriangles = 0,nbNewCorners = 0;
+  for(unsigned int i=0;i<nbBatch;++i) {
+    nbNewTriangles += _splits[i].nbTriangles;
+    nbNewCorners   += _splits[i].nbCorners;
+  }
+  if(oldIndices/3+nbNewTriangles>_header.nbTriangles || _nbCorners+nbNewCorners>_header.nbCorners)
+    return false;
+
+  _vertices.resize(3*(oldVertices+nbBatch));
+  _indices.resize(oldIndices+3*nbNewTriangles);
+  _corners.resize(nbNewCorners);
+  if(fseek(_file,positions+3*sizeof(float)*oldVertices,SEEK_SET)!=0 ||
+     fread(&_vertices[3*oldVertices],3*sizeof(float),nbBatch,_file)!=nbBatch ||
+     fseek(_file,triangles+sizeof(unsigned int)*oldIndices,SEEK_SET)!=0 ||
+     fread(_indices.data()+oldIndices,3*sizeof(unsigned int),nbNewTriangles,_file)!=nbNewTriangles ||
+     fseek(_file,corners+sizeof(unsigned int)*_nbCorners,SEEK_SET)!=0 ||
+     fread(_corners.data(),sizeof(unsigned int),nbNewCorners,_file)!=nbNewCorners) {
+    _vertices.resize(3*oldVertices);
+    _indices.resize(oldIndices);
+    return false;
+  }
+
+  // in order: a corner may move again in a later split (the triangles of
+  // the batch are already there)
+  _firstVertex = oldVertices;
+  _firstIndex  = oldIndices;
+  unsigned int c = 0;
+  for(unsigned int i=0;i<nbBatch;++i) {
+    for(unsigned int j=0;j<_splits[i].nbCorners;++j,++c) {
+      if(_corners[c]<_indices.size()) {
+	_indices[_corners[c]] = oldVertices+i;
+	_firstIndex = std::min(_firstIndex,_corners[c]);
+      }
+    }
+  }
+
+  _nbSplits  += nbBatch;
+  _nbCorners += nbNewCorners;
+  return true;
+}
+
+void ProgressiveMesh::run() {
+  const unsigned int nbSplits = _header.nbVertices-_header.nbBaseVertices;
+
+  for(;;) {
+    {
+      // the viewer reads the last batch until next()
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cond.wait(lock,[this]() {return !_ready || _quit;});
+      if(_quit)
+	return;
+    }
+
+    if(_nbSplits==nbSplits)
+      break;
+
+    // a broken file stops at the last valid mesh
+    if(!refine()) {
+      printf("Unable to read the splits of a progressive mesh\n");
+      break;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _ready = true;
+  }
+
+  fclose(_file);
+  _file = NULL;
+
+  {
+    TRACE_SCOPE("ProgressiveMesh::levels");
+    _levels.build(vertices(),nbVertices(),indices(),nbIndices()/3,_levelIndices);
+    _levels.buildMeshlets(vertices(),nbVertices(),_levelIndices,_meshlets);
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _finished = true;
+}
@@ -0,0 +1,134 @@
+#ifndef PROGRESSIVE_MESH_H
+#define PROGRESSIVE_MESH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "simplify.h"
+#include "meshlets.h"
+
+// progressive mesh (Hoppe): a coarse base mesh and the vertex splits that
+// refine it back into the original one, cached in a binary file written
+// from the OFF file the first time it is loaded.
+//
+// The splits undo the collapses of the simplifier, in reverse order. The
+// vertices are numbered in the order they appear and the triangles in the
+// order they come back: the first vertices and triangles of the file are
+// the base mesh, each split adds one vertex, the triangles its collapse
+// removed (1 or 2) and moves a few corners of the previous triangles to
+// the new vertex. Any prefix of the splits is a valid mesh.
+//
+// File: Header, positions (xyz per vertex), triangles (base, then the ones
+// of each split), Split per split, corners (triangle*3+k) of the splits.
+//
+// open() only reads the base mesh, a worker thread reads the splits in
+// batches (each one doubles the vertices) while the viewer draws what it
+// has, then builds the levels of detail and meshlets of the whole mesh.
+class ProgressiveMesh {
+ public:
+  ProgressiveMesh();
+  ~ProgressiveMesh();
+
+  // cache of an OFF file (SIM_MESH_CACHE=<dir> chooses the directory,
+  // ~/.cache/tp03-meshes by default, SIM_MESH_CACHE=0 disables it), "" if none
+  static std::string cacheFilename(const char *offFilename,const char *extension=".pm");
+
+  // new empty file in $TMPDIR (/tmp by default), for the conversions that
+  // need a file when there is no cache. "" if it could not be created
+  static std::string temporaryFilename(const char *extension);
+
+  // size and modification time of the OFF file, stored in the caches to
+  // know when they are out of date (0 for NULL)
+  static bool offStat(const char *offFilename,uint64_t &size,int64_t &time);
+
+  // simplifies the mesh down to about baseTriangles and writes the result.
+  // offFilename: the cache is out of date when it changes (NULL: never).
+  // cancel: if not NULL and set (by another thread), stops without writing
+  static bool write(const std::string &filename,const char *offFilename,
+		    const float *vertices,unsigned int nbVertices,
+		    const unsigned int *faces,unsigned int nbFaces,
+		    const float *center,float radius,
+		    const std::atomic<bool> *cancel=NULL,unsigned int baseTriangles=1024);
+
+  // reads the base mesh (ready() is then true) and starts the worker
+  // thread. False if the file is missing, invalid or out of date
+  bool open(const std::string &filename,const char *offFilename);
+
+  // a batch is ready: vertices [firstVertex,nbVertices) are new and indices
+  // [firstIndex,nbIndices) changed. They stay as they are until next()
+  bool ready();
+  void next();
+
+  // every split is done, levels() and meshlets() are built
+  bool finished();
+
+  inline const float        *vertices()    const {return _vertices.data();}
+  inline const unsigned int *indices()     const {return _indices.data();}
+  inline unsigned int        firstVertex() const {return _firstVertex;}
+  inline unsigned int        nbVertices()  const {return _vertices.size()/3;}
+  inline unsigned int        firstIndex()  const {return _firstIndex;}
+  inline unsigned int        nbIndices()   const {return _indices.size();}
+
+  // of the whole mesh
+  inline unsigned int maxVertices() const {return _header.nbVertices;}
+  inline unsigned int maxIndices()  const {return 3*_header.nbTriangles;}
+  inline const float *center()      const {return _header.center;}
+  inline float        radius()      const {return _header.radius;}
+
+  // once finished: levels of detail of the whole mesh, their indices in
+  // the order of the meshlets of each level
+  inline const LodChain                  &levels()       const {return _levels;}
+  inline const std::vector<Meshlets>     &meshlets()     const {return _meshlets;}
+  inline const std::vector<unsigned int> &levelIndices() const {return _levelIndices;}
+
+ private:
+  struct Header {
+    char     magic[4];
+    uint32_t nbVertices;
+    uint32_t nbTriangles;
+    uint32_t nbBaseVertices;
+    uint32_t nbBaseTriangles;
+    uint32_t nbCorners;
+    float    center[3];
+    float    radius;
+    uint64_t offSize; // of the OFF file
+    int64_t  offTime;
+  };
+
+  struct Split {
+    uint32_t nbTriangles;
+    uint32_t nbCorners;
+  };
+
+  bool refine(); // next batch
+  void run();    // worker thread
+
+  Header                    _header;
+  FILE                     *_file;
+  std::vector<float>        _vertices; // loaded ones (the capacity is the whole mesh)
+  std::vector<unsigned int> _indices;
+  std::vector<Split>        _splits;   // of the current batch
+  std::vector<unsigned int> _corners;
+  unsigned int              _firstVertex;
+  unsigned int              _firstIndex;
+  unsigned int              _nbSplits;  // done
+  unsigned int              _nbCorners; // read
+
+  LodChain                  _levels;
+  std::vector<Meshlets>     _meshlets;
+  std::vector<unsigned int> _levelIndices;
+
+  std::thread             _thread;
+  std::mutex              _mutex;
+  std::condition_variable _cond;
+  bool                    _ready;
+  bool                    _finished;
+  bool                    _quit;
+};
+
+#endif // PROGRESSIVE_MESH_H
@@ -4,6 +4,7 @@
 #include "vec3.h"
 #include "mat3.h"
 #include "mat4.h"
+#include <type_traits>
 
 /*==============================================================================
   CLASS Quat
@@ -13,68 +14,62 @@
 template<class T>
 class Quat {
  public:
-  Quat();
-  Quat(T angle, T x, T y, T z);
+  constexpr Quat() noexcept;
+  constexpr Quat(T angle, T x, T y, T z) noexcept;
   Quat(const Vec3<T> &axis, T angle);
-  Quat(const Quat &q);
-  Quat& operator = (const Quat &q);
-
-  bool operator == (const Quat &q) const;
-  bool operator != (const Quat &q) const;
-  bool operator <  (const Quat &q) const;
-  bool operator <= (const Quat &q) const;
-  bool operator >  (const Quat &q) const;
-  bool operator >= (const Quat &q) const;
-
-  const T& operator [] (int index) const;
-  operator T*();
+
+  constexpr bool operator == (const Quat &q) const;
+  constexpr bool operator != (const Quat &q) const;
+  constexpr bool operator <  (const Quat &q) const;
+  constexpr bool operator <= (const Quat &q) const;
+  constexpr bool operator >  (const Quat &q) const;
+  constexpr bool operator >= (const Quat &q) const;
+
+  constexpr const T& operator [] (int index) const;
+  constexpr operator T*();
   operator const T*() const;
-  T* ptr();
-  const T* ptr() const;
-
-  Quat operator +   (const Quat &q) const;
-  Quat operator -   (const Quat &q) const;
-  Quat operator *   (const Quat &q) const;
-  Quat operator *   (const T &q) const;
-  Quat operator /   (const T &q) const;
-  Quat& operator += (const Quat &q);
-  Quat& operator -= (const Quat &q);
-  Quat& operator *= (const T &q);
-  Quat& operator /= (const T &q);
-  Quat& operator - ();
+  constexpr T* ptr();
+  constexpr const T* ptr() const;
+
+  constexpr Quat operator +   (const Quat &q) const;
+  constexpr Quat operator -   (const Quat &q) const;
+  constexpr Quat operator *   (const Quat &q) const;
+  constexpr Quat operator *   (const T &q) const;
+  constexpr Quat operator /   (const T &q) const;
+  constexpr Quat& operator += (const Quat &q);
+  constexpr Quat& operator -= (const Quat &q);
+  constexpr Quat& operator *= (const T &q);
+  constexpr Quat& operator /= (const T &q);
+  constexpr Quat& operator - ();
 
   float length()    const;
-  float sqrLength() const;
+  constexpr float sqrLength() const;
   Quat& scale(float newLength);
   Quat& normalize();
 
-  Quat conjugate()   const;
-  Quat unitInverse() const;
-  Quat inverse()     const;
+  constexpr Quat conjugate()   const;
+  constexpr Quat unitInverse() const;
+  constexpr Quat inverse()     const;
 
-  Mat4<T> toMat4() const;
-  Mat3<T> toMat3() const;
-  Vec3<T> axis()   const;
-  T angle()        const;
+  constexpr Mat4<T> toMat4() const;
+  constexpr Mat3<T> toMat3() const;
+  constexpr Vec3<T> axis()   const;
+  constexpr T angle()        const;
 
  private:
   T _e[4];
 };
 
 template<class T>
-Quat<T>::Quat() {
-  _e[0] = _e[1] = _e[2] = 0;
-  _e[3] = 1;
+constexpr Quat<T>::Quat() noexcept
+  : _e{0, 0, 0, 1} {
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T>::Quat(T angle, T x, T y, T z) {
-  _e[0] = angle;
-  _e[1] = x;
-  _e[2] = y;
-  _e[3] = z;
+constexpr Quat<T>::Quat(T angle, T x, T y, T z) noexcept
+  : _e{angle, x, y, z} {
 }
 
 //------------------------------------------------------------------------------
@@ -88,79 +83,60 @@ Quat<T>::Quat(const Vec3<T> &axis, T angle) {
   _e[2] = axis[1]*tmp;
   _e[3] = axis[2]*tmp;
 }
-
-//------------------------------------------------------------------------------
-//
-template<class T>
-Quat<T>::Quat(const Quat<T> &q) {
-  *this = q;
-}
-
-//------------------------------------------------------------------------------
-//
-template<class T>
-Quat<T>& Quat<T>::operator = (const Quat<T> &q) {
-  _e[0] = q._e[0];
-  _e[1] = q._e[1];
-  _e[2] = q._e[2];
-  _e[3] = q._e[3];
-  
-  return *this;
-}
   
 //------------------------------------------------------------------------------
 //
 template<class T>
-bool Quat<T>::operator == (const Quat<T> &q) const {
+constexpr bool Quat<T>::operator == (const Quat<T> &q) const {
   return (q._e[0] == _e[0]) && (q._e[1] == _e[1]) && (q._e[2] == _e[2]) && (q._e[3] == _e[3]);
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-bool Quat<T>::operator != (const Quat<T> &q) const {
+constexpr bool Quat<T>::operator != (const Quat<T> &q) const {
   return (q._e[0] != _e[0]) || (q._e[1] != _e[1]) || (q._e[2] != _e[2]) || (q._e[3] != _e[3]);
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-bool Quat<T>::operator < (const Quat<T> &q) const {
+constexpr bool Quat<T>::operator < (const Quat<T> &q) const {
   return (_e[0] < q._e[0]) || ((_e[0] == q._e[0]) && ((_e[1] < q._e[1]) || ((_e[1] == q._e[1]) && ((_e[2] < q._e[2]) || ((_e[2] == q._e[2]) && (_e[3] < q._e[3]))))));
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-bool Quat<T>::operator <= (const Quat<T> &q) const {
+constexpr bool Quat<T>::operator <= (const Quat<T> &q) const {
   return (_e[0] < q._e[0]) || ((_e[0] == q._e[0]) && ((_e[1] < q._e[1]) || ((_e[1] == q._e[1]) && ((_e[2] < q._e[2]) || ((_e[2] == q._e[2]) && (_e[3] <= q._e[3]))))));
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-bool Quat<T>::operator > (const Quat<T> &q) const {
+constexpr bool Quat<T>::operator > (const Quat<T> &q) const {
   return (_e[0] > q._e[0]) || ((_e[0] == q._e[0]) && ((_e[1] > q._e[1]) || ((_e[1] == q._e[1]) && ((_e[2] > q._e[2]) || ((_e[2] == q._e[2]) && (_e[3] > q._e[3]))))));
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-bool Quat<T>::operator >= (const Quat<T> &q) const {
+constexpr bool Quat<T>::operator >= (const Quat<T> &q) const {
   return (_e[0] > q._e[0]) || ((_e[0] == q._e[0]) && ((_e[1] > q._e[1]) || ((_e[1] == q._e[1]) && ((_e[2] > q._e[2]) || ((_e[2] == q._e[2]) && (_e[3] >= q._e[3]))))));
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-const T& Quat<T>::operator [] (int index) const {
+constexpr const T& Quat<T>::operator [] (int index) const {
   return _e[index];
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T>::operator T*() {
+constexpr Quat<T>::operator T*() {
   return _e;
 }
 
@@ -174,35 +150,35 @@ Quat<T>::operator const T*() const {
 //------------------------------------------------------------------------------
 //
 template< class T >
-inline T* Quat<T>::ptr() {
+inline constexpr T* Quat<T>::ptr() {
   return _e;
 }
 
 //------------------------------------------------------------------------------
 //
 template< class T >
-inline const T* Quat<T>::ptr() const {
+inline constexpr const T* Quat<T>::ptr() const {
   return _e;
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T> Quat<T>::operator + (const Quat<T> &q) const {
+constexpr Quat<T> Quat<T>::operator + (const Quat<T> &q) const {
   return Quat( _e[0]+q._e[0],_e[1]+q._e[1], _e[2]+q._e[2], _e[3]+q._e[3]);
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T> Quat<T>::operator - (const Quat<T> &q) const {
+constexpr Quat<T> Quat<T>::operator - (const Quat<T> &q) const {
   return Quat(_e[0]-q._e[0], _e[1]-q._e[1], _e[2]-q._e[2], _e[3]-q._e[3]);
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T> Quat<T>::operator * (const Quat<T> &q) const {
+constexpr Quat<T> Quat<T>::operator * (const Quat<T> &q) const {
   return Quat(
               _e[0]*q._e[0] - _e[1]*q._e[1] - _e[2]*q._e[2] - _e[3]*q._e[3],
               _e[0]*q._e[1] + _e[1]*q._e[0] + _e[2]*q._e[3] - _e[3]*q._e[2],
@@ -214,21 +190,21 @@ Quat<T> Quat<T>::operator * (const Quat<T> &q) const {
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T> Quat<T>::operator * (const T &q) const {
+constexpr Quat<T> Quat<T>::operator * (const T &q) const {
   return Quat(_e[0]*q, _e[1]*q, _e[2]*q, _e[3]*q);
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T> Quat<T>::operator / (const T &q) const {
+constexpr Quat<T> Quat<T>::operator / (const T &q) const {
   return Quat(_e[0]/q, _e[1]/q, _e[2]/q, _e[3]/q);
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T>& Quat<T>::operator += (const Quat<T> &q) {
+constexpr Quat<T>& Quat<T>::operator += (const Quat<T> &q) {
   _e[0] += q._e[0]; 
   _e[1] += q._e[1]; 
   _e[2] += q._e[2]; 
@@ -240,7 +216,7 @@ Quat<T>& Quat<T>::operator += (const Quat<T> &q) {
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T>& Quat<T>::operator -= (const Quat<T> &q) {
+constexpr Quat<T>& Quat<T>::operator -= (const Quat<T> &q) {
   _e[0] -= q._e[0]; 
   _e[1] -= q._e[1]; 
   _e[2] -= q._e[2]; 
@@ -252,7 +228,7 @@ Quat<T>& Quat<T>::operator -= (const Quat<T> &q) {
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T>& Quat<T>::operator *= (const T &q) {
+constexpr Quat<T>& Quat<T>::operator *= (const T &q) {
   *this = *this * q;
 
   return *this;
@@ -261,7 +237,7 @@ Quat<T>& Quat<T>::operator *= (const T &q) {
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T>& Quat<T>::operator /= (const T &q) {
+constexpr Quat<T>& Quat<T>::operator /= (const T &q) {
   _e[0] /= q; 
   _e[1] /= q; 
   _e[2] /= q; 
@@ -273,7 +249,7 @@ Quat<T>& Quat<T>::operator /= (const T &q) {
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T>& Quat<T>::operator - () {
+constexpr Quat<T>& Quat<T>::operator - () {
   _e[0] = -_e[0];
   _e[1] = -_e[1]; 
   _e[2] = -_e[2]; 
@@ -292,7 +268,7 @@ float Quat<T>::length() const {
 //------------------------------------------------------------------------------
 //
 template<class T>
-float Quat<T>::sqrLength() const {
+constexpr float Quat<T>::sqrLength() const {
   return _e[0]*_e[0]+_e[1]*_e[1]+_e[2]*_e[2]+_e[3]*_e[3];
 }
 
@@ -318,28 +294,28 @@ Quat<T>& Quat<T>::normalize() {
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T> Quat<T>::conjugate() const {
+constexpr Quat<T> Quat<T>::conjugate() const {
   return Quat(_e[0], -_e[1], -_e[2], -_e[3]);
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T> Quat<T>::unitInverse() const {
+constexpr Quat<T> Quat<T>::unitInverse() const {
   return conjugate();
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-Quat<T> Quat<T>::inverse() const {
+constexpr Quat<T> Quat<T>::inverse() const {
   return conjugate()/sqrLength();
 }
 
 //------------------------------------------------------------------------------
 //
 template<class T>
-Mat4<T> Quat<T>::toMat4() const {
+constexpr Mat4<T> Quat<T>::toMat4() const {
   float xx = _e[1]*_e[1];
   float xy = _e[1]*_e[2];
   float xz = _e[1]*_e[3];
@@ -360,7 +336,7 @@ Mat4<T> Quat<T>::toMat4() const {
 //------------------------------------------------------------------------------
 //
 template<class T>
-Mat3<T> Quat<T>::toMat3() const {
+constexpr Mat3<T> Quat<T>::toMat3() const {
   float xx = _e[1]*_e[1];
   float xy = _e[1]*_e[2];
   float xz = _e[1]*_e[3];
@@ -379,14 +355,14 @@ Mat3<T> Quat<T>::toMat3() const {
 //------------------------------------------------------------------------------
 //
 template< class T >
-inline Vec3<T> Quat<T>::axis() const {
+inline constexpr Vec3<T> Quat<T>::axis() const {
   return Vec3<T>(_e[1],_e[2],_e[3]);
 }
 
 //------------------------------------------------------------------------------
 //
 template< class T >
-inline T Quat<T>::angle() const {
+inline constexpr T Quat<T>::angle() const {
   return _e[0];
 }
 
@@ -394,4 +370,6 @@ typedef Quat< float >   Quatf;
 typedef Quat< double >  Quatd;
 typedef Quat< int >     Quati;
 
+static_assert( std::is_trivially_copyable< Quatf >::value, "Quatf must stay trivially copyable" );
+
 #endif // QUAT_H
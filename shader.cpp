@@ -8,17 +8,58 @@ using namespace std;
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
 
 #include <GL/glew.h>
+#include <GL/glx.h>
 
 #include "shader.h"
+#include "trace.h"
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// 64 bits FNV-1a
+static uint64_t fnv1a(const char *data,size_t size,uint64_t hash=14695981039346656037ULL) {
+  for(size_t i=0;i<size;++i) {
+    hash ^= (unsigned char)data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// same set of defines whatever their order
+static uint64_t definesHash(const std::vector<std::string> &defines) {
+  uint64_t hash = 0;
+  for(size_t i=0;i<defines.size();++i)
+    hash += fnv1a(defines[i].data(),defines[i].size());
+  return hash;
+}
+
+static bool sameDefines(const std::vector<std::string> &a,const std::vector<std::string> &b) {
+  if(a.size()!=b.size())
+    return false;
+  for(size_t i=0;i<a.size();++i)
+    if(std::find(b.begin(),b.end(),a[i])==b.end())
+      return false;
+  return true;
+}
 
 Shader::Shader() :
-  _programId(0) {
+  _programId(0),
+  _maxVariants(16),
+  _pendingProgram(0),
+  _pendingVertex(0),
+  _pendingFragment(0) {
   
 }
 
 Shader::~Shader() {
+  cancelPending();
+  clearVariants();
+
   if(glIsProgram(_programId)) {
     glDeleteProgram(_programId);
   }
@@ -26,53 +67,339 @@ Shader::~Shader() {
 
 void Shader::load(const char *vertex_file_path,
 		  const char *fragment_file_path) {
-  
-  // create and compile vertex shader object
+  TRACE_SCOPE("Shader::load");
+
+  reloadAsync(vertex_file_path,fragment_file_path);
+  update(true);
+}
+
+
+void Shader::reload(const char *vertex_file_path,
+		    const char *fragment_file_path) {
+  TRACE_SCOPE("Shader::reload");
+
+  reloadAsync(vertex_file_path,fragment_file_path);
+  update(true);
+}
+
+void Shader::reloadAsync(const char *vertex_file_path,
+			 const char *fragment_file_path) {
+  TRACE_SCOPE("Shader::reloadAsync");
+
+  // a newer request replaces the one still compiling
+  cancelPending();
+
+  _vertexFilename   = vertex_file_path;
+  _fragmentFilename = fragment_file_path;
+  _files.clear();
+
   std::string vertexCode   = getCode(vertex_file_path);
+  std::string fragmentCode = getCode(fragment_file_path);
+
+  // reuse the program linked by a previous run if the driver accepts it
+  _pendingBinary = cacheFilename(vertexCode,fragmentCode);
+  if(!_pendingBinary.empty()) {
+    GLuint programId = loadBinary(_pendingBinary);
+    if(programId) {
+      if(glIsProgram(_programId))
+        glDeleteProgram(_programId);
+      _programId = programId;
+      reflect(_programId,_uniforms);
+      clearVariants();
+      return;
+    }
+  }
+
+  _pendingProgram = submitProgram(vertexCode,fragmentCode,!_pendingBinary.empty(),
+                                  _pendingVertex,_pendingFragment);
+}
+
+bool Shader::update(bool wait) {
+  if(!_pendingProgram)
+    return false;
+
+  if(!wait && parallelCompile()) {
+    GLint done = GL_FALSE;
+    glGetProgramiv(_pendingProgram,GL_COMPLETION_STATUS_KHR,&done);
+    if(done!=GL_TRUE)
+      return false;
+  }
+
+  TRACE_SCOPE("Shader::update");
+
+  const GLuint programId = _pendingProgram;
+  const bool   linked    = finishProgram(programId,_pendingVertex,_pendingFragment);
+  _pendingProgram  = 0;
+  _pendingVertex   = 0;
+  _pendingFragment = 0;
+
+  if(!linked) {
+    if(_programId)
+      printf("Shader: keeping the previous program\n");
+    return false;
+  }
+
+  if(!_pendingBinary.empty())
+    saveBinary(programId,_pendingBinary);
+
+  // swap the new program in (the variants were built from the old sources)
+  if(glIsProgram(_programId))
+    glDeleteProgram(_programId);
+  _programId = programId;
+  reflect(_programId,_uniforms);
+  clearVariants();
+
+  return true;
+}
+
+const UniformTable &Shader::uniforms(GLuint programId) const {
+  for(std::list<Variant>::const_iterator it=_variants.begin();it!=_variants.end();++it) {
+    if(it->programId==programId && programId)
+      return it->uniforms;
+  }
+  return _uniforms;
+}
+
+GLuint Shader::blockBinding(const char *name) {
+  // one binding point per block name, shared by all the programs
+  static std::vector<std::string> blocks;
+
+  std::vector<std::string>::iterator it = std::find(blocks.begin(),blocks.end(),name);
+  if(it!=blocks.end())
+    return it-blocks.begin();
+
+  blocks.push_back(name);
+  return blocks.size()-1;
+}
+
+void Shader::reflect(GLuint programId,UniformTable &uniforms) {
+  TRACE_SCOPE("Shader::reflect");
+
+  uniforms.reflect(programId);
+
+  GLint nbBlocks = 0,maxLength = 0;
+  glGetProgramiv(programId,GL_ACTIVE_UNIFORM_BLOCKS,&nbBlocks);
+  glGetProgramiv(programId,GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH,&maxLength);
+
+  std::vector<char> name(maxLength+1);
+  for(GLint i=0;i<nbBlocks;++i) {
+    glGetActiveUniformBlockName(programId,i,maxLength+1,NULL,&name[0]);
+    glUniformBlockBinding(programId,i,blockBinding(&name[0]));
+  }
+}
+
+void UniformTable::reflect(GLuint programId) {
+  GLint nbUniforms = 0,maxLength = 0;
+  glGetProgramiv(programId,GL_ACTIVE_UNIFORMS,&nbUniforms);
+  glGetProgramiv(programId,GL_ACTIVE_UNIFORM_MAX_LENGTH,&maxLength);
+
+  // at most half full
+  size_t size = 8;
+  while(size<2*(size_t)nbUniforms)
+    size *= 2;
+  _entries.assign(size,Entry());
+
+  std::vector<char> name(maxLength+1);
+  for(GLint i=0;i<nbUniforms;++i) {
+    GLint  arraySize;
+    GLenum type;
+    glGetActiveUniform(programId,i,maxLength+1,NULL,&arraySize,&type,&name[0]);
+
+    // members of uniform blocks have no location
+    const GLint location = glGetUniformLocation(programId,&name[0]);
+    if(location<0)
+      continue;
+
+    // arrays are reported as "name[0]", look them up by "name"
+    std::string n(&name[0]);
+    if(n.size()>3 && !n.compare(n.size()-3,3,"[0]"))
+      n.resize(n.size()-3);
+
+    const uint64_t hash = fnv1a(n.data(),n.size());
+    size_t j = hash&(size-1);
+    while(!_entries[j].name.empty())
+      j = (j+1)&(size-1);
+
+    _entries[j].hash     = hash;
+    _entries[j].name     = n;
+    _entries[j].location = location;
+  }
+}
+
+void UniformTable::clear() {
+  _entries.clear();
+}
+
+GLint UniformTable::location(const char *name) const {
+  if(_entries.empty())
+    return -1;
+
+  const size_t   size = _entries.size();
+  const uint64_t hash = fnv1a(name,strlen(name));
+  for(size_t j=hash&(size-1);!_entries[j].name.empty();j=(j+1)&(size-1)) {
+    if(_entries[j].hash==hash && _entries[j].name==name)
+      return _entries[j].location;
+  }
+
+  return -1;
+}
+
+GLuint Shader::variant(const std::vector<std::string> &defines) {
+  if(defines.empty())
+    return _programId;
+
+  // lookup: no allocation, the hit is moved to the front
+  const uint64_t hash = definesHash(defines);
+  for(std::list<Variant>::iterator it=_variants.begin();it!=_variants.end();++it) {
+    if(it->hash==hash && sameDefines(it->defines,defines)) {
+      if(it!=_variants.begin())
+        _variants.splice(_variants.begin(),_variants,it);
+      return it->programId ? it->programId : _programId;
+    }
+  }
+
+  TRACE_SCOPE("Shader::variant");
+
+  std::string vertexCode   = getCode(_vertexFilename.c_str(),defines);
+  std::string fragmentCode = getCode(_fragmentFilename.c_str(),defines);
+  std::string binary       = cacheFilename(vertexCode,fragmentCode);
+
+  GLuint programId = binary.empty() ? 0 : loadBinary(binary);
+  if(!programId) {
+    GLuint vertexId,fragmentId;
+    programId = submitProgram(vertexCode,fragmentCode,!binary.empty(),vertexId,fragmentId);
+    if(!finishProgram(programId,vertexId,fragmentId)) {
+      printf("Shader: variant failed, using the default program\n");
+      programId = 0; // remembered so that it is not compiled again every frame
+    } else if(!binary.empty()) {
+      saveBinary(programId,binary);
+    }
+  }
+
+  // evict the least recently used variants
+  while(!_variants.empty() && _variants.size()>=_maxVariants) {
+    if(_variants.back().programId)
+      glDeleteProgram(_variants.back().programId);
+    _variants.pop_back();
+  }
+
+  Variant v;
+  v.hash      = hash;
+  v.defines   = defines;
+  v.programId = programId;
+  _variants.push_front(v);
+  if(programId)
+    reflect(programId,_variants.front().uniforms);
+
+  return programId ? programId : _programId;
+}
+
+void Shader::setMaxVariants(unsigned int n) {
+  _maxVariants = n>0 ? n : 1;
+
+  while(_variants.size()>_maxVariants) {
+    if(_variants.back().programId)
+      glDeleteProgram(_variants.back().programId);
+    _variants.pop_back();
+  }
+}
+
+void Shader::clearVariants() {
+  for(std::list<Variant>::iterator it=_variants.begin();it!=_variants.end();++it) {
+    if(it->programId)
+      glDeleteProgram(it->programId);
+  }
+  _variants.clear();
+}
+
+GLuint Shader::submitProgram(const std::string &vertexCode,const std::string &fragmentCode,
+			     bool retrievable,GLuint &vertexId,GLuint &fragmentId) {
+  // create and compile vertex shader object
   const char * vertexCodeC = vertexCode.c_str();
-  GLuint vertexId   = glCreateShader(GL_VERTEX_SHADER);
+  vertexId = glCreateShader(GL_VERTEX_SHADER);
   glShaderSource(vertexId,1,&(vertexCodeC),NULL);
   glCompileShader(vertexId);
-  checkCompilation(vertexId);
 
   // create and compile fragment shader object
-  std::string fragmentCode = getCode(fragment_file_path);
   const char * fragmentCodeC = fragmentCode.c_str();
-  GLuint fragmentId = glCreateShader(GL_FRAGMENT_SHADER);
+  fragmentId = glCreateShader(GL_FRAGMENT_SHADER);
   glShaderSource(fragmentId,1,&(fragmentCodeC),NULL);
   glCompileShader(fragmentId);
-  checkCompilation(fragmentId);
 
   // create, attach and link program object
-  _programId = glCreateProgram();
-  glAttachShader(_programId,vertexId);
-  glAttachShader(_programId,fragmentId);
-  glLinkProgram(_programId);
-  checkLinks(_programId);
+  // (no status query here: it would wait for the compilation)
+  GLuint programId = glCreateProgram();
+  glAttachShader(programId,vertexId);
+  glAttachShader(programId,fragmentId);
+  if(retrievable)
+    glProgramParameteri(programId,GL_PROGRAM_BINARY_RETRIEVABLE_HINT,GL_TRUE);
+  glLinkProgram(programId);
+
+  return programId;
+}
+
+bool Shader::finishProgram(GLuint programId,GLuint vertexId,GLuint fragmentId) {
+  // display syntax errors
+  checkCompilation(vertexId);
+  checkCompilation(fragmentId);
+  const bool linked = checkLinks(programId);
 
   // delete vertex and fragment ids
   glDeleteShader(vertexId);
   glDeleteShader(fragmentId);
+
+  if(!linked)
+    glDeleteProgram(programId);
+
+  return linked;
 }
 
+void Shader::cancelPending() {
+  if(_pendingProgram)
+    glDeleteProgram(_pendingProgram);
+  if(_pendingVertex)
+    glDeleteShader(_pendingVertex);
+  if(_pendingFragment)
+    glDeleteShader(_pendingFragment);
 
-void Shader::reload(const char *vertex_file_path,
-		    const char *fragment_file_path) {
-  
-  // check if the program already contains a shader 
-  if(glIsProgram(_programId)) {
-    // delete it...
-    glDeleteProgram(_programId);
+  _pendingProgram  = 0;
+  _pendingVertex   = 0;
+  _pendingFragment = 0;
+}
+
+bool Shader::parallelCompile() {
+  // -1: not checked yet (needs a current context)
+  static int supported = -1;
+
+  if(supported<0) {
+    GLint nbExtensions = 0;
+    supported = 0;
+
+    glGetIntegerv(GL_NUM_EXTENSIONS,&nbExtensions);
+    for(GLint i=0;i<nbExtensions && !supported;++i) {
+      const char *name = (const char *)glGetStringi(GL_EXTENSIONS,i);
+      if(name && (!strcmp(name,"GL_KHR_parallel_shader_compile") || !strcmp(name,"GL_ARB_parallel_shader_compile")))
+        supported = 1;
+    }
+
+    // let the driver use as many compiler threads as it wants
+    if(supported) {
+      typedef void (*MaxShaderCompilerThreads)(GLuint count);
+      MaxShaderCompilerThreads f = (MaxShaderCompilerThreads)glXGetProcAddressARB((const GLubyte *)"glMaxShaderCompilerThreadsKHR");
+      if(!f)
+        f = (MaxShaderCompilerThreads)glXGetProcAddressARB((const GLubyte *)"glMaxShaderCompilerThreadsARB");
+      if(f)
+        f(0xFFFFFFFF);
+    }
   }
 
-  // ... and reload it
-  load(vertex_file_path,fragment_file_path);
+  return supported==1;
 }
 
 
 
 
-void Shader::checkCompilation(GLuint shaderId) {
+bool Shader::checkCompilation(GLuint shaderId) {
   // check if the compilation was successfull (and display syntax errors)
   // call it after each shader compilation
   GLint result = GL_FALSE;
@@ -86,9 +413,11 @@ void Shader::checkCompilation(GLuint shaderId) {
     glGetShaderInfoLog(shaderId,infoLogLength,NULL,&message[0]);
     printf("%s\n", &message[0]);
   }
+
+  return result==GL_TRUE;
 }
 
-void Shader::checkLinks(GLuint programId) {
+bool Shader::checkLinks(GLuint programId) {
   // check if links were successfull (and display errors)
   // call it after linking the program  
   GLint result = GL_FALSE;
@@ -102,22 +431,208 @@ void Shader::checkLinks(GLuint programId) {
     glGetProgramInfoLog(programId,infoLogLength,NULL,&message[0]);
     printf("%s\n", &message[0]);
   }
+
+  return result==GL_TRUE;
 }
 
-std::string Shader::getCode(const char *file_path) {
+std::string Shader::getCode(const char *file_path,const std::vector<std::string> &defines) {
   // return a string containing the source code of the input file
-  std::string   shaderCode;
-  std::ifstream shaderStream(file_path,std::ios::in);
+  std::string              shaderCode;
+  std::vector<std::string> stack;
+
+  if(!appendFile(file_path,shaderCode,stack))
+    return "";
+
+  if(defines.empty())
+    return shaderCode;
+
+  // the defines must come after #version (the first line of the file),
+  // #line keeps the line numbers of the error messages
+  size_t pos = shaderCode.find("#version");
+  size_t line = 1;
+  if(pos!=std::string::npos && (pos=shaderCode.find('\n',pos))!=std::string::npos) {
+    line = std::count(shaderCode.begin(),shaderCode.begin()+pos,'\n')+2;
+    pos++;
+  } else {
+    pos = 0;
+  }
+
+  std::string header;
+  for(size_t i=0;i<defines.size();++i)
+    header += "#define "+defines[i]+"\n";
+  char lineDirective[32];
+  snprintf(lineDirective,sizeof(lineDirective),"#line %lu 0\n",(unsigned long)line);
+  header += lineDirective;
+
+  return shaderCode.insert(pos,header);
+}
+
+bool Shader::appendFile(const std::string &file_path,std::string &code,
+			std::vector<std::string> &stack) {
+  // #include "file" is replaced by the file content, each file is a
+  // different source string number for #line (its index in files())
+  if(std::find(stack.begin(),stack.end(),file_path)!=stack.end()) {
+    cout << "Recursive #include of " << file_path << endl;
+    return false;
+  }
+
+  std::ifstream shaderStream(file_path.c_str(),std::ios::in);
 
   if(!shaderStream.is_open()) {
     cout << "Unable to open " << file_path << endl;
-    return "";
+    return false;
   }
 
+  const size_t index = std::find(_files.begin(),_files.end(),file_path)-_files.begin();
+  if(index==_files.size())
+    _files.push_back(file_path);
+
+  char lineDirective[32];
+  if(!stack.empty()) {
+    snprintf(lineDirective,sizeof(lineDirective),"#line 1 %lu\n",(unsigned long)index);
+    code += lineDirective;
+  }
+
+  const size_t slash = file_path.rfind('/');
+  const std::string dir = slash==std::string::npos ? "" : file_path.substr(0,slash+1);
+
+  stack.push_back(file_path);
+
   std::string line = "";
-  while(getline(shaderStream,line))
-    shaderCode += "\n" + line;
+  unsigned long lineNumber = 0;
+  bool ok = true;
+  while(ok && getline(shaderStream,line)) {
+    lineNumber++;
+
+    const size_t start = line.find_first_not_of(" \t");
+    if(start==std::string::npos || line.compare(start,8,"#include")!=0) {
+      code += line + "\n";
+      continue;
+    }
+
+    const size_t open  = line.find('"',start+8);
+    const size_t close = open==std::string::npos ? open : line.find('"',open+1);
+    if(close==std::string::npos) {
+      cout << file_path << ":" << lineNumber << ": malformed #include" << endl;
+      ok = false;
+      break;
+    }
+
+    std::string included = line.substr(open+1,close-open-1);
+    if(included.empty() || included[0]!='/')
+      included = dir+included;
+
+    ok = appendFile(included,code,stack);
+
+    snprintf(lineDirective,sizeof(lineDirective),"#line %lu %lu\n",lineNumber+1,(unsigned long)index);
+    code += lineDirective;
+  }
   shaderStream.close();
-  
-  return shaderCode;
+
+  stack.pop_back();
+  return ok;
+}
+
+std::string Shader::cacheFilename(const std::string &vertexCode,const std::string &fragmentCode) {
+  // SIM_SHADER_CACHE=<dir> chooses the cache directory, SIM_SHADER_CACHE=0 disables it
+  const char *env  = getenv("SIM_SHADER_CACHE");
+  const char *home = getenv("HOME");
+  std::string dir;
+
+  if(!GLEW_ARB_get_program_binary || (env && !strcmp(env,"0")))
+    return "";
+
+  if(env && env[0]) {
+    dir = env;
+  } else if(home && home[0]) {
+    dir = std::string(home)+"/.cache";
+    mkdir(dir.c_str(),0755);
+    dir += "/tp03-shaders";
+  } else {
+    return "";
+  }
+  mkdir(dir.c_str(),0755);
+
+  // binaries are only valid for the same sources and the same driver
+  const GLubyte *strings[3] = {glGetString(GL_VENDOR),glGetString(GL_RENDERER),glGetString(GL_VERSION)};
+  std::string key = vertexCode+'\0'+fragmentCode;
+  for(int i=0;i<3;++i) {
+    key += '\0';
+    if(strings[i])
+      key += (const char *)strings[i];
+  }
+
+  const uint64_t hash = fnv1a(key.data(),key.size());
+
+  char name[32];
+  snprintf(name,sizeof(name),"/%016llx.bin",(unsigned long long)hash);
+  return dir+name;
+}
+
+GLuint Shader::loadBinary(const std::string &filename) {
+  TRACE_SCOPE("Shader::loadBinary");
+
+  FILE *file;
+  GLenum format;
+  GLint length;
+
+  if((file=fopen(filename.c_str(),"rb"))==NULL)
+    return 0;
+
+  // file: binary format, length, program binary
+  std::vector<char> binary;
+  bool ok = fread(&format,sizeof(format),1,file)==1 &&
+    fread(&length,sizeof(length),1,file)==1 && length>0;
+  if(ok) {
+    binary.resize(length);
+    ok = fread(&binary[0],1,length,file)==(size_t)length;
+  }
+  fclose(file);
+
+  if(!ok)
+    return 0;
+
+  GLuint programId = glCreateProgram();
+  glProgramBinary(programId,format,&binary[0],length);
+
+  // the driver may reject binaries (driver update, other GPU...)
+  GLint result = GL_FALSE;
+  glGetProgramiv(programId,GL_LINK_STATUS,&result);
+  if(result!=GL_TRUE) {
+    while(glGetError()!=GL_NO_ERROR) {}
+    glDeleteProgram(programId);
+    remove(filename.c_str());
+    return 0;
+  }
+
+  return programId;
+}
+
+void Shader::saveBinary(GLuint programId,const std::string &filename) {
+  GLint length = 0;
+  GLenum format;
+
+  glGetProgramiv(programId,GL_PROGRAM_BINARY_LENGTH,&length);
+  if(length<=0)
+    return;
+
+  std::vector<char> binary(length);
+  glGetProgramBinary(programId,length,NULL,&format,&binary[0]);
+
+  // write a temporary file first so that a concurrent run never reads half of it
+  const std::string tmpFilename = filename+".tmp";
+  FILE *file;
+
+  if((file=fopen(tmpFilename.c_str(),"wb"))==NULL) {
+    printf("Unable to write %s\n",tmpFilename.c_str());
+    return;
+  }
+
+  const bool ok = fwrite(&format,sizeof(format),1,file)==1 &&
+    fwrite(&length,sizeof(length),1,file)==1 &&
+    fwrite(&binary[0],1,length,file)==(size_t)length;
+  fclose(file);
+
+  if(!ok || rename(tmpFilename.c_str(),filename.c_str())!=0)
+    remove(tmpFilename.c_str());
 }
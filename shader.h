@@ -2,7 +2,30 @@
 #define SHADER_H
 
 #include <GL/glew.h>
+#include <stdint.h>
+#include <list>
 #include <string>
+#include <vector>
+
+// locations of the active uniforms of a program, read once after link:
+// open addressing on the hash of the names, lookups do not allocate
+class UniformTable {
+ public:
+  void  reflect(GLuint programId);
+  void  clear();
+
+  // -1 if the uniform is not active in the program
+  GLint location(const char *name) const;
+
+ private:
+  struct Entry {
+    uint64_t    hash;
+    std::string name; // empty slot if empty
+    GLint       location;
+  };
+
+  std::vector<Entry> _entries; // power of two size
+};
 
 class Shader {
  public:
@@ -12,22 +35,98 @@ class Shader {
   void load(const char *vertex_file_path,
 	    const char *fragment_file_path);
   
+  // the current program is kept if the new one does not compile/link
   void reload(const char *vertex_file_path,
 	      const char *fragment_file_path);
 
+  // start compiling the new program and return immediately: the current
+  // program stays in use until update() swaps the new one in
+  void reloadAsync(const char *vertex_file_path,
+		   const char *fragment_file_path);
+
+  // poll the pending compilation (wait=true blocks until it is done),
+  // return true when a new program replaced the current one
+  bool update(bool wait=false);
+
+  inline bool pending() const {return _pendingProgram!=0;}
+
   inline GLuint id() {return _programId;}
 
+  // reflected uniform locations of id() or of one of the variants
+  const UniformTable &uniforms(GLuint programId) const;
+
+  // uniform blocks are bound by name: every program declaring a block
+  // with this name reads the buffer bound to the returned binding point
+  static GLuint blockBinding(const char *name);
+
+  // specialized program compiled from the same sources with extra #define
+  // lines ("NAME" or "NAME VALUE", in any order). Variants are compiled on
+  // first use and kept in a least-recently-used cache, flushed on reload.
+  // Falls back to id() if the variant does not compile.
+  GLuint variant(const std::vector<std::string> &defines);
+  void setMaxVariants(unsigned int n);
+
+  // every file read by the last (re)load, #included ones too
+  inline const std::vector<std::string> &files() const {return _files;}
+
  private:
-  GLuint _programId;
+  GLuint       _programId;
+  UniformTable _uniforms;
+
+  std::string              _vertexFilename;
+  std::string              _fragmentFilename;
+  std::vector<std::string> _files;
+
+  struct Variant {
+    uint64_t                 hash;
+    std::vector<std::string> defines;
+    GLuint                   programId; // 0 if it failed to compile
+    UniformTable             uniforms;
+  };
+
+  std::list<Variant> _variants; // most recently used first
+  unsigned int       _maxVariants;
+
+  void clearVariants();
 
-  // string containing the source code of the input file
-  std::string getCode(const char *file_path);
+  // after each link: uniform locations and uniform block bindings
+  static void reflect(GLuint programId,UniformTable &uniforms);
+
+  // program being compiled/linked by the driver
+  GLuint      _pendingProgram;
+  GLuint      _pendingVertex;
+  GLuint      _pendingFragment;
+  std::string _pendingBinary;
+
+  void cancelPending();
+
+  // GL_KHR/ARB_parallel_shader_compile: completion can be polled without blocking
+  static bool parallelCompile();
+
+  // string containing the source code of the input file, with the
+  // #include "file" lines resolved (relative to the including file) and
+  // the defines inserted after #version
+  std::string getCode(const char *file_path,
+		      const std::vector<std::string> &defines=std::vector<std::string>());
+  bool appendFile(const std::string &file_path,std::string &code,
+		  std::vector<std::string> &stack);
+
+  // compile and link without waiting for the driver / check the result
+  GLuint submitProgram(const std::string &vertexCode,const std::string &fragmentCode,
+		       bool retrievable,GLuint &vertexId,GLuint &fragmentId);
+  bool   finishProgram(GLuint programId,GLuint vertexId,GLuint fragmentId);
 
   // call it after each shader compilation
-  void checkCompilation(GLuint shaderId);
+  bool checkCompilation(GLuint shaderId);
 
   // call it after linking the program
-  void checkLinks(GLuint programId);
+  bool checkLinks(GLuint programId);
+
+  // program binary cache (GL_ARB_get_program_binary), one file per
+  // hash of the sources and of the GL vendor/renderer/version strings
+  std::string cacheFilename(const std::string &vertexCode,const std::string &fragmentCode);
+  GLuint loadBinary(const std::string &filename);
+  void   saveBinary(GLuint programId,const std::string &filename);
 };
 
 #endif // SHADER_H
@@ -0,0 +1,9 @@
+// per-frame camera data, one uniform buffer shared by all the programs
+// (std140: must match Viewer::CameraBlock)
+// mvp and mdv are relative to the eye: positions must be given relative to
+// the eye too (see Camera::relative)
+layout(std140) uniform Camera {
+  mat4 mvp;  // modelview projection matrix
+  mat4 mdv;  // modelview matrix
+  mat4 proj; // projection matrix
+};
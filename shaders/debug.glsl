@@ -0,0 +1,9 @@
+// debug views, enabled by the defines of the shader variant
+
+#ifdef DEBUG_DEPTH
+// window depth, stretched so that the far half of the range is visible
+vec3 debugColor() {
+  float d = pow(gl_FragCoord.z,32.0);
+  return vec3(d,d,1.0-d);
+}
+#endif
@@ -7,6 +7,7 @@ uniform vec3 myColor;
 
 uniform vec3 myOtherColor;
 
+#include "debug.glsl"
 
 
 void main() {
@@ -14,7 +15,11 @@ void main() {
   // re-normalize 
   //vec3 color = mix(vec3(sin(var)*0.5+0.5,sin(var)*0.5+0.5,sin(var)*0.5+0.5),myColor,var);
   // normal coordinates are used as colors here 
+#ifdef DEBUG_DEPTH
+  bufferColor = vec4(debugColor(),1.0);
+#else
   bufferColor = vec4(myColor*0.5+0.5,1.0);
+#endif
 
   // color modified by a global variable 
   //bufferColor = vec4(color*normal,1.0);
@@ -4,13 +4,15 @@
 layout(location = 0) in vec3 position;
 
 
-uniform mat4 mvp; // modelview projection matrix (constant for all the vertices)
+#include "camera.glsl"
 
+// origin of the tile relative to the eye
+uniform vec3 origin;
 
 
 
 void main() {
-  vec3 pos = vec3(position.x,position.y,position.z);
+  vec3 pos = vec3(position.x,position.y,position.z)+origin;
     //vec3 pos = vec3(position.x*2*sin(var)+2*smoothstep(position.z,sin(1+var),cos(2-var)),position.y,position.z);
   //vec3 pos = vec3(mix(position.xy,(position.x+position.y)/2.0),position.y,position.z);
     gl_Position = mvp*vec4(pos,1.0);
@@ -0,0 +1,12 @@
+#version 330
+
+layout(location = 0) in vec3 position;
+
+// per instance (attribute divisor 1): mesh -> world, relative to the eye
+layout(location = 2) in mat4 instance;
+
+#include "camera.glsl"
+
+void main() {
+  gl_Position = mvp*instance*vec4(position,1.0);
+}
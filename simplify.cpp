@@ -0,0 +1,413 @@
+#include "simplify.h"
+
+#include <algorithm>
+#include <thread>
+#include <math.h>
+#include <stdint.h>
+
+namespace {
+
+  // sum of squared distances to planes (weighted by the areas of their
+  // triangles): x^T A x + 2 b.x + c, A symmetric
+  struct Quadric {
+    double a00,a01,a02,a11,a12,a22;
+    double b0,b1,b2;
+    double c;
+    double w;
+
+    inline void clear() {
+      a00 = a01 = a02 = a11 = a12 = a22 = b0 = b1 = b2 = c = w = 0.0;
+    }
+
+    inline void addPlane(double nx,double ny,double nz,double d,double weight) {
+      a00 += weight*nx*nx; a01 += weight*nx*ny; a02 += weight*nx*nz;
+      a11 += weight*ny*ny; a12 += weight*ny*nz; a22 += weight*nz*nz;
+      b0  += weight*nx*d;  b1  += weight*ny*d;  b2  += weight*nz*d;
+      c   += weight*d*d;
+      w   += weight;
+    }
+
+    inline void add(const Quadric &q) {
+      a00 += q.a00; a01 += q.a01; a02 += q.a02;
+      a11 += q.a11; a12 += q.a12; a22 += q.a22;
+      b0  += q.b0;  b1  += q.b1;  b2  += q.b2;
+      c   += q.c;
+      w   += q.w;
+    }
+
+    // mean squared distance of p to the planes
+    inline double error(const float *p) const {
+      const double x = p[0],y = p[1],z = p[2];
+      const double e = a00*x*x + a11*y*y + a22*z*z +
+	2.0*(a01*x*y + a02*x*z + a12*y*z) +
+	2.0*(b0*x + b1*y + b2*z) + c;
+      return w>0.0 ? std::max(e,0.0)/w : 0.0;
+    }
+  };
+
+  struct Collapse {
+    float        error;
+    unsigned int from;
+    unsigned int to;
+
+    inline bool operator<(const Collapse &c) const {return error<c.error;}
+  };
+
+  inline void normal(const float *p0,const float *p1,const float *p2,double *n) {
+    const double e1[3] = {p1[0]-p0[0],p1[1]-p0[1],p1[2]-p0[2]};
+    const double e2[3] = {p2[0]-p0[0],p2[1]-p0[1],p2[2]-p0[2]};
+    n[0] = e1[1]*e2[2]-e1[2]*e2[1];
+    n[1] = e1[2]*e2[0]-e1[0]*e2[2];
+    n[2] = e1[0]*e2[1]-e1[1]*e2[0];
+  }
+
+  inline uint64_t edgeKey(unsigned int a,unsigned int b) {
+    return a<b ? ((uint64_t)a<<32)|b : ((uint64_t)b<<32)|a;
+  }
+
+  // collapses on the triangles of indices (in place), the vertices that
+  // are locked or on a border never move. Returns the largest error, the
+  // collapses done are appended to log (from, to) if not NULL
+  float collapse(const float *vertices,unsigned int nbVertices,
+		 std::vector<unsigned int> &indices,const std::vector<bool> &locked,
+		 unsigned int targetIndices,float maxError,std::vector<unsigned int> *log,
+		 const std::atomic<bool> *cancel) {
+    std::vector<Quadric> quadrics(nbVertices);
+    for(unsigned int v=0;v<nbVertices;++v)
+      quadrics[v].clear();
+
+    for(unsigned int i=0;i<indices.size();i+=3) {
+      const float *p0 = vertices+3*indices[i];
+      double n[3];
+      normal(p0,vertices+3*indices[i+1],vertices+3*indices[i+2],n);
+      const double l = sqrt(n[0]*n[0]+n[1]*n[1]+n[2]*n[2]);
+      if(l==0.0)
+	continue;
+
+      const double nx = n[0]/l,ny = n[1]/l,nz = n[2]/l;
+      const double d  = -(nx*p0[0]+ny*p0[1]+nz*p0[2]);
+      for(int k=0;k<3;++k)
+	quadrics[indices[i+k]].addPlane(nx,ny,nz,d,0.5*l);
+    }
+
+    // vertices that can move: not locked, not on a border or a non manifold edge
+    std::vector<bool> fixed(locked);
+    {
+      std::vector<uint64_t> edges(indices.size());
+      for(unsigned int i=0;i<indices.size();i+=3) {
+	for(int k=0;k<3;++k)
+	  edges[i+k] = edgeKey(indices[i+k],indices[i+(k+1)%3]);
+      }
+      std::sort(edges.begin(),edges.end());
+      for(unsigned int i=0;i<edges.size();) {
+	unsigned int j = i+1;
+	while(j<edges.size() && edges[j]==edges[i])
+	  j++;
+	if(j-i!=2) {
+	  fixed[edges[i]>>32]        = true;
+	  fixed[edges[i]&0xffffffff] = true;
+	}
+	i = j;
+      }
+    }
+
+    std::vector<unsigned int> first(nbVertices+1),around,remap(nbVertices);
+    std::vector<bool>         touched(nbVertices);
+    std::vector<unsigned int> mark(nbVertices);
+    std::vector<Collapse>     collapses;
+    std::vector<uint64_t>     edges;
+    float result = 0.0f;
+
+    while(indices.size()>targetIndices && !(cancel && cancel->load())) {
+      // triangles around each vertex
+      std::fill(first.begin(),first.end(),0);
+      for(unsigned int i=0;i<indices.size();++i)
+	first[indices[i]+1]++;
+      for(unsigned int v=0;v<nbVertices;++v)
+	first[v+1] += first[v];
+      around.resize(indices.size());
+      {
+	std::vector<unsigned int> next(first.begin(),first.end()-1);
+	for(unsigned int i=0;i<indices.size();++i)
+	  around[next[indices[i]]++] = i/3;
+      }
+
+      // best direction of each edge
+      edges.resize(indices.size());
+      for(unsigned int i=0;i<indices.size();i+=3) {
+	for(int k=0;k<3;++k)
+	  edges[i+k] = edgeKey(indices[i+k],indices[i+(k+1)%3]);
+      }
+      std::sort(edges.begin(),edges.end());
+      edges.erase(std::unique(edges.begin(),edges.end()),edges.end());
+
+      collapses.clear();
+      for(unsigned int i=0;i<edges.size();++i) {
+	const unsigned int a = edges[i]>>32,b = edges[i]&0xffffffff;
+	if(fixed[a] && fixed[b])
+	  continue;
+
+	Quadric q = quadrics[a];
+	q.add(quadrics[b]);
+
+	Collapse c;
+	c.error = -1.0f;
+	if(!fixed[a]) {
+	  c.error = (float)sqrt(q.error(vertices+3*b));
+	  c.from  = a;
+	  c.to    = b;
+	}
+	if(!fixed[b]) {
+	  const float e = (float)sqrt(q.error(vertices+3*a));
+	  if(c.error<0.0f || e<c.error) {
+	    c.error = e;
+	    c.from  = b;
+	    c.to    = a;
+	  }
+	}
+	if(c.error<=maxError)
+	  collapses.push_back(c);
+      }
+      std::sort(collapses.begin(),collapses.end());
+
+      // the cheapest collapses that do not share triangles
+      for(unsigned int v=0;v<nbVertices;++v)
+	remap[v] = v;
+      std::fill(touched.begin(),touched.end(),false);
+      std::fill(mark.begin(),mark.end(),~0u);
+
+      unsigned int removed = 0;
+      const unsigned int needed = (indices.size()-targetIndices)/3;
+      for(unsigned int i=0;i<collapses.size() && removed<needed;++i) {
+	const Collapse &c = collapses[i];
+	if(touched[c.from] || touched[c.to])
+	  continue;
+
+	// the only vertices next to both from and to are the third ones of
+	// their common triangles (otherwise the surface folds on itself)
+	unsigned int gone = 0,common = 0;
+	for(unsigned int j=first[c.from];j<first[c.from+1];++j) {
+	  const unsigned int *t = &indices[3*around[j]];
+	  gone += t[0]==c.to || t[1]==c.to || t[2]==c.to;
+	  for(int k=0;k<3;++k)
+	    mark[t[k]] = i;
+	}
+	for(unsigned int j=first[c.to];j<first[c.to+1];++j) {
+	  const unsigned int *t = &indices[3*around[j]];
+	  for(int k=0;k<3;++k) {
+	    if(mark[t[k]]==i && t[k]!=c.from && t[k]!=c.to) {
+	      mark[t[k]] = ~0u;
+	      common++;
+	    }
+	  }
+	}
+	if(common!=gone)
+	  continue;
+
+	// no triangle around from may flip (or become degenerate)
+	bool flips = false;
+	for(unsigned int j=first[c.from];j<first[c.from+1] && !flips;++j) {
+	  const unsigned int *t = &indices[3*around[j]];
+	  if(t[0]==c.to || t[1]==c.to || t[2]==c.to)
+	    continue;
+
+	  const float *p[3],*q[3];
+	  for(int k=0;k<3;++k) {
+	    p[k] = vertices+3*t[k];
+	    q[k] = t[k]==c.from ? vertices+3*c.to : p[k];
+	  }
+	  double n0[3],n1[3];
+	  normal(p[0],p[1],p[2],n0);
+	  normal(q[0],q[1],q[2],n1);
+	  flips = n0[0]*n1[0]+n0[1]*n1[1]+n0[2]*n1[2]<=0.0;
+	}
+	if(flips)
+	  continue;
+
+	remap[c.from] = c.to;
+	quadrics[c.to].add(quadrics[c.from]);
+	if(log) {
+	  log->push_back(c.from);
+	  log->push_back(c.to);
+	}
+	result   = std::max(result,c.error);
+	removed += gone;
+
+	// the triangles around from changed: no other collapse in them
+	for(unsigned int j=first[c.from];j<first[c.from+1];++j) {
+	  const unsigned int *t = &indices[3*around[j]];
+	  touched[t[0]] = touched[t[1]] = touched[t[2]] = true;
+	}
+      }
+
+      if(removed==0)
+	break;
+
+      // new triangles, without the degenerate ones
+      unsigned int n = 0;
+      for(unsigned int i=0;i<indices.size();i+=3) {
+	const unsigned int a = remap[indices[i]],b = remap[indices[i+1]],c = remap[indices[i+2]];
+	if(a!=b && b!=c && a!=c) {
+	  indices[n++] = a;
+	  indices[n++] = b;
+	  indices[n++] = c;
+	}
+      }
+      indices.resize(n);
+    }
+
+    return result;
+  }
+
+  // triangles of one slab, with their own (compact) vertices
+  struct Slab {
+    std::vector<unsigned int> vertices; // global indices
+    std::vector<float>        positions;
+    std::vector<unsigned int> indices;  // local
+    std::vector<bool>         locked;
+    std::vector<unsigned int> log;      // local
+    unsigned int              target;
+    float                     error;
+  };
+
+}
+
+float Simplifier::simplify(const float *vertices,unsigned int nbVertices,
+			   const unsigned int *indices,unsigned int nbIndices,
+			   unsigned int targetIndices,float maxError,
+			   std::vector<unsigned int> &result,unsigned int nbThreads,
+			   std::vector<unsigned int> *collapses,const std::atomic<bool> *cancel) {
+  if(nbThreads==0)
+    nbThreads = std::max(1u,std::thread::hardware_concurrency());
+
+  result.assign(indices,indices+nbIndices);
+  std::vector<bool> none(nbVertices,false);
+
+  // small meshes: not worth the threads and the seams
+  const unsigned int nbSlabs = std::min(nbThreads,nbIndices/(3*65536));
+  if(nbSlabs<=1)
+    return collapse(vertices,nbVertices,result,none,targetIndices,maxError,collapses,cancel);
+
+  // slab of each triangle (center along the largest axis)
+  float min[3] = {vertices[0],vertices[1],vertices[2]},max[3] = {min[0],min[1],min[2]};
+  for(unsigned int v=1;v<nbVertices;++v) {
+    for(int k=0;k<3;++k) {
+      min[k] = std::min(min[k],vertices[3*v+k]);
+      max[k] = std::max(max[k],vertices[3*v+k]);
+    }
+  }
+  const int   axis  = max[0]-min[0]>max[1]-min[1] ? (max[0]-min[0]>max[2]-min[2] ? 0 : 2) : (max[1]-min[1]>max[2]-min[2] ? 1 : 2);
+  const float scale = max[axis]>min[axis] ? nbSlabs/(max[axis]-min[axis]) : 0.0f;
+
+  std::vector<unsigned int> owner(nbVertices,~0u); // slab, or ~1u if shared
+  std::vector<unsigned int> slabOf(nbIndices/3);
+  for(unsigned int i=0;i<nbIndices;i+=3) {
+    float c = 0.0f;
+    for(int k=0;k<3;++k)
+      c += vertices[3*indices[i+k]+axis];
+    const unsigned int s = std::min(nbSlabs-1,(unsigned int)std::max(0.0f,(c/3.0f-min[axis])*scale));
+    slabOf[i/3] = s;
+    for(int k=0;k<3;++k) {
+      unsigned int &o = owner[indices[i+k]];
+      o = o==~0u || o==s ? s : ~1u;
+    }
+  }
+
+  // compact copies of the slabs
+  std::vector<Slab>         slabs(nbSlabs);
+  std::vector<unsigned int> local(nbVertices),localSlab(nbVertices,~0u);
+  for(unsigned int i=0;i<nbIndices;i+=3) {
+    Slab &s = slabs[slabOf[i/3]];
+    for(int k=0;k<3;++k) {
+      const unsigned int v = indices[i+k];
+      if(localSlab[v]!=slabOf[i/3]) {
+	localSlab[v] = slabOf[i/3];
+	local[v]     = s.vertices.size();
+	s.vertices.push_back(v);
+	s.positions.insert(s.positions.end(),vertices+3*v,vertices+3*v+3);
+	s.locked.push_back(owner[v]==~1u);
+      }
+      s.indices.push_back(local[v]);
+    }
+  }
+
+  std::vector<std::thread> threads;
+  for(unsigned int i=0;i<nbSlabs;++i) {
+    Slab &s  = slabs[i];
+    s.target = (unsigned int)((double)targetIndices*s.indices.size()/nbIndices)/3*3;
+    threads.push_back(std::thread([&s,maxError,collapses,cancel]() {
+	  s.error = collapse(&s.positions[0],s.vertices.size(),s.indices,s.locked,s.target,maxError,
+			     collapses ? &s.log : NULL,cancel);
+	}));
+  }
+  for(unsigned int i=0;i<threads.size();++i)
+    threads[i].join();
+
+  // back to the global vertices, then the seams
+  float error = 0.0f;
+  result.clear();
+  for(unsigned int i=0;i<nbSlabs;++i) {
+    for(unsigned int j=0;j<slabs[i].indices.size();++j)
+      result.push_back(slabs[i].vertices[slabs[i].indices[j]]);
+    error = std::max(error,slabs[i].error);
+
+    // the slabs share no moving vertex: their collapses are independent
+    if(collapses) {
+      for(unsigned int j=0;j<slabs[i].log.size();++j)
+	collapses->push_back(slabs[i].vertices[slabs[i].log[j]]);
+    }
+  }
+
+  return error+collapse(vertices,nbVertices,result,none,targetIndices,std::max(0.0f,maxError-error),collapses,cancel);
+}
+
+void LodChain::build(const float *vertices,unsigned int nbVertices,
+		     const unsigned int *faces,unsigned int nbFaces,
+		     std::vector<unsigned int> &indices,
+		     unsigned int minTriangles,unsigned int maxLevels,
+		     const std::atomic<bool> *cancel) {
+  _levels.clear();
+  indices.assign(faces,faces+3*nbFaces);
+
+  Level l = {0,3*nbFaces,0.0f};
+  _levels.push_back(l);
+
+  std::vector<unsigned int> level;
+  while(_levels.size()<std::min(maxLevels,(unsigned int)MAX_LEVELS) && l.nbIndices/3>=2*minTriangles) {
+    // from the previous level: the errors add up
+    const float e = Simplifier::simplify(vertices,nbVertices,&indices[l.firstIndex],l.nbIndices,
+					 l.nbIndices/6*3,1e30f,level,0,NULL,cancel);
+
+    // stuck (borders...) or cancelled: no more levels
+    if(level.size()>l.nbIndices*3/4 || (cancel && cancel->load()))
+      break;
+
+    l.firstIndex = indices.size();
+    l.nbIndices  = level.size();
+    l.error     += e;
+    indices.insert(indices.end(),level.begin(),level.end());
+    _levels.push_back(l);
+  }
+}
+
+void LodChain::buildMeshlets(const float *vertices,unsigned int nbVertices,
+			     std::vector<unsigned int> &indices,std::vector<Meshlets> &meshlets) const {
+  std::vector<unsigned int> level;
+  meshlets.resize(_levels.size());
+  for(unsigned int l=0;l<_levels.size();++l) {
+    meshlets[l].build(vertices,nbVertices,indices.empty() ? NULL : &indices[_levels[l].firstIndex],_levels[l].nbIndices/3,level);
+    std::copy(level.begin(),level.end(),indices.begin()+_levels[l].firstIndex);
+  }
+}
+
+void LodChain::assign(unsigned int nbIndices) {
+  const Level l = {0,nbIndices,0.0f};
+  _levels.assign(1,l);
+}
+
+unsigned int LodChain::select(float distance,float pixelsPerUnit,float scale,float maxPixels) const {
+  unsigned int i = 0;
+  while(i+1<_levels.size() && _levels[i+1].error*scale*pixelsPerUnit<=maxPixels*distance)
+    i++;
+  return i;
+}
@@ -0,0 +1,74 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <vector>
+#include <atomic>
+#include "meshlets.h"
+
+// mesh simplification with quadric error metrics (Garland and Heckbert):
+// the edges are collapsed by increasing error, into one of their vertices,
+// so the result only uses vertices of the input (all the levels of detail
+// of a mesh share its vertex buffer). The vertices of the borders (edges
+// of one triangle) and of the non manifold edges never move: holes and
+// open borders keep their shape.
+//
+// Large meshes are cut in slabs along their largest axis, simplified in
+// parallel with the vertices shared by several slabs locked, then the
+// whole mesh is simplified again to remove the seams.
+class Simplifier {
+ public:
+  // indices: triangles. Collapses until targetIndices is reached, or the
+  // next collapse would move the surface by more than maxError (in the
+  // units of the vertices). Returns the error of the result.
+  // collapses: if not NULL, the collapses done, in order (pairs of vertices
+  // from, to: from is replaced by to in all the triangles after it).
+  // cancel: if not NULL and set (by another thread), stops after the
+  // current pass with what is done
+  static float simplify(const float *vertices,unsigned int nbVertices,
+			const unsigned int *indices,unsigned int nbIndices,
+			unsigned int targetIndices,float maxError,
+			std::vector<unsigned int> &result,unsigned int nbThreads=0,
+			std::vector<unsigned int> *collapses=NULL,
+			const std::atomic<bool> *cancel=NULL);
+};
+
+// levels of detail of a mesh: level 0 is the mesh itself, each next level
+// has about half the triangles of the previous one (simplified from it),
+// down to minTriangles. The indices of the levels are stored one after the
+// other. cancel: as for Simplifier::simplify, the levels done are kept
+class LodChain {
+ public:
+  enum {MAX_LEVELS=8};
+
+  struct Level {
+    unsigned int firstIndex;
+    unsigned int nbIndices;
+    float        error; // from the mesh, in the units of the vertices
+  };
+
+  void build(const float *vertices,unsigned int nbVertices,
+	     const unsigned int *faces,unsigned int nbFaces,
+	     std::vector<unsigned int> &indices,
+	     unsigned int minTriangles=256,unsigned int maxLevels=MAX_LEVELS,
+	     const std::atomic<bool> *cancel=NULL);
+
+  // meshlets of each level, the indices of each level reordered for them
+  void buildMeshlets(const float *vertices,unsigned int nbVertices,
+		     std::vector<unsigned int> &indices,std::vector<Meshlets> &meshlets) const;
+
+  // a single level: the first nbIndices indices, as they are
+  void assign(unsigned int nbIndices);
+
+  // coarsest level whose error, seen at distance with pixelsPerUnit
+  // pixels for one unit at distance 1 (h/(2*tan(fovy/2))), stays below
+  // maxPixels. scale: from the units of the mesh to the ones of distance
+  unsigned int select(float distance,float pixelsPerUnit,float scale=1.0f,float maxPixels=1.0f) const;
+
+  inline unsigned int size() const {return _levels.size();}
+  inline const Level &operator[](unsigned int i) const {return _levels[i];}
+
+ private:
+  std::vector<Level> _levels;
+};
+
+#endif // SIMPLIFY_H
@@ -0,0 +1,56 @@
+#include "streambuffer.h"
+
+#include <stdio.h>
+
+// enough for uniform buffer offsets on all the drivers
+static const GLintptr alignment = 256;
+
+StreamBuffer::StreamBuffer(GLenum target,GLsizeiptr size)
+  : _target(target),
+    _id(0),
+    _size(size),
+    _head(0) {
+
+  glGenBuffers(1,&_id);
+  orphan();
+}
+
+StreamBuffer::~StreamBuffer() {
+  glDeleteBuffers(1,&_id);
+}
+
+void StreamBuffer::orphan() {
+  glBindBuffer(_target,_id);
+  glBufferData(_target,_size,NULL,GL_STREAM_DRAW);
+  _head = 0;
+}
+
+void *StreamBuffer::map(GLsizeiptr size,GLintptr &offset) {
+  if(size>_size) {
+    // room for a few frames of the new size
+    _size = 3*size;
+    orphan();
+  } else if(_head+size>_size) {
+    orphan();
+  } else {
+    glBindBuffer(_target,_id);
+  }
+
+  offset = _head;
+  _head  = (_head+size+alignment-1)&~(alignment-1);
+
+  void *ptr = glMapBufferRange(_target,offset,size,
+			       GL_MAP_WRITE_BIT|GL_MAP_INVALIDATE_RANGE_BIT|GL_MAP_UNSYNCHRONIZED_BIT);
+  if(ptr==NULL)
+    printf("StreamBuffer: unable to map %ld bytes\n",(long)size);
+
+  return ptr;
+}
+
+void StreamBuffer::unmap() {
+  glBindBuffer(_target,_id);
+
+  // the content is lost in rare cases (screen mode change...): the next
+  // frame rewrites it anyway
+  glUnmapBuffer(_target);
+}
@@ -0,0 +1,35 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+// GLEW lib: needs to be included first!!
+#include <GL/glew.h>
+
+// buffer rewritten every frame (instance data...), used as a ring: each
+// map() returns a range that was not used since the last orphaning, so the
+// mapping never waits for the GPU (GL_MAP_UNSYNCHRONIZED_BIT). When the end
+// is reached, the storage is orphaned (glBufferData with NULL): the driver
+// gives a new block while the GPU still reads the previous one.
+class StreamBuffer {
+ public:
+  StreamBuffer(GLenum target,GLsizeiptr size);
+  ~StreamBuffer();
+
+  // write access to size bytes (the buffer stays bound to the target),
+  // offset: their position in the buffer, aligned on 256 bytes
+  // (glVertexAttribPointer, glBindBufferRange...)
+  void *map(GLsizeiptr size,GLintptr &offset);
+  void  unmap();
+
+  inline GLuint     id()   const {return _id;  }
+  inline GLsizeiptr size() const {return _size;}
+
+ private:
+  void orphan();
+
+  GLenum     _target;
+  GLuint     _id;
+  GLsizeiptr _size;
+  GLintptr   _head; // first byte not written since the last orphaning
+};
+
+#endif // STREAM_BUFFER_H
@@ -0,0 +1,158 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+  struct TraceEvent {
+    const char *name;
+    uint64_t    start;
+    uint64_t    end;
+  };
+
+  // recordings started by Trace::enable, each one clears the buffers
+  std::atomic<unsigned int> generation(0);
+
+  // events of one thread: only the owner writes, the count is published
+  // with release semantics so that dump() can read concurrently. The owner
+  // clears its own buffer when it is of an older generation (enable() does
+  // not touch it: the owner may be in record())
+  struct TraceBuffer {
+    static const unsigned int capacity = 1<<16;
+
+    TraceBuffer(unsigned int t) : tid(t), generation(::generation.load()), count(0), dropped(0) {}
+
+    unsigned int              tid;
+    std::atomic<unsigned int> generation;
+    std::atomic<unsigned int> count;
+    std::atomic<unsigned int> dropped;
+    TraceEvent                events[capacity];
+  };
+
+  // buffers are never freed so that events of finished threads can be dumped
+  std::mutex                 registryMutex;
+  std::vector<TraceBuffer *> registry;
+
+  TraceBuffer *threadBuffer() {
+    static thread_local TraceBuffer *buffer = 0;
+
+    if(!buffer) {
+      std::lock_guard<std::mutex> lock(registryMutex);
+      buffer = new TraceBuffer(registry.size()+1);
+      registry.push_back(buffer);
+    }
+
+    return buffer;
+  }
+
+  // escape the characters that are not allowed in a JSON string
+  void writeString(FILE *file,const char *s) {
+    fputc('"',file);
+    for(;*s;++s) {
+      if(*s=='"' || *s=='\\')
+        fputc('\\',file);
+      fputc(*s,file);
+    }
+    fputc('"',file);
+  }
+
+}
+
+std::atomic<bool> Trace::_enabled(false);
+
+void Trace::enable() {
+  // allocate the buffer of the calling thread now rather than in its first traced frame
+  threadBuffer();
+
+  // the events recorded before are ignored, each buffer is cleared by its
+  // thread at its next event
+  generation.fetch_add(1,std::memory_order_acq_rel);
+  _enabled.store(true,std::memory_order_release);
+}
+
+void Trace::disable() {
+  _enabled.store(false,std::memory_order_release);
+}
+
+const char *Trace::outputFilename() {
+  const char *filename = getenv("SIM_TRACE");
+  return (filename && filename[0]) ? filename : "trace.json";
+}
+
+uint64_t Trace::now() {
+  return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char *name,uint64_t start,uint64_t end) {
+  TraceBuffer *buffer = threadBuffer();
+
+  // first event of a new recording: the count is cleared before the
+  // generation is published
+  const unsigned int g = generation.load(std::memory_order_acquire);
+  if(buffer->generation.load(std::memory_order_relaxed)!=g) {
+    buffer->count.store(0,std::memory_order_relaxed);
+    buffer->dropped.store(0,std::memory_order_relaxed);
+    buffer->generation.store(g,std::memory_order_release);
+  }
+
+  const unsigned int n = buffer->count.load(std::memory_order_relaxed);
+
+  if(n>=TraceBuffer::capacity) {
+    buffer->dropped.fetch_add(1,std::memory_order_relaxed);
+    return;
+  }
+
+  buffer->events[n].name  = name;
+  buffer->events[n].start = start;
+  buffer->events[n].end   = end;
+  buffer->count.store(n+1,std::memory_order_release);
+}
+
+bool Trace::dump(const char *filename) {
+  FILE *file;
+
+  if((file=fopen(filename,"w"))==NULL) {
+    printf("Unable to write %s\n",filename);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+  const unsigned int g   = generation.load(std::memory_order_acquire);
+  unsigned int nbEvents  = 0;
+  unsigned int nbDropped = 0;
+
+  fprintf(file,"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for(unsigned int i=0;i<registry.size();++i) {
+    // buffers not cleared since the last enable() hold older events (the
+    // generation is read first: the count read after it is not older)
+    const TraceBuffer *buffer = registry[i];
+    if(buffer->generation.load(std::memory_order_acquire)!=g)
+      continue;
+    const unsigned int n = buffer->count.load(std::memory_order_acquire);
+
+    for(unsigned int j=0;j<n;++j) {
+      const TraceEvent &e = buffer->events[j];
+      fprintf(file,"%s\n{\"name\":",nbEvents==0 ? "" : ",");
+      writeString(file,e.name);
+      fprintf(file,",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%llu}",
+              buffer->tid,(unsigned long long)e.start,(unsigned long long)(e.end-e.start));
+      nbEvents++;
+    }
+    nbDropped += buffer->dropped.load(std::memory_order_relaxed);
+  }
+  fprintf(file,"\n]}\n");
+  fclose(file);
+
+  printf("Trace: %u events written to %s",nbEvents,filename);
+  if(nbDropped>0)
+    printf(" (%u dropped, buffers full)",nbDropped);
+  printf("\n");
+
+  return true;
+}
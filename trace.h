@@ -0,0 +1,77 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Scoped-event tracing, dumped as Chrome trace-event JSON
+// (load the file in chrome://tracing or ui.perfetto.dev).
+//
+// Each thread records into its own fixed-size buffer, so recording never
+// takes a lock. When tracing is disabled a scope costs one relaxed load.
+//
+//   void Foo::bar() {
+//     TRACE_SCOPE("Foo::bar");
+//     ...
+//   }
+//
+// A scope can also be ended before the end of its block (phases of a
+// long function, one after the other):
+//
+//   TraceScope phase("Foo::parse");
+//   ...
+//   phase.end();
+
+class Trace {
+ public:
+  // start/stop recording (enable clears the previously recorded events)
+  static void enable();
+  static void disable();
+  inline static bool enabled() {return _enabled.load(std::memory_order_relaxed);}
+
+  // write all the recorded events in the given file
+  static bool dump(const char *filename);
+
+  // file given by the SIM_TRACE environment variable (trace.json otherwise)
+  static const char *outputFilename();
+
+  // current time in microseconds
+  static uint64_t now();
+
+  // add an event to the buffer of the calling thread
+  static void record(const char *name,uint64_t start,uint64_t end);
+
+ private:
+  static std::atomic<bool> _enabled;
+};
+
+class TraceScope {
+ public:
+  inline TraceScope(const char *name)
+    : _name(Trace::enabled() ? name : 0),
+      _start(_name ? Trace::now() : 0) {}
+
+  inline ~TraceScope() {end();}
+
+  // records the event now, once
+  inline void end() {
+    if(_name)
+      Trace::record(_name,_start,Trace::now());
+    _name = 0;
+  }
+
+ private:
+  TraceScope(const TraceScope &);
+  TraceScope &operator=(const TraceScope &);
+
+  const char *_name;
+  uint64_t    _start;
+};
+
+#define TRACE_CONCAT_(a,b) a##b
+#define TRACE_CONCAT(a,b)  TRACE_CONCAT_(a,b)
+
+// name must be a string literal (only the pointer is stored)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(_traceScope,__LINE__)(name)
+
+#endif // TRACE_H
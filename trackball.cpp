@@ -14,11 +14,3 @@ TrackBall::TrackBall(float radius, const Vec2f &center)
   _radius(radius) {
   
 }
-
-TrackBall::TrackBall(const TrackBall &t)
-: _startPos(t._startPos),
-  _startSphPos(t._startSphPos),
-  _center(t._center),
-  _radius(t._radius) {
-
-}
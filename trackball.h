@@ -9,9 +9,6 @@ class TrackBall {
  public:
   TrackBall();
   TrackBall(float radius, const Vec2f &center);
-  TrackBall(const TrackBall &t);
-  
-  inline TrackBall& operator = (const TrackBall &t);
   
   inline void beginTracking(const Vec2f &pt);
   inline Quatf track(const Vec2f &pt);
@@ -25,15 +22,6 @@ class TrackBall {
   float _radius;
 };
 
-inline TrackBall& TrackBall::operator = (const TrackBall &t) {
-  _startPos    = t._startPos;
-  _startSphPos = t._startSphPos;
-  _center      = t._center;
-  _radius      = t._radius;
-  
-  return *this;
-}
-
 inline void TrackBall::beginTracking(const Vec2f &pt) {
   Vec2f p = pt - _center;
   _startPos = p;
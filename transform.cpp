@@ -0,0 +1,235 @@
+#include "transform.h"
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TRANSFORM_AVX2 1
+#define AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+  std::atomic<bool> simdEnabled(true);
+
+  // ((e0*x + e4*y) + e8*z) + e12, as Mat4f::operator*(Vec4f) with w=1
+  inline void transform1(const float *e,float x,float y,float z,float *o) {
+    o[0] = e[0]*x + e[4]*y + e[8]*z  + e[12];
+    o[1] = e[1]*x + e[5]*y + e[9]*z  + e[13];
+    o[2] = e[2]*x + e[6]*y + e[10]*z + e[14];
+    o[3] = e[3]*x + e[7]*y + e[11]*z + e[15];
+  }
+
+  inline bool inside1(const float *c) {
+    return -c[3]<=c[0] && c[0]<=c[3] &&
+           -c[3]<=c[1] && c[1]<=c[3] &&
+           -c[3]<=c[2] && c[2]<=c[3];
+  }
+
+  // scalar code, from the point first (multiple of 8)
+  size_t maskScalar(const float *e,const float *x,const float *y,const float *z,size_t stride,
+                    uint8_t *mask,size_t first,size_t n) {
+    size_t visible = 0;
+    float c[4];
+
+    for(size_t i=first;i<n;++i) {
+      if(i%8==0)
+        mask[i/8] = 0;
+
+      transform1(e,x[i*stride],y[i*stride],z[i*stride],c);
+      if(inside1(c)) {
+        mask[i/8] |= 1<<(i%8);
+        visible++;
+      }
+    }
+
+    return visible;
+  }
+
+#ifdef TRANSFORM_AVX2
+
+  struct Columns {
+    __m256 e[16];
+  };
+
+  AVX2 inline void loadColumns(const float *e,Columns &m) {
+    for(int i=0;i<16;++i)
+      m.e[i] = _mm256_set1_ps(e[i]);
+  }
+
+  AVX2 inline __m256 row(const Columns &m,int r,__m256 x,__m256 y,__m256 z) {
+    __m256 o = _mm256_mul_ps(m.e[r],x);
+    o = _mm256_add_ps(o,_mm256_mul_ps(m.e[r+4],y));
+    o = _mm256_add_ps(o,_mm256_mul_ps(m.e[r+8],z));
+    return _mm256_add_ps(o,m.e[r+12]);
+  }
+
+  // 8 points of 3 floats
+  AVX2 inline void loadAoS(const float *xyz,__m256 &x,__m256 &y,__m256 &z) {
+    const __m256i idx = _mm256_setr_epi32(0,3,6,9,12,15,18,21);
+    x = _mm256_i32gather_ps(xyz,  idx,4);
+    y = _mm256_i32gather_ps(xyz+1,idx,4);
+    z = _mm256_i32gather_ps(xyz+2,idx,4);
+  }
+
+  // 8 points of 4 floats
+  AVX2 inline void storeAoS(float *out,__m256 x,__m256 y,__m256 z,__m256 w) {
+    const __m256 t0 = _mm256_unpacklo_ps(x,y); // x0 y0 x1 y1 | x4 y4 x5 y5
+    const __m256 t1 = _mm256_unpackhi_ps(x,y); // x2 y2 x3 y3 | x6 y6 x7 y7
+    const __m256 t2 = _mm256_unpacklo_ps(z,w);
+    const __m256 t3 = _mm256_unpackhi_ps(z,w);
+    const __m256 p04 = _mm256_shuffle_ps(t0,t2,_MM_SHUFFLE(1,0,1,0));
+    const __m256 p15 = _mm256_shuffle_ps(t0,t2,_MM_SHUFFLE(3,2,3,2));
+    const __m256 p26 = _mm256_shuffle_ps(t1,t3,_MM_SHUFFLE(1,0,1,0));
+    const __m256 p37 = _mm256_shuffle_ps(t1,t3,_MM_SHUFFLE(3,2,3,2));
+
+    _mm256_storeu_ps(out,   _mm256_permute2f128_ps(p04,p15,0x20));
+    _mm256_storeu_ps(out+8, _mm256_permute2f128_ps(p26,p37,0x20));
+    _mm256_storeu_ps(out+16,_mm256_permute2f128_ps(p04,p15,0x31));
+    _mm256_storeu_ps(out+24,_mm256_permute2f128_ps(p26,p37,0x31));
+  }
+
+  // -w<=x,y,z<=w for 8 points, one bit per point
+  AVX2 inline int inside8(const Columns &m,__m256 x,__m256 y,__m256 z) {
+    const __m256 cx = row(m,0,x,y,z);
+    const __m256 cy = row(m,1,x,y,z);
+    const __m256 cz = row(m,2,x,y,z);
+    const __m256 w  = row(m,3,x,y,z);
+    const __m256 nw = _mm256_xor_ps(w,_mm256_set1_ps(-0.0f));
+
+    __m256 in = _mm256_and_ps(_mm256_cmp_ps(nw,cx,_CMP_LE_OQ),_mm256_cmp_ps(cx,w,_CMP_LE_OQ));
+    in = _mm256_and_ps(in,_mm256_and_ps(_mm256_cmp_ps(nw,cy,_CMP_LE_OQ),_mm256_cmp_ps(cy,w,_CMP_LE_OQ)));
+    in = _mm256_and_ps(in,_mm256_and_ps(_mm256_cmp_ps(nw,cz,_CMP_LE_OQ),_mm256_cmp_ps(cz,w,_CMP_LE_OQ)));
+    return _mm256_movemask_ps(in);
+  }
+
+  AVX2 size_t pointsAoSAvx2(const float *e,const float *xyz,float *out,size_t n) {
+    Columns m;
+    loadColumns(e,m);
+
+    size_t i = 0;
+    for(;i+8<=n;i+=8) {
+      __m256 x,y,z;
+      loadAoS(xyz+3*i,x,y,z);
+      storeAoS(out+4*i,row(m,0,x,y,z),row(m,1,x,y,z),row(m,2,x,y,z),row(m,3,x,y,z));
+    }
+    return i;
+  }
+
+  AVX2 size_t pointsSoAAvx2(const float *e,const float *x,const float *y,const float *z,
+                            float *ox,float *oy,float *oz,float *ow,size_t n) {
+    Columns m;
+    loadColumns(e,m);
+
+    size_t i = 0;
+    for(;i+8<=n;i+=8) {
+      const __m256 px = _mm256_loadu_ps(x+i);
+      const __m256 py = _mm256_loadu_ps(y+i);
+      const __m256 pz = _mm256_loadu_ps(z+i);
+      _mm256_storeu_ps(ox+i,row(m,0,px,py,pz));
+      _mm256_storeu_ps(oy+i,row(m,1,px,py,pz));
+      _mm256_storeu_ps(oz+i,row(m,2,px,py,pz));
+      _mm256_storeu_ps(ow+i,row(m,3,px,py,pz));
+    }
+    return i;
+  }
+
+  AVX2 size_t maskAoSAvx2(const float *e,const float *xyz,uint8_t *mask,size_t n,size_t &visible) {
+    Columns m;
+    loadColumns(e,m);
+
+    size_t i = 0;
+    for(;i+8<=n;i+=8) {
+      __m256 x,y,z;
+      loadAoS(xyz+3*i,x,y,z);
+      const int bits = inside8(m,x,y,z);
+      mask[i/8] = (uint8_t)bits;
+      visible += __builtin_popcount(bits);
+    }
+    return i;
+  }
+
+  AVX2 size_t maskSoAAvx2(const float *e,const float *x,const float *y,const float *z,
+                          uint8_t *mask,size_t n,size_t &visible) {
+    Columns m;
+    loadColumns(e,m);
+
+    size_t i = 0;
+    for(;i+8<=n;i+=8) {
+      const int bits = inside8(m,_mm256_loadu_ps(x+i),_mm256_loadu_ps(y+i),_mm256_loadu_ps(z+i));
+      mask[i/8] = (uint8_t)bits;
+      visible += __builtin_popcount(bits);
+    }
+    return i;
+  }
+
+#endif
+
+}
+
+bool Transform::simd() {
+#ifdef TRANSFORM_AVX2
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2 && simdEnabled.load(std::memory_order_relaxed);
+#else
+  return false;
+#endif
+}
+
+void Transform::setSimd(bool enabled) {
+  simdEnabled.store(enabled);
+}
+
+void Transform::points(const Mat4f &m,const float *xyz,float *out,size_t n) {
+  size_t i = 0;
+
+#ifdef TRANSFORM_AVX2
+  if(simd())
+    i = pointsAoSAvx2(m.ptr(),xyz,out,n);
+#endif
+
+  for(;i<n;++i)
+    transform1(m.ptr(),xyz[3*i],xyz[3*i+1],xyz[3*i+2],out+4*i);
+}
+
+void Transform::points(const Mat4f &m,const float *x,const float *y,const float *z,
+		       float *ox,float *oy,float *oz,float *ow,size_t n) {
+  size_t i = 0;
+
+#ifdef TRANSFORM_AVX2
+  if(simd())
+    i = pointsSoAAvx2(m.ptr(),x,y,z,ox,oy,oz,ow,n);
+#endif
+
+  float o[4];
+  for(;i<n;++i) {
+    transform1(m.ptr(),x[i],y[i],z[i],o);
+    ox[i] = o[0];
+    oy[i] = o[1];
+    oz[i] = o[2];
+    ow[i] = o[3];
+  }
+}
+
+size_t Transform::frustumMask(const Mat4f &mvp,const float *xyz,uint8_t *mask,size_t n) {
+  size_t i = 0,visible = 0;
+
+#ifdef TRANSFORM_AVX2
+  if(simd())
+    i = maskAoSAvx2(mvp.ptr(),xyz,mask,n,visible);
+#endif
+
+  return visible+maskScalar(mvp.ptr(),xyz,xyz+1,xyz+2,3,mask,i,n);
+}
+
+size_t Transform::frustumMask(const Mat4f &mvp,const float *x,const float *y,const float *z,
+			      uint8_t *mask,size_t n) {
+  size_t i = 0,visible = 0;
+
+#ifdef TRANSFORM_AVX2
+  if(simd())
+    i = maskSoAAvx2(mvp.ptr(),x,y,z,mask,n,visible);
+#endif
+
+  return visible+maskScalar(mvp.ptr(),x,y,z,1,mask,i,n);
+}
@@ -0,0 +1,41 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mat4.h"
+
+// Batched point transforms and frustum tests on the CPU (bounding boxes,
+// picking, particles...): m*(x,y,z,1) for n points at once.
+//
+// AVX2 (8 points per iteration) when the CPU has it, checked at runtime,
+// scalar code otherwise. The products are done in the same order as
+// Mat4f::operator*(Vec4f), so both versions give the same results.
+//
+// Positions are either AoS (x0 y0 z0 x1 y1 z1 ...) or SoA (one array per
+// coordinate). Transformed points are xyzw AoS or one array per coordinate.
+
+class Transform {
+ public:
+  // xyz: 3*n floats, out: 4*n floats
+  static void points(const Mat4f &m,const float *xyz,float *out,size_t n);
+
+  // x,y,z: n floats each, ox,oy,oz,ow: n floats each
+  static void points(const Mat4f &m,const float *x,const float *y,const float *z,
+		     float *ox,float *oy,float *oz,float *ow,size_t n);
+
+  // projection to clip space and frustum test in one pass: bit i%8 of
+  // mask[i/8] is set if -w<=x,y,z<=w for the point i (mask: (n+7)/8 bytes).
+  // return the number of visible points
+  static size_t frustumMask(const Mat4f &mvp,const float *xyz,uint8_t *mask,size_t n);
+  static size_t frustumMask(const Mat4f &mvp,const float *x,const float *y,const float *z,
+			    uint8_t *mask,size_t n);
+
+  // true if the AVX2 kernels are used
+  static bool simd();
+
+  // false: the scalar code even with AVX2 (bench --check compares both)
+  static void setSimd(bool enabled);
+};
+
+#endif // TRANSFORM_H
@@ -2,6 +2,7 @@
 #define VEC2_H
 
 #include <math.h>
+#include <type_traits>
 
 /*==============================================================================
   CLASS Vec2
@@ -17,7 +18,7 @@ class Vec2
 
   /*----- methods -----*/
 
-  inline static Vec2 zero();
+  inline static constexpr Vec2 zero();
    
   /*----- methods -----*/
 
@@ -27,61 +28,57 @@ class Vec2
       _e[1] = (T)vec(1);
     }
 
-  Vec2() { _e[0]=_e[1]=0; }
-  Vec2( const Vec2<T>& vec );
-  Vec2( const T& e0, const T& e1 );
+  constexpr Vec2() noexcept : _e{} {}
+  constexpr Vec2( const T& e0, const T& e1 ) noexcept;
 
-  ~Vec2() {}
+  constexpr T* ptr();
+  constexpr const T* ptr() const;
 
-  T* ptr();
-  const T* ptr() const;
-
-  T* getArray();
-  const T* getArray() const;
+  constexpr T* getArray();
+  constexpr const T* getArray() const;
 
   T length() const;
-  T sqrLength() const;
-  T dot( const Vec2<T>& vec ) const;
+  constexpr T sqrLength() const;
+  constexpr T dot( const Vec2<T>& vec ) const;
 
   Vec2  normal() const;
   Vec2& normalEq();
   Vec2& normalEq( const T len );
-  Vec2& negateEq();
-  Vec2& clampToMaxEq( const T& max );
+  constexpr Vec2& negateEq();
+  constexpr Vec2& clampToMaxEq( const T& max );
       
-  Vec2 operator+( const Vec2<T>& rhs ) const;
-  Vec2 operator-( const Vec2<T>& rhs ) const;
-  Vec2 operator-() const;
-  Vec2 operator*( const T& rhs ) const;
-  Vec2 operator*( const Vec2<T>& rhs ) const;
-  Vec2 operator/( const T& rhs ) const;
-  Vec2 operator/( const Vec2<T>& rhs ) const;
-
-  Vec2& operator+=( const Vec2<T>& rhs );
-  Vec2& operator-=( const Vec2<T>& rhs );
-  Vec2& operator*=( const T& rhs );
-  Vec2& operator*=( const Vec2<T>& rhs );
-  Vec2& operator/=( const T& rhs );
-  Vec2& operator/=( const Vec2<T>& rhs );
-  Vec2& operator=( const Vec2<T>& rsh );
-
-  bool operator==( const Vec2<T>& rhs ) const;
-  bool operator!=( const Vec2<T>& rhs ) const;
-
-  T& operator()( int idx );
-  const T& operator()( int idx ) const;
-
-  T& operator[]( int idx );
-  const T& operator[]( int idx ) const;
-
-  void set( T const x, T const y );
+  constexpr Vec2 operator+( const Vec2<T>& rhs ) const;
+  constexpr Vec2 operator-( const Vec2<T>& rhs ) const;
+  constexpr Vec2 operator-() const;
+  constexpr Vec2 operator*( const T& rhs ) const;
+  constexpr Vec2 operator*( const Vec2<T>& rhs ) const;
+  constexpr Vec2 operator/( const T& rhs ) const;
+  constexpr Vec2 operator/( const Vec2<T>& rhs ) const;
+
+  constexpr Vec2& operator+=( const Vec2<T>& rhs );
+  constexpr Vec2& operator-=( const Vec2<T>& rhs );
+  constexpr Vec2& operator*=( const T& rhs );
+  constexpr Vec2& operator*=( const Vec2<T>& rhs );
+  constexpr Vec2& operator/=( const T& rhs );
+  constexpr Vec2& operator/=( const Vec2<T>& rhs );
+
+  constexpr bool operator==( const Vec2<T>& rhs ) const;
+  constexpr bool operator!=( const Vec2<T>& rhs ) const;
+
+  constexpr T& operator()( int idx );
+  constexpr const T& operator()( int idx ) const;
+
+  constexpr T& operator[]( int idx );
+  constexpr const T& operator[]( int idx ) const;
+
+  constexpr void set( T const x, T const y );
            
            
-  T& x();
-  T& y();
+  constexpr T& x();
+  constexpr T& y();
 
-  const T& x() const;
-  const T& y() const;
+  constexpr const T& x() const;
+  constexpr const T& y() const;
    
  private:
 
@@ -93,7 +90,7 @@ class Vec2
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T> Vec2<T>::zero() 
+inline constexpr Vec2<T> Vec2<T>::zero() 
 {
   return Vec2( 0, 0 );
 }
@@ -101,25 +98,15 @@ inline Vec2<T> Vec2<T>::zero()
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T>::Vec2( const Vec2<T>& vec )
-{
-  _e[0] = vec._e[0];
-  _e[1] = vec._e[1];
-}
-
-//------------------------------------------------------------------------------
-//!
-template< class T >
-inline Vec2<T>::Vec2( const T& e0, const T& e1 )
+inline constexpr Vec2<T>::Vec2( const T& e0, const T& e1 ) noexcept
+  : _e{ e0, e1 }
 {
-  _e[0] = e0;
-  _e[1] = e1;
 }
 
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline T* Vec2<T>::ptr()
+inline constexpr T* Vec2<T>::ptr()
 {
   return _e;
 }
@@ -127,7 +114,7 @@ inline T* Vec2<T>::ptr()
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T* Vec2<T>::ptr() const
+inline constexpr const T* Vec2<T>::ptr() const
 {
   return _e;
 }
@@ -135,7 +122,7 @@ inline const T* Vec2<T>::ptr() const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline T* Vec2<T>::getArray()
+inline constexpr T* Vec2<T>::getArray()
 {
   return _e;
 }
@@ -143,7 +130,7 @@ inline T* Vec2<T>::getArray()
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T* Vec2<T>::getArray() const
+inline constexpr const T* Vec2<T>::getArray() const
 {
   return _e;
 }
@@ -159,7 +146,7 @@ inline T Vec2<T>::length() const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline T Vec2<T>::sqrLength() const
+inline constexpr T Vec2<T>::sqrLength() const
 {
   return _e[0]*_e[0] + _e[1]*_e[1];
 }
@@ -167,7 +154,7 @@ inline T Vec2<T>::sqrLength() const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline T Vec2<T>::dot( const Vec2<T>& vec ) const
+inline constexpr T Vec2<T>::dot( const Vec2<T>& vec ) const
 {
   return _e[0]*vec._e[0] + _e[1]*vec._e[1];
 }
@@ -206,7 +193,7 @@ inline Vec2<T>& Vec2<T>::normalEq( const T len )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T>& Vec2<T>::negateEq()
+inline constexpr Vec2<T>& Vec2<T>::negateEq()
 {
   _e[0] = -_e[0];
   _e[1] = -_e[1];
@@ -216,7 +203,7 @@ inline Vec2<T>& Vec2<T>::negateEq()
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T>& Vec2<T>::clampToMaxEq( const T& max )
+inline constexpr Vec2<T>& Vec2<T>::clampToMaxEq( const T& max )
 {
   if( _e[0] > max )
     {
@@ -232,7 +219,7 @@ inline Vec2<T>& Vec2<T>::clampToMaxEq( const T& max )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T> Vec2<T>::operator+( const Vec2<T>& rhs ) const
+inline constexpr Vec2<T> Vec2<T>::operator+( const Vec2<T>& rhs ) const
 {
   return Vec2<T>(
 		 _e[0] + rhs._e[0],
@@ -243,7 +230,7 @@ inline Vec2<T> Vec2<T>::operator+( const Vec2<T>& rhs ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T> Vec2<T>::operator-( const Vec2<T>& rhs ) const
+inline constexpr Vec2<T> Vec2<T>::operator-( const Vec2<T>& rhs ) const
 {
   return Vec2<T>(
 		 _e[0] - rhs._e[0],
@@ -254,7 +241,7 @@ inline Vec2<T> Vec2<T>::operator-( const Vec2<T>& rhs ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T> Vec2<T>::operator-() const
+inline constexpr Vec2<T> Vec2<T>::operator-() const
 {
   return Vec2<T>( -_e[0], -_e[1] );
 }
@@ -262,7 +249,7 @@ inline Vec2<T> Vec2<T>::operator-() const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T> Vec2<T>::operator*( const T& rhs ) const
+inline constexpr Vec2<T> Vec2<T>::operator*( const T& rhs ) const
 {
   return Vec2<T>( _e[0] * rhs, _e[1] * rhs );
 }
@@ -270,7 +257,7 @@ inline Vec2<T> Vec2<T>::operator*( const T& rhs ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T> Vec2<T>::operator*( const Vec2<T>& rhs ) const
+inline constexpr Vec2<T> Vec2<T>::operator*( const Vec2<T>& rhs ) const
 {
   return Vec2<T>( _e[0] * rhs._e[0], _e[1] * rhs._e[1] );
 }
@@ -278,7 +265,7 @@ inline Vec2<T> Vec2<T>::operator*( const Vec2<T>& rhs ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T> Vec2<T>::operator/( const T& rhs ) const
+inline constexpr Vec2<T> Vec2<T>::operator/( const T& rhs ) const
 {
   return Vec2<T>( _e[0] / rhs, _e[1] / rhs );
 }
@@ -286,7 +273,7 @@ inline Vec2<T> Vec2<T>::operator/( const T& rhs ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T> Vec2<T>::operator/( const Vec2<T>& rhs ) const
+inline constexpr Vec2<T> Vec2<T>::operator/( const Vec2<T>& rhs ) const
 {
   return Vec2<T>( _e[0] / rhs._e[0], _e[1] / rhs._e[1] );
 }
@@ -294,7 +281,7 @@ inline Vec2<T> Vec2<T>::operator/( const Vec2<T>& rhs ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T>& Vec2<T>::operator+=( const Vec2<T>& rhs )
+inline constexpr Vec2<T>& Vec2<T>::operator+=( const Vec2<T>& rhs )
 {
   _e[0] += rhs._e[0];
   _e[1] += rhs._e[1];
@@ -304,7 +291,7 @@ inline Vec2<T>& Vec2<T>::operator+=( const Vec2<T>& rhs )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T>& Vec2<T>::operator-=( const Vec2<T>& rhs )
+inline constexpr Vec2<T>& Vec2<T>::operator-=( const Vec2<T>& rhs )
 {
   _e[0] -= rhs._e[0];
   _e[1] -= rhs._e[1];
@@ -314,7 +301,7 @@ inline Vec2<T>& Vec2<T>::operator-=( const Vec2<T>& rhs )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T>& Vec2<T>::operator*=( const T& rhs )
+inline constexpr Vec2<T>& Vec2<T>::operator*=( const T& rhs )
 {
   _e[0] *= rhs;
   _e[1] *= rhs;
@@ -324,7 +311,7 @@ inline Vec2<T>& Vec2<T>::operator*=( const T& rhs )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T>& Vec2<T>::operator*=( const Vec2<T>& rhs )
+inline constexpr Vec2<T>& Vec2<T>::operator*=( const Vec2<T>& rhs )
 {
   _e[0] *= rhs._e[0];
   _e[1] *= rhs._e[1];
@@ -334,7 +321,7 @@ inline Vec2<T>& Vec2<T>::operator*=( const Vec2<T>& rhs )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T>& Vec2<T>::operator/=( const T& rhs )
+inline constexpr Vec2<T>& Vec2<T>::operator/=( const T& rhs )
 {
   _e[0] /= rhs;
   _e[1] /= rhs;
@@ -344,27 +331,17 @@ inline Vec2<T>& Vec2<T>::operator/=( const T& rhs )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline Vec2<T>& Vec2<T>::operator/=( const Vec2<T>& rhs )
+inline constexpr Vec2<T>& Vec2<T>::operator/=( const Vec2<T>& rhs )
 {
   _e[0] /= rhs._e[0];
   _e[1] /= rhs._e[1];
   return *this;
 }
 
-//------------------------------------------------------------------------------
-//!
-template< class T >
-inline Vec2<T>& Vec2<T>::operator=( const Vec2<T>& rhs )
-{
-  _e[0] = rhs._e[0];
-  _e[1] = rhs._e[1];
-  return *this;
-}
-
 //------------------------------------------------------------------------------
 //!
   template< class T >
-  inline bool Vec2<T>::operator==( const Vec2<T>& rhs ) const
+  inline constexpr bool Vec2<T>::operator==( const Vec2<T>& rhs ) const
   {
     return _e[0] == rhs._e[0] && _e[1] == rhs._e[1]; 
   }
@@ -372,7 +349,7 @@ inline Vec2<T>& Vec2<T>::operator=( const Vec2<T>& rhs )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline bool Vec2<T>::operator!=( const Vec2<T>& rhs ) const
+inline constexpr bool Vec2<T>::operator!=( const Vec2<T>& rhs ) const
 {
   return _e[0] != rhs._e[0] || _e[1] != rhs._e[1];
 }
@@ -380,7 +357,7 @@ inline bool Vec2<T>::operator!=( const Vec2<T>& rhs ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline T& Vec2<T>::operator()( int idx )
+inline constexpr T& Vec2<T>::operator()( int idx )
 {
   return _e[idx];
 }
@@ -388,7 +365,7 @@ inline T& Vec2<T>::operator()( int idx )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T& Vec2<T>::operator()
+inline constexpr const T& Vec2<T>::operator()
 ( int idx ) const
 {
   return _e[idx];
@@ -397,7 +374,7 @@ inline const T& Vec2<T>::operator()
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline T& Vec2<T>::operator[]( int idx )
+inline constexpr T& Vec2<T>::operator[]( int idx )
 {
   return _e[idx];
 }
@@ -405,7 +382,7 @@ inline T& Vec2<T>::operator[]( int idx )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T& Vec2<T>::operator[]( int idx ) const
+inline constexpr const T& Vec2<T>::operator[]( int idx ) const
 {
   return _e[idx];
 }
@@ -413,7 +390,7 @@ inline const T& Vec2<T>::operator[]( int idx ) const
 //------------------------------------------------------------------------------
 //!
 template< class T >
-void
+constexpr void
 Vec2<T>::set( T const x, T const y )
 {
   _e[0] = x;
@@ -425,28 +402,28 @@ Vec2<T>::set( T const x, T const y )
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline T& Vec2<T>::x() {
+inline constexpr T& Vec2<T>::x() {
   return _e[0];
 }
 
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline T& Vec2<T>::y() {
+inline constexpr T& Vec2<T>::y() {
   return _e[1];
 }
 
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T& Vec2<T>::x() const {
+inline constexpr const T& Vec2<T>::x() const {
   return _e[0];
 }
 
 //------------------------------------------------------------------------------
 //!
 template< class T >
-inline const T& Vec2<T>::y() const {
+inline constexpr const T& Vec2<T>::y() const {
   return _e[1];
 }
 
@@ -467,6 +444,8 @@ typedef Vec2< unsigned int >    Vec2u;
 typedef Vec2< float >           Vec2f;
 typedef Vec2< double >          Vec2d;
 
+static_assert( std::is_trivially_copyable< Vec2f >::value, "Vec2f must stay trivially copyable" );
+
 
 
 #endif
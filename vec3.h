@@ -3,6 +3,7 @@
 
 
 #include <math.h>
+#include <type_traits>
 
         
   /*==============================================================================
@@ -20,12 +21,12 @@
    
       /*----- static methods -----*/
 
-      inline static Vec3 zero();
-      inline static Vec3 xaxis();
-      inline static Vec3 yaxis();
-      inline static Vec3 zaxis();
+      inline static constexpr Vec3 zero();
+      inline static constexpr Vec3 xaxis();
+      inline static constexpr Vec3 yaxis();
+      inline static constexpr Vec3 zaxis();
 
-      inline static Vec3 gravity();
+      inline static constexpr Vec3 gravity();
 
       /*----- methods -----*/
 
@@ -36,87 +37,83 @@
           _e[2] = (T)vec(2);
         }
 
-      Vec3(){ _e[0]=_e[1]=_e[2]=(T)0; }
-      Vec3( const Vec3<T>& vec );
-      Vec3( const Vec3<T>& _v1, const Vec3<T>& _v2 );
-      Vec3( const T e0, const T e1, const T e2 );
-      Vec3( const T vec[] ); 
-
-      ~Vec3(){}
+      constexpr Vec3() noexcept : _e{} {}
+      constexpr Vec3( const Vec3<T>& _v1, const Vec3<T>& _v2 ) noexcept;
+      constexpr Vec3( const T e0, const T e1, const T e2 ) noexcept;
+      Vec3( const T vec[] );
 
       bool hasNan() const;
       bool hasInf() const;
 
-      T* ptr();
-      const T* ptr() const;
+      constexpr T* ptr();
+      constexpr const T* ptr() const;
 
-      T* getArray();
-      const T* getArray() const;
+      constexpr T* getArray();
+      constexpr const T* getArray() const;
 
-      void setValues(const T _v1, const T _v2, const T _v3);
-      void set( const T _v1, const T _v2, const T _v3);
+      constexpr void setValues(const T _v1, const T _v2, const T _v3);
+      constexpr void set( const T _v1, const T _v2, const T _v3);
 
       T length() const;
-      T sqrLength() const;
+      constexpr T sqrLength() const;
       T norm() const; //an alias for length
            
-      T dot( const Vec3<T>& vec ) const;
+      constexpr T dot( const Vec3<T>& vec ) const;
 
-      Vec3  cross( const Vec3<T>& vec ) const;
+      constexpr Vec3  cross( const Vec3<T>& vec ) const;
       Vec3  normal() const;
       Vec3& normalEq();
       Vec3& normalEq( const T length );
-      Vec3& negateEq();
-      Vec3& clampToMaxEq( const T& max );
+      constexpr Vec3& negateEq();
+      constexpr Vec3& clampToMaxEq( const T& max );
       Vec3  generateOrthogonal() const;
 
-      Vec3 operator^( const Vec3<T>& _v ) const;
+      constexpr Vec3 operator^( const Vec3<T>& _v ) const;
    
-      Vec3 operator+( const Vec3<T>& rhs ) const;
-      Vec3 operator+( const T& _v ) const;
-      Vec3 operator-( const Vec3<T>& rhs ) const;
-      Vec3 operator-( const T& _v ) const;
-      Vec3 operator-() const;
-      Vec3 operator*( const T& rhs ) const;
-      Vec3 operator*( const Vec3<T>& rhs ) const;
-      Vec3 operator/( const T& rhs ) const;
-      Vec3 operator/( const Vec3<T>& rhs ) const;
-
-      Vec3& operator+=( const Vec3<T>& rhs );
-      Vec3& operator+=( const T& _v );
-      Vec3& operator-=( const Vec3<T>& rhs );
-      Vec3& operator-=( const T& _v );
-      Vec3& operator*=( const T& rhs );
-      Vec3& operator*=( const Vec3<T>& rhs );
-      Vec3& operator/=( const T& rhs );
-      Vec3& operator/=( const Vec3<T>& rhs );
-      Vec3& operator=( const Vec3<T>& rsh );
-
-      bool operator==( const Vec3<T>& rhs ) const;
-      bool operator!=( const Vec3<T>& rhs ) const;
-
-      bool operator> ( const Vec3<T>& _v ) const;
-      bool operator>= ( const Vec3<T>& _v ) const;
-      bool operator< ( const Vec3<T>& _v ) const;
-      bool operator<= ( const Vec3<T>& _v ) const;
+      constexpr Vec3 operator+( const Vec3<T>& rhs ) const;
+      constexpr Vec3 operator+( const T& _v ) const;
+      constexpr Vec3 operator-( const Vec3<T>& rhs ) const;
+      constexpr Vec3 operator-( const T& _v ) const;
+      constexpr Vec3 operator-() const;
+      constexpr Vec3 operator*( const T& rhs ) const;
+      constexpr Vec3 operator*( const Vec3<T>& rhs ) const;
+      constexpr Vec3 operator/( const T& rhs ) const;
+      constexpr Vec3 operator/( const Vec3<T>& rhs ) const;
+
+      constexpr Vec3& operator+=( const Vec3<T>& rhs );
+      constexpr Vec3& operator+=( const T& _v );
+      constexpr Vec3& operator-=( const Vec3<T>& rhs );
+      constexpr Vec3& operator-=( const T& _v );
+      constexpr Vec3& operator*=( const T& rhs );
+      constexpr Vec3& operator*=( const Vec3<T>& rhs );
+      constexpr Vec3& operator/=( const T& rhs );
+      constexpr Vec3& operator/=( const Vec3<T>& rhs );
+
+      constexpr bool operator==( const Vec3<T>& rhs ) const;
+      constexpr bool operator!=( const Vec3<T>& rhs ) const;
+
+      constexpr bool operator> ( const Vec3<T>& _v ) const;
+      constexpr bool operator>= ( const Vec3<T>& _v ) const;
+      constexpr bool operator< ( const Vec3<T>& _v ) const;
+      constexpr bool operator<= ( const Vec3<T>& _v ) const;
    
-      T& operator()( int idx );
-      const T& operator()( int idx ) const;
+      constexpr T& operator()( int idx );
+      constexpr const T& operator()( int idx ) const;
 
-      T& operator[]( int idx );
-      const T& operator[]( int idx ) const;
+      constexpr T& operator[]( int idx );
+      constexpr const T& operator[]( int idx ) const;
 
-      void setX(const T&);
-      void setY(const T&);
-      void setZ(const T&);
+      constexpr void setX(const T&);
+      constexpr void setY(const T&);
+      constexpr void setZ(const T&);
    
-      T x();
-      T y();
-      T z();
+      constexpr T x();
+      constexpr T y();
+      constexpr T z();
  
-      const T& x() const;
-      const T& y() const;
-      const T& z() const;
+      constexpr const T& x() const;
+      constexpr const T& y() const;
+      constexpr const T& z() const;
 
     private: 
 
@@ -128,7 +125,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::zero() 
+    inline constexpr Vec3<T> Vec3<T>::zero() 
     {
       return Vec3( 0, 0, 0 );
     }
@@ -136,7 +133,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::xaxis() 
+    inline constexpr Vec3<T> Vec3<T>::xaxis() 
     {
       return Vec3( 1, 0, 0 );
     }
@@ -144,7 +141,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::yaxis() 
+    inline constexpr Vec3<T> Vec3<T>::yaxis() 
     {
       return Vec3( 0, 1, 0 );
     }
@@ -152,7 +149,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::zaxis() 
+    inline constexpr Vec3<T> Vec3<T>::zaxis() 
     {
       return Vec3( 0, 0, 1 );
     }
@@ -160,20 +157,10 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::gravity() 
+    inline constexpr Vec3<T> Vec3<T>::gravity() 
     {
       return Vec3( 0, 0, -9.8 );
     }
-
-  //------------------------------------------------------------------------------
-  //!
-  template< class T >
-    inline Vec3<T>::Vec3( const Vec3<T>& vec )
-    {
-      _e[0] = vec._e[0];
-      _e[1] = vec._e[1];
-      _e[2] = vec._e[2];
-    }
  
   //------------------------------------------------------------------------------
   //!
@@ -195,21 +182,18 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>::Vec3( const Vec3<T>& _v1, const Vec3<T>& _v2 ) {
-    _e[0] = _v2._e[0] - _v1._e[0];
-    _e[1] = _v2._e[1] - _v1._e[1];
-    _e[2] = _v2._e[2] - _v1._e[2];
+    inline constexpr Vec3<T>::Vec3( const Vec3<T>& _v1, const Vec3<T>& _v2 ) noexcept
+    : _e{ _v2._e[0] - _v1._e[0], _v2._e[1] - _v1._e[1], _v2._e[2] - _v1._e[2] }
+  {
   }
 
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>::Vec3( const T e0, const T e1, const T e2 )
+    inline constexpr Vec3<T>::Vec3( const T e0, const T e1, const T e2 ) noexcept
+    : _e{ e0, e1, e2 }
     {
-      _e[0] = e0;
-      _e[1] = e1;
-      _e[2] = e2;
     }
 
   //------------------------------------------------------------------------------
@@ -227,7 +211,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T* Vec3<T>::ptr()
+    inline constexpr T* Vec3<T>::ptr()
     {
       return _e;
     }
@@ -235,7 +219,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline const T* Vec3<T>::ptr() const
+    inline constexpr const T* Vec3<T>::ptr() const
     {
       return _e;
     }
@@ -243,7 +227,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T* Vec3<T>::getArray()
+    inline constexpr T* Vec3<T>::getArray()
     {
       return _e;
     }
@@ -251,7 +235,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline const T* Vec3<T>::getArray() const
+    inline constexpr const T* Vec3<T>::getArray() const
     {
       return _e;
     }
@@ -259,12 +243,12 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline void Vec3<T>::setValues(const T _v1, const T _v2, const T _v3) {
+    inline constexpr void Vec3<T>::setValues(const T _v1, const T _v2, const T _v3) {
     _e[0] = _v1; _e[1] = _v2; _e[2] = _v3;
   }
 
   template< class T >
-    inline void Vec3<T>::set( const T _v1, const T _v2, const T _v3)
+    inline constexpr void Vec3<T>::set( const T _v1, const T _v2, const T _v3)
     {
       setValues( _v1, _v2, _v3);
     }
@@ -281,7 +265,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T Vec3<T>::sqrLength() const
+    inline constexpr T Vec3<T>::sqrLength() const
     {
       return _e[0]*_e[0] + _e[1]*_e[1] + _e[2]*_e[2];
     }
@@ -297,7 +281,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T Vec3<T>::dot
+    inline constexpr T Vec3<T>::dot
     ( const Vec3<T>& vec ) const
     {
       return _e[0]*vec._e[0] + _e[1]*vec._e[1] + _e[2]*vec._e[2];
@@ -306,7 +290,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::cross( const Vec3<T>& vec ) const
+    inline constexpr Vec3<T> Vec3<T>::cross( const Vec3<T>& vec ) const
     {
       return Vec3<T>(
                      _e[1]*vec._e[2] - _e[2]*vec._e[1],
@@ -351,7 +335,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>& Vec3<T>::negateEq()
+    inline constexpr Vec3<T>& Vec3<T>::negateEq()
     {
       _e[0] = -_e[0];
       _e[1] = -_e[1];
@@ -362,7 +346,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>& Vec3<T>::clampToMaxEq( const T& max )
+    inline constexpr Vec3<T>& Vec3<T>::clampToMaxEq( const T& max )
     {
       if( _e[0] > max )
         {
@@ -404,14 +388,14 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::operator^( const Vec3<T>& _v ) const {
+    inline constexpr Vec3<T> Vec3<T>::operator^( const Vec3<T>& _v ) const {
     return this->cross(_v);
   }
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::operator+( const Vec3<T>& rhs ) const
+    inline constexpr Vec3<T> Vec3<T>::operator+( const Vec3<T>& rhs ) const
     {
       return Vec3<T>(
                      _e[0] + rhs._e[0],
@@ -423,7 +407,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::operator+( const T& _v ) const
+    inline constexpr Vec3<T> Vec3<T>::operator+( const T& _v ) const
     {
       return Vec3<T>(
                      _e[0] + _v,
@@ -435,7 +419,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::operator-( const Vec3<T>& rhs ) const
+    inline constexpr Vec3<T> Vec3<T>::operator-( const Vec3<T>& rhs ) const
     {
       return Vec3<T>(
                      _e[0] - rhs._e[0],
@@ -447,7 +431,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::operator-( const T& _v ) const
+    inline constexpr Vec3<T> Vec3<T>::operator-( const T& _v ) const
     {
       return Vec3<T>(
                      _e[0] - _v,
@@ -459,7 +443,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::operator-() const
+    inline constexpr Vec3<T> Vec3<T>::operator-() const
     {
       return Vec3<T>( -_e[0], -_e[1], -_e[2] );
     }
@@ -467,7 +451,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::operator*( const T& rhs ) const
+    inline constexpr Vec3<T> Vec3<T>::operator*( const T& rhs ) const
     {
       return Vec3<T>( _e[0] * rhs, _e[1] * rhs, _e[2] * rhs );
     }
@@ -475,7 +459,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::operator*( const Vec3<T>& rhs ) const
+    inline constexpr Vec3<T> Vec3<T>::operator*( const Vec3<T>& rhs ) const
     {
       return Vec3<T>(
                      _e[0] * rhs._e[0],
@@ -487,7 +471,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::operator/( const T& rhs ) const
+    inline constexpr Vec3<T> Vec3<T>::operator/( const T& rhs ) const
     {
       return Vec3<T>( _e[0] / rhs, _e[1] / rhs, _e[2] / rhs );
     }
@@ -495,7 +479,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T> Vec3<T>::operator/( const Vec3<T>& rhs ) const
+    inline constexpr Vec3<T> Vec3<T>::operator/( const Vec3<T>& rhs ) const
     {
       return Vec3<T>( _e[0] / rhs._e[0], _e[1] / rhs._e[1], _e[2] / rhs._e[2] );
     }
@@ -503,7 +487,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>&Vec3<T>::operator+=( const Vec3<T>& rhs )
+    inline constexpr Vec3<T>&Vec3<T>::operator+=( const Vec3<T>& rhs )
     {
       _e[0] += rhs._e[0];
       _e[1] += rhs._e[1];
@@ -514,7 +498,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>&Vec3<T>::operator+=( const T& _v )
+    inline constexpr Vec3<T>&Vec3<T>::operator+=( const T& _v )
     {
       _e[0] += _v;
       _e[1] += _v;
@@ -525,7 +509,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>& Vec3<T>::operator-=( const Vec3<T>& rhs )
+    inline constexpr Vec3<T>& Vec3<T>::operator-=( const Vec3<T>& rhs )
     {
       _e[0] -= rhs._e[0];
       _e[1] -= rhs._e[1];
@@ -536,7 +520,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>& Vec3<T>::operator-=( const T& _v )
+    inline constexpr Vec3<T>& Vec3<T>::operator-=( const T& _v )
     {
       _e[0] -= _v;
       _e[1] -= _v;
@@ -547,7 +531,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>& Vec3<T>::operator*=( const T& rhs )
+    inline constexpr Vec3<T>& Vec3<T>::operator*=( const T& rhs )
     {
       _e[0] *= rhs;
       _e[1] *= rhs;
@@ -558,7 +542,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>& Vec3<T>::operator*=( const Vec3<T>& rhs )
+    inline constexpr Vec3<T>& Vec3<T>::operator*=( const Vec3<T>& rhs )
     {
       _e[0] *= rhs._e[0];
       _e[1] *= rhs._e[1];
@@ -569,7 +553,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>& Vec3<T>::operator/=( const T& rhs )
+    inline constexpr Vec3<T>& Vec3<T>::operator/=( const T& rhs )
     {
       _e[0] /= rhs;
       _e[1] /= rhs;
@@ -580,7 +564,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec3<T>& Vec3<T>::operator/=( const Vec3<T>& rhs )
+    inline constexpr Vec3<T>& Vec3<T>::operator/=( const Vec3<T>& rhs )
     {
       _e[0] /= rhs._e[0];
       _e[1] /= rhs._e[1];
@@ -588,22 +572,11 @@
       return *this;
     }
 
-  //------------------------------------------------------------------------------
-  //!
-  template< class T >
-    inline Vec3<T>& Vec3<T>::operator=( const Vec3<T>& rhs )
-    {
-      _e[0] = rhs._e[0];
-      _e[1] = rhs._e[1];
-      _e[2] = rhs._e[2];
-      return *this;
-    }
-
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline bool Vec3<T>::operator==( const Vec3<T>& rhs ) const
+    inline constexpr bool Vec3<T>::operator==( const Vec3<T>& rhs ) const
     {
       return
         _e[0] == rhs._e[0] &&
@@ -614,7 +587,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline bool Vec3<T>::operator!=( const Vec3<T>& rhs ) const
+    inline constexpr bool Vec3<T>::operator!=( const Vec3<T>& rhs ) const
     {
       return
         _e[0] != rhs._e[0] ||
@@ -625,7 +598,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline bool Vec3<T>::operator>( const Vec3<T>& _v ) const {
+    inline constexpr bool Vec3<T>::operator>( const Vec3<T>& _v ) const {
     return
       _e[0] > _v._e[0] && 
       _e[1] > _v._e[1] &&
@@ -635,7 +608,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline bool Vec3<T>::operator>=( const Vec3<T>& _v ) const {
+    inline constexpr bool Vec3<T>::operator>=( const Vec3<T>& _v ) const {
     return
       _e[0] >= _v._e[0] && 
       _e[1] >= _v._e[1] &&
@@ -645,7 +618,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline bool Vec3<T>::operator<( const Vec3<T>& _v ) const {
+    inline constexpr bool Vec3<T>::operator<( const Vec3<T>& _v ) const {
     return
       _e[0] < _v._e[0] && 
       _e[1] < _v._e[1] &&
@@ -655,7 +628,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline bool Vec3<T>::operator<=( const Vec3<T>& _v ) const {
+    inline constexpr bool Vec3<T>::operator<=( const Vec3<T>& _v ) const {
     return
       _e[0] <= _v._e[0] && 
       _e[1] <= _v._e[1] &&
@@ -665,7 +638,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T& Vec3<T>::operator()( int idx )
+    inline constexpr T& Vec3<T>::operator()( int idx )
     {
       return _e[idx];
     }
@@ -673,7 +646,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline const T& Vec3<T>::operator()( int idx ) const
+    inline constexpr const T& Vec3<T>::operator()( int idx ) const
     {
       return _e[idx];
     }
@@ -681,7 +654,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T & Vec3<T>::operator[]( int idx )
+    inline constexpr T & Vec3<T>::operator[]( int idx )
     {
       return _e[idx];
     }
@@ -689,7 +662,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline const T& Vec3<T>::operator[]( int idx ) const
+    inline constexpr const T& Vec3<T>::operator[]( int idx ) const
     {
       return _e[idx];
     }
@@ -705,63 +678,63 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline void Vec3<T>::setX(const T& _v) {
+    inline constexpr void Vec3<T>::setX(const T& _v) {
     _e[0] = _v;
   }
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline void Vec3<T>::setY(const T& _v) {
+    inline constexpr void Vec3<T>::setY(const T& _v) {
     _e[1] = _v;
   }
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline void Vec3<T>::setZ(const T& _v) {
+    inline constexpr void Vec3<T>::setZ(const T& _v) {
     _e[2] = _v;
   }
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T Vec3<T>::x() {
+    inline constexpr T Vec3<T>::x() {
     return _e[0];
   }
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T Vec3<T>::y() {
+    inline constexpr T Vec3<T>::y() {
     return _e[1];
   }
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T Vec3<T>::z() {
+    inline constexpr T Vec3<T>::z() {
     return _e[2];
   }
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline const T& Vec3<T>::x() const {
+    inline constexpr const T& Vec3<T>::x() const {
     return _e[0];
   }
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline const T& Vec3<T>::y() const {
+    inline constexpr const T& Vec3<T>::y() const {
     return _e[1];
   }
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline const T& Vec3<T>::z() const {
+    inline constexpr const T& Vec3<T>::z() const {
     return _e[2];
   }
 
@@ -773,5 +746,7 @@
   typedef Vec3< float >  Vec3f;
   typedef Vec3< double > Vec3d;
 
+  static_assert( std::is_trivially_copyable< Vec3f >::value, "Vec3f must stay trivially copyable" );
+
   
 #endif
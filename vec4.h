@@ -2,6 +2,7 @@
 #define VEC4_H
 
 #include <math.h>
+#include <type_traits>
 
         
   /*==============================================================================
@@ -18,7 +19,7 @@
    
       /*----- methods -----*/
 
-      inline static Vec4 zero();
+      inline static constexpr Vec4 zero();
 
       /*----- methods -----*/
 
@@ -30,66 +31,62 @@
           _e[3] = (T)vec(3);
         }
 
-      Vec4() { _e[0]=_e[1]=_e[2]=_e[3]=0; }
-      Vec4( const Vec4<T>& vec );
-      Vec4( const T& e0, const T& e1, const T& e2, const T& e3 );
+      constexpr Vec4() noexcept : _e{} {}
+      constexpr Vec4( const T& e0, const T& e1, const T& e2, const T& e3 ) noexcept;
       Vec4( const T vec[] );
 
-      ~Vec4() {}
+      constexpr T* ptr();
+      constexpr const T* ptr() const;
 
-      T* ptr();
-      const T* ptr() const;
-
-      void set( const T _v1, const T _v2, const T _v3, const T _v4);
+      constexpr void set( const T _v1, const T _v2, const T _v3, const T _v4);
 
             
       T length() const;
-      T sqrLength() const;
-      T dot( const Vec4<T>& vec ) const;
+      constexpr T sqrLength() const;
+      constexpr T dot( const Vec4<T>& vec ) const;
 
-      Vec4  cross( const Vec4<T>& vec ) const;
+      constexpr Vec4  cross( const Vec4<T>& vec ) const;
       Vec4  normal() const;
       Vec4& normalEq();
       Vec4& normalEq( const T length );
-      Vec4& negateEq();
-      Vec4& clampToMaxEq( const T& max );
+      constexpr Vec4& negateEq();
+      constexpr Vec4& clampToMaxEq( const T& max );
    
-      Vec4 operator+( const Vec4<T>& rhs ) const;
-      Vec4 operator-( const Vec4<T>& rhs ) const;
-      Vec4 operator-() const;
-      Vec4 operator*( const T& rhs ) const;
-      Vec4 operator*( const Vec4<T>& rhs ) const;
-      Vec4 operator/( const T& rhs ) const;
-      Vec4 operator/( const Vec4<T>& rhs ) const;
-
-      Vec4& operator+=( const Vec4<T>& rhs );
-      Vec4& operator-=( const Vec4<T>& rhs );
-      Vec4& operator*=( const T& rhs );
-      Vec4& operator*=( const Vec4<T>& rhs );
-      Vec4& operator/=( const T& rhs );
-      Vec4& operator/=( const Vec4<T>& rhs );
-      Vec4& operator=( const Vec4<T>& rsh );
-
-      bool operator==( const Vec4<T>& rhs ) const;
-      bool operator!=( const Vec4<T>& rhs ) const;
-
-      T& operator()( int idx );
-      const T& operator()( int idx ) const;
-
-      T& operator[]( int idx );
-      const T& operator[]( int idx ) const;
+      constexpr Vec4 operator+( const Vec4<T>& rhs ) const;
+      constexpr Vec4 operator-( const Vec4<T>& rhs ) const;
+      constexpr Vec4 operator-() const;
+      constexpr Vec4 operator*( const T& rhs ) const;
+      constexpr Vec4 operator*( const Vec4<T>& rhs ) const;
+      constexpr Vec4 operator/( const T& rhs ) const;
+      constexpr Vec4 operator/( const Vec4<T>& rhs ) const;
+
+      constexpr Vec4& operator+=( const Vec4<T>& rhs );
+      constexpr Vec4& operator-=( const Vec4<T>& rhs );
+      constexpr Vec4& operator*=( const T& rhs );
+      constexpr Vec4& operator*=( const Vec4<T>& rhs );
+      constexpr Vec4& operator/=( const T& rhs );
+      constexpr Vec4& operator/=( const Vec4<T>& rhs );
+
+      constexpr bool operator==( const Vec4<T>& rhs ) const;
+      constexpr bool operator!=( const Vec4<T>& rhs ) const;
+
+      constexpr T& operator()( int idx );
+      constexpr const T& operator()( int idx ) const;
+
+      constexpr T& operator[]( int idx );
+      constexpr const T& operator[]( int idx ) const;
 
     private:
 
       /*----- data members -----*/
 
-      T _e[4];
+      alignas(16) T _e[4];
     };
 
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T> Vec4<T>::zero() 
+    inline constexpr Vec4<T> Vec4<T>::zero() 
     {
       return Vec4( 0, 0, 0, 0 );
     }
@@ -97,28 +94,14 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T>::Vec4( const Vec4<T>& vec )
-    {
-      _e[0] = vec._e[0];
-      _e[1] = vec._e[1];
-      _e[2] = vec._e[2];
-      _e[3] = vec._e[3];
-    }
-
-  //------------------------------------------------------------------------------
-  //!
-  template< class T >
-    inline Vec4<T>::Vec4(
-                         const T& e0,
-                         const T& e1,
-                         const T& e2,
-                         const T& e3
-                         )
+    inline constexpr Vec4<T>::Vec4(
+                                   const T& e0,
+                                   const T& e1,
+                                   const T& e2,
+                                   const T& e3
+                                   ) noexcept
+    : _e{ e0, e1, e2, e3 }
     {
-      _e[0] = e0;
-      _e[1] = e1;
-      _e[2] = e2;
-      _e[3] = e3;
     }
 
   //------------------------------------------------------------------------------
@@ -134,7 +117,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T* Vec4<T>::ptr()
+    inline constexpr T* Vec4<T>::ptr()
     {
       return _e;
     }
@@ -142,7 +125,7 @@
   //------------------------------------------------------------------------------
   //!        
   template< class T >
-    inline void
+    inline constexpr void
     Vec4<T>::set( const T _v1, const T _v2, const T _v3, const T _v4)
     {
       _e[0] = _v1;
@@ -155,7 +138,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline const T* Vec4<T>::ptr() const
+    inline constexpr const T* Vec4<T>::ptr() const
     {
       return _e;
     }
@@ -176,7 +159,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T Vec4<T>::sqrLength() const
+    inline constexpr T Vec4<T>::sqrLength() const
     {
       return _e[0]*_e[0] + _e[1]*_e[1] + _e[2]*_e[2] + _e[3]*_e[3];
     }
@@ -184,7 +167,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T Vec4<T>::dot( const Vec4<T>& vec ) const
+    inline constexpr T Vec4<T>::dot( const Vec4<T>& vec ) const
     {
       return _e[0]*vec._e[0] + _e[1]*vec._e[1] + _e[2]*vec._e[2] + _e[3]*vec._e[3];
     }
@@ -192,7 +175,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T> Vec4<T>::cross( const Vec4<T>& vec ) const
+    inline constexpr Vec4<T> Vec4<T>::cross( const Vec4<T>& vec ) const
     {
       return Vec4<T>(
                      _e[1]*vec._e[2] - _e[2]*vec._e[1],
@@ -245,7 +228,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T>& Vec4<T>::negateEq()
+    inline constexpr Vec4<T>& Vec4<T>::negateEq()
     {
       _e[0] = -_e[0];
       _e[1] = -_e[1];
@@ -257,7 +240,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T>& Vec4<T>::clampToMaxEq( const T& max )
+    inline constexpr Vec4<T>& Vec4<T>::clampToMaxEq( const T& max )
     {
       if( _e[0] > max )
         {
@@ -281,7 +264,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T> Vec4<T>::operator+( const Vec4<T>& rhs ) const
+    inline constexpr Vec4<T> Vec4<T>::operator+( const Vec4<T>& rhs ) const
     {
       return Vec4<T>(
                      _e[0] + rhs._e[0],
@@ -294,7 +277,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T> Vec4<T>::operator-( const Vec4<T>& rhs ) const
+    inline constexpr Vec4<T> Vec4<T>::operator-( const Vec4<T>& rhs ) const
     {
       return Vec4<T>(
                      _e[0] - rhs._e[0],
@@ -307,7 +290,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T> Vec4<T>::operator-() const
+    inline constexpr Vec4<T> Vec4<T>::operator-() const
     {
       return Vec4<T>( -_e[0], -_e[1], -_e[2], -_e[3] );
     }
@@ -315,7 +298,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T> Vec4<T>::operator*( const T& rhs ) const
+    inline constexpr Vec4<T> Vec4<T>::operator*( const T& rhs ) const
     {
       return Vec4<T>(
                      _e[0] * rhs,
@@ -328,7 +311,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T> Vec4<T>::operator* ( const Vec4<T>& rhs ) const
+    inline constexpr Vec4<T> Vec4<T>::operator* ( const Vec4<T>& rhs ) const
     {
       return Vec4<T>(
                      _e[0] * rhs._e[0],
@@ -341,7 +324,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T> Vec4<T>::operator/( const T& rhs ) const
+    inline constexpr Vec4<T> Vec4<T>::operator/( const T& rhs ) const
     {
       return Vec4<T>(
                      _e[0] / rhs,
@@ -354,7 +337,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T> Vec4<T>::operator/( const Vec4<T>& rhs ) const
+    inline constexpr Vec4<T> Vec4<T>::operator/( const Vec4<T>& rhs ) const
     {
       return Vec4<T>(
                      _e[0] / rhs._e[0],
@@ -367,7 +350,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T>& Vec4<T>::operator+=( const Vec4<T>& rhs )
+    inline constexpr Vec4<T>& Vec4<T>::operator+=( const Vec4<T>& rhs )
     {
       _e[0] += rhs._e[0];
       _e[1] += rhs._e[1];
@@ -379,7 +362,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T>& Vec4<T>::operator-=( const Vec4<T>& rhs )
+    inline constexpr Vec4<T>& Vec4<T>::operator-=( const Vec4<T>& rhs )
     {
       _e[0] -= rhs._e[0];
       _e[1] -= rhs._e[1];
@@ -391,7 +374,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T>& Vec4<T>::operator*=( const T& rhs )
+    inline constexpr Vec4<T>& Vec4<T>::operator*=( const T& rhs )
     {
       _e[0] *= rhs;
       _e[1] *= rhs;
@@ -403,7 +386,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T>& Vec4<T>::operator*=( const Vec4<T>& rhs )
+    inline constexpr Vec4<T>& Vec4<T>::operator*=( const Vec4<T>& rhs )
     {
       _e[0] *= rhs._e[0];
       _e[1] *= rhs._e[1];
@@ -415,7 +398,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T>& Vec4<T>::operator/=( const T& rhs )
+    inline constexpr Vec4<T>& Vec4<T>::operator/=( const T& rhs )
     {
       _e[0] /= rhs;
       _e[1] /= rhs;
@@ -427,7 +410,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T>& Vec4<T>::operator/=( const Vec4<T>& rhs )
+    inline constexpr Vec4<T>& Vec4<T>::operator/=( const Vec4<T>& rhs )
     {
       _e[0] /= rhs._e[0];
       _e[1] /= rhs._e[1];
@@ -439,19 +422,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline Vec4<T>& Vec4<T>::operator=( const Vec4<T>& rhs )
-    {
-      _e[0] = rhs._e[0];
-      _e[1] = rhs._e[1];
-      _e[2] = rhs._e[2];
-      _e[3] = rhs._e[3];
-      return *this;
-    }
-
-  //------------------------------------------------------------------------------
-  //!
-  template< class T >
-    inline bool Vec4<T>::operator==( const Vec4<T>& rhs ) const
+    inline constexpr bool Vec4<T>::operator==( const Vec4<T>& rhs ) const
     {
       return
         _e[0] == rhs._e[0] &&
@@ -463,7 +434,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline bool Vec4<T>::operator!=( const Vec4<T>& rhs ) const
+    inline constexpr bool Vec4<T>::operator!=( const Vec4<T>& rhs ) const
     {
       return
         _e[0] != rhs._e[0] ||
@@ -475,7 +446,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T& Vec4<T>::operator()( int idx )
+    inline constexpr T& Vec4<T>::operator()( int idx )
     {
       return _e[idx];
     }
@@ -483,7 +454,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline const T& Vec4<T>::operator()( int idx ) const
+    inline constexpr const T& Vec4<T>::operator()( int idx ) const
     {
       return _e[idx];
     }
@@ -491,7 +462,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline T& Vec4<T>::operator[]( int idx )
+    inline constexpr T& Vec4<T>::operator[]( int idx )
     {
       return _e[idx];
     }
@@ -499,7 +470,7 @@
   //------------------------------------------------------------------------------
   //!
   template< class T >
-    inline const T& Vec4<T>::operator[]( int idx ) const
+    inline constexpr const T& Vec4<T>::operator[]( int idx ) const
     {
       return _e[idx];
     }
@@ -525,6 +496,8 @@
   typedef Vec4< int >    Vec4i;
   typedef Vec4< float >  Vec4f;
   typedef Vec4< double > Vec4d;
+
+  static_assert( std::is_trivially_copyable< Vec4f >::value, "Vec4f must stay trivially copyable" );
         
 
   
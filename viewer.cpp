@@ -3,29 +3,192 @@
 #include <math.h>
 #include <iostream>
 #include "meshLoader.h"
+#include "trace.h"
+#include "alloctracker.h"
+#include "bench/benchmark.h"
 #include <QTime>
+#include <QApplication>
+#include <chrono>
+#include <random>
+#include <stdlib.h>
+#include <string.h>
 
 using namespace std;
 
-Viewer::Viewer(char *filename,const QGLFormat &format)
+// mesh (bounding sphere center, radius) centered on its origin, radius r,
+// rotated of a around z. NULL center: at the origin
+static Mat4f place(const float *center,float radius,float r,float a) {
+  const float s = r/(radius>0.0f ? radius : 1.0f);
+
+  Mat4f m = Mat4f::rotationZ(a)*Mat4f::scale(s,s,s);
+  if(center)
+    m.translateBeforeEq(-Vec3f(center[0],center[1],center[2]));
+  return m;
+}
+
+Viewer::Viewer(const std::vector<char *> &filenames,const QGLFormat &format)
   : QGLWidget(format),
-    _drawMode(false)
+    _drawMode(false),
+    _originLocation(-1),
+    _loader(NULL),
+    _gridUploaded(0),
+    _loading(true),
+    _pool(NULL),
+    _pointBudget(5000000),
+    _arena(NULL),
+    _nbInstances(0),
+    _instanceBuffer(NULL),
+    _commandBuffer(NULL),
+    _indirect(false),
+    _culling(true),
+    _occlusion(NULL),
+    _occluding(true),
+    _tileQueries(NULL),
+    _objectQueries(NULL),
+    _queries(false),
+    _meshletCulling(true),
+    _lod(true),
+    _nbTriangles(0),
+    _benchWarmup(0),
+    _benchFrames(0)
     {
 
-  // load a mesh into the CPU memory
-  _grid = new Grid(1024,-1.0,1.0);
-  //_grid =new Mesh(filename);
+  // load the meshes in the background: the base mesh of the progressive
+  // ones now (a few ms), the grid and the other OFF files on a worker
+  // thread. The window shows up at once and draws each mesh once it is
+  // uploaded. The files too large for the memory are mapped in chunks
+  // (converted first), the ones without faces are point clouds
+  _grid   = NULL;
+  _loader = new BackgroundLoader();
+  _loader->loadGrid(1024,-1.0f,1.0f);
+  for(unsigned int i=0;i<filenames.size();++i) {
+    ProgressiveMesh *pm = NULL;
+    ChunkedMesh     *cm = NULL;
+    if(PointCloud::isPointCloud(filenames[i])) {
+      _loader->load(i,filenames[i]);
+    } else if(ChunkedMesh::outOfCore(filenames[i])) {
+      std::string cache = ProgressiveMesh::cacheFilename(filenames[i],".ooc");
+      cm = new ChunkedMesh();
+      if(cache.empty() || !cm->open(cache,filenames[i])) {
+	delete cm;
+	cm = NULL;
+
+	// no cache: converted to a temporary file (removed on exit), never
+	// loaded in memory
+	if(cache.empty()) {
+	  cache = ProgressiveMesh::temporaryFilename(".ooc");
+	  if(!cache.empty())
+	    _temporaries.push_back(cache);
+	}
+	if(!cache.empty())
+	  _loader->load(i,filenames[i],cache);
+	else
+	  printf("Unable to convert %s: no cache nor temporary file\n",filenames[i]);
+      }
+    } else {
+      const std::string cache = ProgressiveMesh::cacheFilename(filenames[i]);
+      pm = new ProgressiveMesh();
+      if(cache.empty() || !pm->open(cache,filenames[i])) {
+	delete pm;
+	pm = NULL;
+	_loader->load(i,filenames[i]);
+      }
+    }
+    _streams.push_back(pm);
+    _chunked.push_back(cm);
+    _clouds.push_back(NULL);
+  }
+  _loader->start();
+
+  // points drawn per frame by all the clouds
+  const char *budget = getenv("SIM_POINT_BUDGET");
+  if(budget && budget[0])
+    _pointBudget = (unsigned int)std::max(atof(budget)*1e6,1.0);
+
+  // one tile at the origin, or with SIM_FAR_SCENE=1 3x3 tiles far from
+  // the world origin (float world coordinates would only have a precision
+  // of ~2cm there)
+  const char *far = getenv("SIM_FAR_SCENE");
+  if(far && far[0] && strcmp(far,"0"))
+    layoutScene(3,Vec3d(250000.0,250000.0,0.0));
+  else
+    layoutScene(1,Vec3d(0.0,0.0,0.0));
+
+  // the meshes already known (the others once loaded)
+  for(unsigned int i=0;i<_streams.size();++i) {
+    if(_streams[i])
+      placeMesh(i,_streams[i]->center(),_streams[i]->radius());
+    if(_chunked[i])
+      placeMesh(i,_chunked[i]->center(),_chunked[i]->radius());
+  }
+
+  buildBvhs();
+
   // create a camera (automatically modify model/view matrices according to user interactions)
-  _cam  = new Camera(3,glm::vec3(0,0,0));
+  _cam  = new Camera(3,_center);
+  _previousEye = -_cam->relative(_center);
+  _eyeMotion   = Vec3f(0.0f,0.0f,0.0f);
 
 }
 
+void Viewer::layoutScene(unsigned int side,const Vec3d &center) {
+  // side x side tiles of 2x2 around center
+  const double size = 2.0*side;
+  _center = center;
+  for(unsigned int i=0;i<side;++i) {
+    for(unsigned int j=0;j<side;++j) {
+      _tiles.push_back(center+Vec3d(2.0*j+1.0-0.5*size,2.0*i+1.0-0.5*size,0.0));
+    }
+  }
+
+  // one object per file, on a regular grid above the tiles
+  const unsigned int n       = (unsigned int)ceil(sqrt((double)_streams.size()));
+  const double       spacing = size/n;
+  for(unsigned int i=0;i<_streams.size();++i) {
+    Instance o;
+    o.mesh   = i;
+    o.origin = center+Vec3d(spacing*(i%n+0.5)-0.5*size,spacing*(i/n+0.5)-0.5*size,-0.5*spacing);
+    o.radius = 0.4*spacing;
+    o.local  = place(NULL,1.0f,o.radius,0.0f);
+    _objects.push_back(o);
+  }
+
+  // copies of the first mesh scattered on the tiles, radius between 0.02
+  // and 0.1, the same ones every run (none drawn until + is pressed)
+  const unsigned int maxInstances = 65536;
+  std::mt19937                          generator(1);
+  std::uniform_real_distribution<float> random(0.0f,1.0f);
+  _instances.resize(maxInstances);
+  for(unsigned int i=0;i<maxInstances;++i) {
+    const double x = size*random(generator)-0.5*size;
+    const double y = size*random(generator)-0.5*size;
+    const float  a = 2.0f*M_PI*random(generator);
+    const float  r = 0.02f+0.08f*random(generator);
+
+    _instances[i].mesh   = 0;
+    _instances[i].origin = center+Vec3d(x,y,0.0);
+    _instances[i].radius = r;
+    _instances[i].local  = place(NULL,1.0f,r,a);
+  }
+}
+
 Viewer::~Viewer() {
   // delete everything 
   delete _grid;
   delete _cam;
+  for(unsigned int i=0;i<_streams.size();++i)
+    delete _streams[i];
+  delete _loader;
 
   deleteVAO();
+  deleteScene();
+  for(unsigned int i=0;i<_chunked.size();++i)
+    delete _chunked[i];
+  for(unsigned int i=0;i<_clouds.size();++i)
+    delete _clouds[i];
+  for(unsigned int i=0;i<_temporaries.size();++i)
+    remove(_temporaries[i].c_str());
+  deleteCameraBuffer();
   deleteShader();
 }
 
@@ -34,10 +197,68 @@ void Viewer::createShader() {
   _vertexFilename   = "shaders/helloworld.vert";
   _fragmentFilename = "shaders/helloworld.frag";
   _shader->load(_vertexFilename.c_str(),_fragmentFilename.c_str());
+
+  _instanceShader = new Shader();
+  _instanceVertexFilename = "shaders/instanced.vert";
+  _instanceShader->load(_instanceVertexFilename.c_str(),_fragmentFilename.c_str());
+
+  // reload automatically when a shader file (or an included one) is saved
+  watchShaderFiles();
+  connect(&_shaderWatcher,SIGNAL(fileChanged(const QString &)),this,SLOT(shaderFileChanged(const QString &)));
+  connect(&_shaderTimer,SIGNAL(timeout()),this,SLOT(pollShader()));
+}
+
+void Viewer::shaderFileChanged(const QString &path) {
+  // editors often replace the file: watch the new one
+  if(!_shaderWatcher.files().contains(path))
+    _shaderWatcher.addPath(path);
+
+  makeCurrent();
+  _shader->reloadAsync(_vertexFilename.c_str(),_fragmentFilename.c_str());
+  _instanceShader->reloadAsync(_instanceVertexFilename.c_str(),_fragmentFilename.c_str());
+  watchShaderFiles();
+  pollShader();
+  updateGL();
+}
+
+void Viewer::watchShaderFiles() {
+  // the #include list may have changed with the sources
+  const Shader *shaders[2] = {_shader,_instanceShader};
+  for(unsigned int s=0;s<2;++s) {
+    const std::vector<std::string> &files = shaders[s]->files();
+    for(unsigned int i=0;i<files.size();++i) {
+      if(!_shaderWatcher.files().contains(files[i].c_str()))
+        _shaderWatcher.addPath(files[i].c_str());
+    }
+  }
+}
+
+void Viewer::pollShader() {
+  makeCurrent();
+
+  // the reloaded shaders have no variant: the current one is compiled
+  // here, not in the next frame
+  const bool updated         = _shader->update();
+  const bool instanceUpdated = _instanceShader->update();
+  if(updated)
+    _shader->variant(_defines);
+  if(instanceUpdated)
+    _instanceShader->variant(_defines);
+  if(updated || instanceUpdated)
+    updateGL();
+
+  // keep polling while the driver compiles
+  if(_shader->pending() || _instanceShader->pending()) {
+    if(!_shaderTimer.isActive())
+      _shaderTimer.start(10);
+  } else {
+    _shaderTimer.stop();
+  }
 }
 
 void Viewer::deleteShader() {
   delete _shader;
+  delete _instanceShader;
 }
 
 void Viewer::createVAO() {
@@ -56,9 +277,11 @@ void Viewer::loadMeshIntoVAO() {
   // activate VAO
   glBindVertexArray(_vao);
   
-  // store mesh positions into buffer 0 inside the GPU memorycreate
+  // store mesh positions into buffer 0 inside the GPU memorycreate (only
+  // allocated once the loader built the grid: uploaded by slices in
+  // updateStreams, the tiles are drawn once it is complete)
   glBindBuffer(GL_ARRAY_BUFFER,_buffers[0]);
-  glBufferData(GL_ARRAY_BUFFER,_grid->nbVertices()*3*sizeof(float),_grid->vertices(),GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER,_grid->nbVertices()*3*sizeof(float),NULL,GL_STATIC_DRAW);
   //glBufferData(GL_ARRAY_BUFFER,_grid->nb_vertices*3*sizeof(float),_grid->vertices,GL_STATIC_DRAW);
   glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,0,(void *)0);
   glEnableVertexAttribArray(0);
@@ -71,39 +294,911 @@ void Viewer::loadMeshIntoVAO() {
 */
   // store mesh indices into buffer 2 inside the GPU memory
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,_buffers[1]);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,_grid->nbFaces()*3*sizeof(unsigned int),_grid->faces(),GL_STATIC_DRAW);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER,_grid->nbFaces()*3*sizeof(unsigned int),NULL,GL_STATIC_DRAW);
 //glBufferData(GL_ELEMENT_ARRAY_BUFFER,_grid->nb_faces*3*sizeof(unsigned int),_grid->faces,GL_STATIC_DRAW);
   // deactivate the VAO for now
   glBindVertexArray(0);
+  _gridUploaded = 0;
 }
 
 void Viewer::drawVAO() {
   // activate the VAO, draw the associated triangles and desactivate the VAO
   glBindVertexArray(_vao);
-  glDrawElements(GL_TRIANGLES,3*_grid->nbFaces(),GL_UNSIGNED_INT,(void *)0);
+  for(unsigned int i=0;i<_visibleTiles.size();++i) {
+    // tile origin relative to the eye: subtracted in double, then small
+    // enough for float near the camera
+    glUniform3fv(_originLocation,1,_cam->relative(_tiles[_visibleTiles[i]]).ptr());
+    if(_queries)
+      _tileQueries->begin(_visibleTiles[i]);
+    glDrawElements(GL_TRIANGLES,3*_grid->nbFaces(),GL_UNSIGNED_INT,(void *)0);
+    if(_queries)
+      _tileQueries->end();
+    _nbTriangles += _grid->nbFaces();
+  }
   //glDrawElements(GL_TRIANGLES,3*_grid->nb_faces,GL_UNSIGNED_INT,(void *)0);
   glBindVertexArray(0);
 }
 
-void Viewer::enableShader() {
+void Viewer::createScene() {
+  // the OFF files in the same buffers, sized for the progressive meshes
+  // (the others are not loaded yet: the buffers grow when they are)
+  GLuint nbVertices = 8,nbIndices = 36; // and the box
+  for(unsigned int i=0;i<_streams.size();++i) {
+    if(_streams[i]) {
+      nbVertices += _streams[i]->maxVertices();
+      nbIndices  += 2*_streams[i]->maxIndices(); // the next batch or the levels of detail go in new indices
+    }
+  }
+  _arena     = new MeshArena(nbVertices,nbIndices);
+  _occlusion = new Occlusion();
+
+  // nothing to draw until they are uploaded (one empty level, no meshlets),
+  // progressive meshes have room for the whole mesh
+  const MeshArena::Range none = {0,0,0,0};
+  _ranges.assign(_streams.size(),none);
+  _lods.resize(_streams.size());
+  _meshlets.resize(_streams.size());
+  _uploads.resize(_streams.size());
+  _loaded.resize(_streams.size());
+  for(unsigned int i=0;i<_streams.size();++i) {
+    if(_streams[i])
+      _ranges[i] = _arena->add(NULL,_streams[i]->maxVertices(),NULL,_streams[i]->maxIndices());
+    _lods[i].assign(0);
+    _meshlets[i].assign(1,Meshlets());
+    _uploads[i].kind = Upload::NONE;
+  }
+
+  // unit cube: bounding boxes of the occlusion queries
+  const float        corners[24] = {0,0,0, 1,0,0, 0,1,0, 1,1,0, 0,0,1, 1,0,1, 0,1,1, 1,1,1};
+  const unsigned int faces[36]   = {0,2,3, 0,3,1, 4,5,7, 4,7,6, 0,1,5, 0,5,4,
+				    2,6,7, 2,7,3, 0,4,6, 0,6,2, 1,3,7, 1,7,5};
+  _boxRange      = _arena->add(corners,8,faces,36);
+  _tileQueries   = new OcclusionQueries(_tiles.size());
+  _objectQueries = new OcclusionQueries(_objects.size());
+
+  // the culling of the meshlets does not allocate (finishMesh reserves
+  // room for the meshlets of each mesh)
+  _meshletFirst.resize(_objects.size());
+  _meshletCount.resize(_objects.size());
+  _chunkFirst.resize(_objects.size());
+  _chunkCount.resize(_objects.size());
+  _cloudFirst.resize(_objects.size());
+  _cloudCount.resize(_objects.size());
+  _objectLevels.resize(_objects.size(),0);
+  _sortedInstances.reserve(_instances.size());
+
+  // 3 frames of the initial instances before the first orphaning
+  _instanceBuffer = new StreamBuffer(GL_ARRAY_BUFFER,3*(_nbInstances+_objects.size())*sizeof(Mat4f));
+
+  // one command per object (GL 4.3 or GL_ARB_multi_draw_indirect)
+  _indirect = GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance;
+  if(_indirect)
+    _commandBuffer = new StreamBuffer(GL_DRAW_INDIRECT_BUFFER,3*_objects.size()*sizeof(MeshArena::DrawCommand));
+
+  // instance matrix: one column per attribute (2 to 5), advanced once per
+  // instance. The pointers are set when drawing (offset in the stream buffer)
+  glBindVertexArray(_arena->vao());
+  for(GLuint i=0;i<4;++i) {
+    glEnableVertexAttribArray(2+i);
+    glVertexAttribDivisor(2+i,1);
+  }
+  glBindVertexArray(0);
+
+  // out-of-core meshes already converted
+  for(unsigned int i=0;i<_chunked.size();++i) {
+    if(_chunked[i])
+      addChunkedMesh(i);
+  }
+
+  // the grid, the base meshes of the progressive ones, then the rest
+  connect(&_streamTimer,SIGNAL(timeout()),this,SLOT(pollStreams()));
+  updateStreams();
+}
+
+void Viewer::pollStreams() {
+  makeCurrent();
+  if(updateStreams())
+    updateGL();
+}
+
+bool Viewer::upload(Upload &u,GLsizeiptr &budget) {
+  // vertices first: the indices uploaded never point to missing ones
+  const GLuint nv = std::min((GLsizeiptr)(u.lastVertex-u.firstVertex),budget/(GLsizeiptr)(3*sizeof(float)));
+  budget -= nv*3*sizeof(float);
+  // and whole triangles
+  GLuint ni = u.firstVertex+nv<u.lastVertex ? 0 : std::min((GLsizeiptr)(u.lastIndex-u.firstIndex),budget/(GLsizeiptr)sizeof(GLuint));
+  if(u.firstIndex+ni<u.lastIndex)
+    ni -= ni%3;
+  budget -= ni*sizeof(GLuint);
+
+  _arena->update(u.range,u.firstVertex,u.vertices+3*u.firstVertex,nv,u.firstIndex,u.indices+u.firstIndex,ni);
+  u.firstVertex += nv;
+  u.firstIndex  += ni;
+  return u.firstVertex==u.lastVertex && u.firstIndex==u.lastIndex;
+}
+
+bool Viewer::updateStreams() {
+  // at most MAX_UPLOAD bytes per call: the frames go on while a large
+  // mesh is uploaded
+  GLsizeiptr budget     = MAX_UPLOAD;
+  bool       changed    = false;
+  const bool wasLoading = _loading;
+  _loading = false;
+
+  // the grid, once built by the loader: vertices then indices
+  if(!_grid && (_grid=_loader->grid())!=NULL)
+    loadMeshIntoVAO();
+  const GLsizeiptr gridVertices = _grid ? _grid->nbVertices()*3*sizeof(float) : 0;
+  const GLsizeiptr gridSize     = _grid ? gridVertices+_grid->nbFaces()*3*sizeof(unsigned int) : 0;
+  while(_gridUploaded<gridSize && budget>0) {
+    const bool       vertices = _gridUploaded<gridVertices;
+    const GLsizeiptr offset   = vertices ? _gridUploaded : _gridUploaded-gridVertices;
+    const GLsizeiptr size     = std::min(budget,(vertices ? gridVertices : gridSize-gridVertices)-offset);
+    glBindBuffer(GL_ARRAY_BUFFER,_buffers[vertices ? 0 : 1]);
+    glBufferSubData(GL_ARRAY_BUFFER,offset,size,(const char *)(vertices ? (const void *)_grid->vertices() : (const void *)_grid->faces())+offset);
+    glBindBuffer(GL_ARRAY_BUFFER,0);
+    _gridUploaded += size;
+    budget        -= size;
+    changed        = _gridUploaded==gridSize;
+  }
+  _loading = !_grid || _gridUploaded<gridSize;
+
+  // meshes loaded by the worker thread: placed, then uploaded below
+  for(std::shared_ptr<BackgroundLoader::Result> r=_loader->next();r;r=_loader->next()) {
+    // out of core: its chunks are uploaded when they are visible
+    if(r->chunked) {
+      _chunked[r->id] = r->chunked;
+      r->chunked      = NULL;
+      placeMesh(r->id,_chunked[r->id]->center(),_chunked[r->id]->radius());
+      addChunkedMesh(r->id);
+      changed = true;
+      continue;
+    }
+    // point cloud: its points only, in the order of its nodes
+    if(r->cloud) {
+      PointCloud *c = r->cloud;
+      Upload     &u = _uploads[r->id];
+      _clouds[r->id] = c;
+      r->cloud       = NULL;
+      placeMesh(r->id,c->center(),c->radius());
+      u.kind        = Upload::MESH;
+      u.range       = _arena->add(NULL,c->nbPoints(),NULL,0);
+      u.vertices    = c->points();
+      u.firstVertex = 0;
+      u.lastVertex  = c->nbPoints();
+      u.indices     = NULL;
+      u.firstIndex  = u.lastIndex = 0;
+      continue;
+    }
+    if(r->mesh==NULL)
+      continue;
+
+    const Mesh *m = r->mesh;
+    Upload     &u = _uploads[r->id];
+    placeMesh(r->id,m->center,m->radius);
+    u.kind        = Upload::MESH;
+    u.range       = _arena->add(NULL,m->nb_vertices,NULL,r->indices.size());
+    u.vertices    = m->vertices;
+    u.firstVertex = 0;
+    u.lastVertex  = m->nb_vertices;
+    u.indices     = r->indices.data();
+    u.firstIndex  = 0;
+    u.lastIndex   = r->indices.size();
+    _loaded[r->id] = r;
+  }
+  _loading = _loading || !_loader->done();
+
+  for(unsigned int i=0;i<_uploads.size();++i) {
+    Upload          &u  = _uploads[i];
+    ProgressiveMesh *pm = _streams[i];
+
+    // progressive mesh: the last batch (new vertices, all the indices), or
+    // the levels of the whole mesh. The indices go in new ones, the current
+    // ones are drawn until they are complete (no cracks between slices)
+    if(u.kind==Upload::NONE && pm) {
+      if(pm->ready()) {
+	u.kind        = Upload::BATCH;
+	u.range       = _arena->reserveIndices(_ranges[i],pm->nbIndices());
+	u.vertices    = pm->vertices();
+	u.firstVertex = pm->firstVertex();
+	u.lastVertex  = pm->nbVertices();
+	u.indices     = pm->indices();
+	u.firstIndex  = 0;
+	u.lastIndex   = pm->nbIndices();
+      } else if(pm->finished()) {
+	u.kind        = Upload::LEVELS;
+	u.range       = _arena->reserveIndices(_ranges[i],pm->levelIndices().size());
+	u.vertices    = pm->vertices();
+	u.firstVertex = u.lastVertex = 0;
+	u.indices     = pm->levelIndices().data();
+	u.firstIndex  = 0;
+	u.lastIndex   = pm->levelIndices().size();
+      } else {
+	_loading = true;
+	continue;
+      }
+    }
+
+    if(u.kind==Upload::NONE)
+      continue;
+    if(!upload(u,budget)) {
+      _loading = true;
+      continue;
+    }
+
+    // uploaded: drawn from now on
+    if(u.kind==Upload::BATCH) {
+      _arena->releaseIndices(_ranges[i]);
+      _ranges[i] = u.range;
+      _lods[i].assign(pm->nbIndices());
+      pm->next();
+      _loading = true;
+    } else if(u.kind==Upload::LEVELS) {
+      _arena->releaseIndices(_ranges[i]);
+      _ranges[i] = u.range;
+      finishMesh(i,pm->levels(),pm->meshlets(),pm->vertices(),pm->nbVertices(),pm->indices(),pm->nbIndices()/3);
+      delete pm;
+      _streams[i] = NULL;
+    } else if(_clouds[i]) {
+      _ranges[i] = u.range;
+      addPointCloud(i);
+    } else {
+      const BackgroundLoader::Result &r = *_loaded[i];
+      _ranges[i] = u.range;
+      finishMesh(i,r.levels,r.meshlets,r.mesh->vertices,r.mesh->nb_vertices,r.mesh->faces,r.mesh->nb_faces);
+      _loaded[i].reset();
+    }
+    u.kind  = Upload::NONE;
+    changed = true;
+  }
+
+  // the chunks of the out-of-core meshes requested by the last frame
+  if(_pool && _pool->update(budget))
+    changed = true;
+
+  // progress in the title bar, polling until everything is there
+  if(_title.isEmpty())
+    _title = windowTitle();
+  if(_loading)
+    setWindowTitle(_title+QString(" - loading %1%").arg((int)(100.0f*loadingProgress())));
+  else if(wasLoading)
+    setWindowTitle(_title);
+
+  if(_loading || (_pool && _pool->pending())) {
+    if(!_streamTimer.isActive())
+      _streamTimer.start(10);
+  } else {
+    _streamTimer.stop();
+  }
+
+  return changed;
+}
+
+float Viewer::loadingProgress() {
+  // OFF files by size, progressive meshes by vertices, one share each
+  float p = _loader->progress()*_loader->size();
+  for(unsigned int i=0;i<_streams.size();++i) {
+    if(_streams[i])
+      p += (float)_streams[i]->nbVertices()/std::max(1u,_streams[i]->maxVertices());
+    else if(!_loader->loads(i))
+      p += 1.0f;
+  }
+  return _streams.empty() ? 1.0f : p/_streams.size();
+}
+
+void Viewer::placeMesh(unsigned int mesh,const float *center,float radius) {
+  // the objects and copies were placed for a unit sphere at the origin
+  const Mat4f m = place(center,radius,1.0f,0.0f);
+  for(unsigned int i=0;i<_objects.size();++i) {
+    if(_objects[i].mesh==mesh)
+      _objects[i].local = _objects[i].local*m;
+  }
+  for(unsigned int i=0;i<_instances.size();++i) {
+    if(_instances[i].mesh==mesh)
+      _instances[i].local = _instances[i].local*m;
+  }
+}
+
+void Viewer::addChunkedMesh(unsigned int i) {
+  if(_pool==NULL) {
+    const char *env = getenv("SIM_OOC_POOL");
+    _pool = new ChunkPool(_arena,(GLsizeiptr)((env && env[0] ? atof(env) : 256.0)*1048576.0));
+
+    // each chunk in a slot is drawn once per frame at most
+    _chunkDraws.reserve(_pool->nbSlots());
+    if(_drawCounts.size()<_pool->nbSlots()) {
+      _drawCounts.resize(_pool->nbSlots());
+      _drawOffsets.resize(_pool->nbSlots());
+      _drawBaseVertices.resize(_pool->nbSlots());
+    }
+  }
+  _pool->add(i,_chunked[i]);
+}
+
+void Viewer::addPointCloud(unsigned int i) {
+  // the nodes are enough to draw it
+  _clouds[i]->releasePoints();
+
+  // each object selects each node once per frame at most
+  const unsigned int nbNodes = _clouds[i]->nbNodes();
+  unsigned int       n       = 0;
+  for(unsigned int j=0;j<_objects.size();++j)
+    n += _objects[j].mesh==i ? nbNodes : 0;
+  _cloudNodes.reserve(_cloudNodes.capacity()+n);
+  _cloudQueue.reserve(std::max(_cloudQueue.capacity(),(size_t)nbNodes));
+  if(_drawCounts.size()<nbNodes) {
+    _drawCounts.resize(nbNodes);
+    _drawOffsets.resize(nbNodes);
+    _drawBaseVertices.resize(nbNodes);
+  }
+  if(_drawFirsts.size()<nbNodes)
+    _drawFirsts.resize(nbNodes);
+}
+
+void Viewer::finishMesh(unsigned int i,const LodChain &levels,const std::vector<Meshlets> &meshlets,
+			const float *vertices,unsigned int nbVertices,const unsigned int *faces,unsigned int nbFaces) {
+  _lods[i]     = levels;
+  _meshlets[i] = meshlets;
+
+  // room for its meshlets in the culling (the frames do not allocate)
+  unsigned int nbLevelMeshlets = 0;
+  for(unsigned int l=0;l<_lods[i].size();++l)
+    nbLevelMeshlets = std::max(nbLevelMeshlets,_meshlets[i][l].size());
+  _visibleMeshlets.reserve(_visibleMeshlets.capacity()+nbLevelMeshlets);
+  if(_drawCounts.size()<nbLevelMeshlets) {
+    _drawCounts.resize(nbLevelMeshlets);
+    _drawOffsets.resize(nbLevelMeshlets);
+    _drawBaseVertices.resize(nbLevelMeshlets);
+  }
+
+  // the object is an occluder, relative to the center of the scene
+  // (between two frames: the occlusion thread is waiting)
+  if(i<_objects.size())
+    _occlusion->addOccluder(vertices,nbVertices,faces,nbFaces,centerMatrix(_objects[i]));
+}
+
+void Viewer::deleteScene() {
+  delete _pool;
+  delete _objectQueries;
+  delete _tileQueries;
+  delete _occlusion;
+  delete _commandBuffer;
+  delete _instanceBuffer;
+  delete _arena;
+}
+
+void Viewer::buildBvh(const std::vector<Instance> &instances,unsigned int n,std::vector<Box> &boxes,Bvh &bvh,std::vector<unsigned int> &visible) {
+  // bounding spheres, relative to the center of the scene
+  boxes.resize(n);
+  for(unsigned int i=0;i<n;++i)
+    boxes[i] = Box::sphere(Vec3f(instances[i].origin-_center),instances[i].radius);
+
+  bvh.build(boxes);
+  visible.clear();
+  visible.reserve(n);
+}
+
+void Viewer::buildBvhs() {
+  // terrain chunks: the grid covers [-1,1]x[-1,1] around their origin
+  _tileBoxes.resize(_tiles.size());
+  for(unsigned int i=0;i<_tiles.size();++i) {
+    const Vec3f o = Vec3f(_tiles[i]-_center);
+    _tileBoxes[i].min = o+Vec3f(-1.0f,-1.0f,0.0f);
+    _tileBoxes[i].max = o+Vec3f( 1.0f, 1.0f,0.0f);
+  }
+  _tileBvh.build(_tileBoxes);
+  _visibleTiles.reserve(_tiles.size());
+  _hiddenTiles.reserve(_tiles.size());
+
+  buildBvh(_objects,_objects.size(),_objectBoxes,_objectBvh,_visibleObjects);
+  buildBvh(_instances,_nbInstances,_instanceBoxes,_instanceBvh,_visibleInstances);
+  _hiddenObjects.reserve(_objects.size());
+}
+
+Mat4f Viewer::cullMatrix() const {
+  Mat4f m = _cam->projMatrix()*_cam->mdvMatrix();
+  m.translateBeforeEq(_cam->relative(_center));
+  return m;
+}
+
+void Viewer::cull() {
+  _visibleTiles.clear();
+  _visibleObjects.clear();
+  _visibleInstances.clear();
+
+  if(!_culling) {
+    for(unsigned int i=0;i<_tiles.size();++i)
+      _visibleTiles.push_back(i);
+    for(unsigned int i=0;i<_objects.size();++i)
+      _visibleObjects.push_back(i);
+    for(unsigned int i=0;i<_nbInstances;++i)
+      _visibleInstances.push_back(i);
+    return;
+  }
+
+  // frustum of the positions relative to the center of the scene
+  const Frustum f(cullMatrix());
+
+  _tileBvh.cull(f,_visibleTiles);
+  _objectBvh.cull(f,_visibleObjects);
+  _instanceBvh.cull(f,_visibleInstances);
+
+  // the grid is drawn once uploaded
+  if(!_grid || _gridUploaded<(GLsizeiptr)(_grid->nbVertices()*3*sizeof(float)+_grid->nbFaces()*3*sizeof(unsigned int)))
+    _visibleTiles.clear();
+}
+
+void Viewer::occlude(const std::vector<Box> &boxes,std::vector<unsigned int> &visible) {
+  // in place, visible keeps its order
+  unsigned int n = 0;
+  for(unsigned int i=0;i<visible.size();++i) {
+    if(_occlusion->visible(boxes[visible[i]]))
+      visible[n++] = visible[i];
+  }
+  visible.resize(n);
+}
+
+void Viewer::splitOccluded(OcclusionQueries *queries,const std::vector<Box> &boxes,
+			   std::vector<unsigned int> &visible,std::vector<unsigned int> &hidden) {
+  queries->newFrame();
+  hidden.clear();
+
+  // a box around the eye would be clipped by the near plane: never hidden
+  const Vec3f eye    = -_cam->relative(_center);
+  const float margin = 2.0f*_cam->zmin();
+
+  unsigned int n = 0;
+  for(unsigned int i=0;i<visible.size();++i) {
+    const Box &b = boxes[visible[i]];
+    bool around = true;
+    for(int k=0;k<3;++k)
+      around = around && b.min[k]-margin<=eye[k] && eye[k]<=b.max[k]+margin;
+
+    if(around || queries->wasVisible(visible[i]))
+      visible[n++] = visible[i];
+    else
+      hidden.push_back(visible[i]);
+  }
+  visible.resize(n);
+}
+
+Mat4f Viewer::centerMatrix(const Instance &instance) const {
+  const Vec3f o = Vec3f(instance.origin-_center);
+  Mat4f       m = instance.local;
+  m[12] += o[0];
+  m[13] += o[1];
+  m[14] += o[2];
+  return m;
+}
+
+Mat4f Viewer::eyeMatrix(const Instance &instance) const {
+  const Vec3f o = _cam->relative(instance.origin);
+  Mat4f       m = instance.local;
+  m[12] += o[0];
+  m[13] += o[1];
+  m[14] += o[2];
+  return m;
+}
+
+bool Viewer::streamMatrices(const std::vector<Instance> &instances,const std::vector<unsigned int> &visible,GLintptr &offset) {
+  // matrices relative to the eye: mesh -> world -> minus the eye position
+  Mat4f *m = (Mat4f *)_instanceBuffer->map(visible.size()*sizeof(Mat4f),offset);
+  if(m==NULL)
+    return false;
+
+  for(unsigned int i=0;i<visible.size();++i)
+    m[i] = eyeMatrix(instances[visible[i]]);
+  _instanceBuffer->unmap();
+  return true;
+}
+
+void Viewer::setInstanceMatrices(GLintptr offset) {
+  glBindBuffer(GL_ARRAY_BUFFER,_instanceBuffer->id());
+  for(GLuint i=0;i<4;++i)
+    glVertexAttribPointer(2+i,4,GL_FLOAT,GL_FALSE,sizeof(Mat4f),(void *)(offset+i*4*sizeof(float)));
+}
+
+void Viewer::drawScene() {
+  const unsigned int n = _visibleObjects.size();
+  if(n==0)
+    return;
+
+  GLintptr offset = 0;
+  if(!streamMatrices(_objects,_visibleObjects,offset))
+    return;
+
+  const GLuint id = _instanceShader->variant(_defines);
+  glUseProgram(id);
+  glUniform3f(_instanceShader->uniforms(id).location("myColor"),0.0f,0.0f,1.0f);
+
+  glBindVertexArray(_arena->vao());
+  setInstanceMatrices(offset);
+
+  if(_indirect && !_queries) {
+    // one call for the whole scene (a command per object or per visible
+    // meshlet): baseInstance selects the matrix
+    const unsigned int maxCommands = (_meshletCulling ? _visibleMeshlets.size()+n : n)+_chunkDraws.size();
+    GLintptr commands = 0;
+    MeshArena::DrawCommand *c = (MeshArena::DrawCommand *)_commandBuffer->map(maxCommands*sizeof(MeshArena::DrawCommand),commands);
+    if(c!=NULL) {
+      const MeshArena::DrawCommand *start = c;
+      for(unsigned int i=0;i<n;++i) {
+	const unsigned int      object   = _visibleObjects[i];
+	const unsigned int      mesh     = _objects[object].mesh;
+	const MeshArena::Range &r        = _ranges[mesh];
+	const LodChain::Level  &lod      = _lods[mesh][_objectLevels[object]];
+	const Meshlets         &meshlets = _meshlets[mesh][_objectLevels[object]];
+	// point clouds: drawn below
+	if(_clouds[mesh])
+	  continue;
+	if(_chunked[mesh]) {
+	  for(unsigned int j=0;j<_chunkCount[object];++j) {
+	    const ChunkPool::Draw &d = _chunkDraws[_chunkFirst[object]+j];
+	    const MeshArena::DrawCommand e = {d.nbIndices,1,d.firstIndex,d.baseVertex,i};
+	    *c++ = e;
+	    _nbTriangles += d.nbIndices/3;
+	  }
+	  continue;
+	}
+	if(!_meshletCulling || meshlets.size()==0) {
+	  const MeshArena::DrawCommand d = {lod.nbIndices,1,r.firstIndex+lod.firstIndex,r.baseVertex,i};
+	  *c++ = d;
+	  _nbTriangles += lod.nbIndices/3;
+	  continue;
+	}
+
+	for(unsigned int j=0;j<_meshletCount[object];++j) {
+	  const Meshlet &m = meshlets[_visibleMeshlets[_meshletFirst[object]+j]];
+	  const MeshArena::DrawCommand d = {m.nbIndices,1,r.firstIndex+lod.firstIndex+m.firstIndex,r.baseVertex,i};
+	  *c++ = d;
+	  _nbTriangles += m.nbIndices/3;
+	}
+      }
+      const unsigned int nbCommands = c-start;
+      _commandBuffer->unmap();
+
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER,_commandBuffer->id());
+      glMultiDrawElementsIndirect(GL_TRIANGLES,GL_UNSIGNED_INT,(void *)commands,nbCommands,0);
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER,0);
+    }
+
+    // points are not elements: one multi draw per cloud
+    for(unsigned int i=0;i<n;++i) {
+      if(!_clouds[_objects[_visibleObjects[i]].mesh])
+	continue;
+      setInstanceMatrices(offset+i*sizeof(Mat4f));
+      drawObject(_visibleObjects[i]);
+    }
+  } else {
+    // GL 3.3: no base instance, the matrix pointers move for each draw
+    for(unsigned int i=0;i<n;++i) {
+      if(i>0)
+	setInstanceMatrices(offset+i*sizeof(Mat4f));
+      if(_queries)
+	_objectQueries->begin(_visibleObjects[i]);
+      drawObject(_visibleObjects[i]);
+      if(_queries)
+	_objectQueries->end();
+    }
+  }
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+}
+
+void Viewer::cullMeshlets(const std::vector<unsigned int> &objects) {
+  // eye relative to the center of the scene
+  const Vec3f eye = -_cam->relative(_center);
+
+  for(unsigned int i=0;i<objects.size();++i) {
+    const Instance &o = _objects[objects[i]];
+    const Vec3f     p = Vec3f(o.origin-_center);
+
+    // mesh -> clip space, and the eye in mesh space
+    Mat4f m = cullMatrix();
+    m.translateBeforeEq(p);
+    m = m*o.local;
+
+    _meshletFirst[objects[i]] = _visibleMeshlets.size();
+    _meshlets[o.mesh][_objectLevels[objects[i]]].cull(Frustum(m),o.local.affineInverse()*(eye-p),true,_visibleMeshlets);
+    _meshletCount[objects[i]] = _visibleMeshlets.size()-_meshletFirst[objects[i]];
+  }
+}
+
+void Viewer::cullChunks(const std::vector<unsigned int> &objects) {
+  // eye relative to the center of the scene, and its motion over the next
+  // frames if it keeps going
+  const Vec3f eye    = -_cam->relative(_center);
+  const Vec3f motion = _eyeMotion*(float)PREFETCH_FRAMES;
+
+  for(unsigned int i=0;i<objects.size();++i) {
+    const Instance &o = _objects[objects[i]];
+    const Vec3f     p = Vec3f(o.origin-_center);
+    if(!_chunked[o.mesh])
+      continue;
+
+    // mesh -> clip space, now and for the moved eye (the scene moves the
+    // other way)
+    Mat4f m = cullMatrix();
+    Mat4f a = m;
+    m.translateBeforeEq(p);
+    a.translateBeforeEq(p-motion);
+
+    _chunkFirst[objects[i]] = _chunkDraws.size();
+    _pool->cull(o.mesh,Frustum(m*o.local),Frustum(a*o.local),o.local.affineInverse()*(eye-p),_chunkDraws);
+    _chunkCount[objects[i]] = _chunkDraws.size()-_chunkFirst[objects[i]];
+  }
+}
+
+unsigned int Viewer::cullClouds(const std::vector<unsigned int> &objects,unsigned int budget) {
+  // eye relative to the center of the scene, pixels of one unit at
+  // distance 1
+  const Vec3f eye    = -_cam->relative(_center);
+  const float pixels = 0.5f*height()*_cam->projMatrix()(1,1);
+
+  unsigned int nbClouds = 0;
+  for(unsigned int i=0;i<objects.size();++i)
+    nbClouds += _clouds[_objects[objects[i]].mesh] && _ranges[_objects[objects[i]].mesh].nbVertices>0 ? 1 : 0;
+
+  // the budget left is shared by the clouds left (the nearest ones do not
+  // get more: the order of the objects is the one of the bvh)
+  for(unsigned int i=0;i<objects.size();++i) {
+    const Instance   &o = _objects[objects[i]];
+    const Vec3f       p = Vec3f(o.origin-_center);
+    const PointCloud *c = _clouds[o.mesh];
+    _cloudFirst[objects[i]] = _cloudNodes.size();
+    _cloudCount[objects[i]] = 0;
+    if(!c || _ranges[o.mesh].nbVertices==0)
+      continue;
+
+    // mesh -> clip space, the eye in mesh space, and scale of the mesh
+    // (uniform)
+    Mat4f m = cullMatrix();
+    m.translateBeforeEq(p);
+    m = m*o.local;
+    const float scale = Vec3f(o.local[0],o.local[1],o.local[2]).length();
+
+    budget -= c->select(Frustum(m),o.local.affineInverse()*(eye-p),pixels,scale,_cam->zmin(),
+			budget/nbClouds--,_cloudQueue,_cloudNodes);
+    _cloudCount[objects[i]] = _cloudNodes.size()-_cloudFirst[objects[i]];
+  }
+  return budget;
+}
+
+unsigned int Viewer::level(const Instance &instance) const {
+  if(!_lod)
+    return 0;
+
+  // nearest point of the bounding sphere, pixels of one unit at distance
+  // 1, and scale of the mesh (uniform)
+  const float distance = std::max(_cam->relative(instance.origin).length()-instance.radius,_cam->zmin());
+  const float pixels   = 0.5f*height()*_cam->projMatrix()(1,1);
+  const float scale    = Vec3f(instance.local[0],instance.local[1],instance.local[2]).length();
+
+  return _lods[instance.mesh].select(distance,pixels,scale);
+}
+
+void Viewer::selectLevels(const std::vector<unsigned int> &objects) {
+  for(unsigned int i=0;i<objects.size();++i)
+    _objectLevels[objects[i]] = level(_objects[objects[i]]);
+}
+
+void Viewer::drawObject(unsigned int object) {
+  const Instance         &o        = _objects[object];
+  const MeshArena::Range &r        = _ranges[o.mesh];
+  const LodChain::Level  &lod      = _lods[o.mesh][_objectLevels[object]];
+  const Meshlets         &meshlets = _meshlets[o.mesh][_objectLevels[object]];
+
+  // point cloud: the points of its selected nodes
+  if(_clouds[o.mesh]) {
+    const PointCloud  &c = *_clouds[o.mesh];
+    const unsigned int n = _cloudCount[object];
+    for(unsigned int i=0;i<n;++i) {
+      const PointCloud::Node &node = c.node(_cloudNodes[_cloudFirst[object]+i]);
+      _drawFirsts[i] = r.baseVertex+node.first;
+      _drawCounts[i] = node.count;
+    }
+    if(n>0)
+      glMultiDrawArrays(GL_POINTS,&_drawFirsts[0],&_drawCounts[0],n);
+    return;
+  }
+
+  // out of core: its chunks on the GPU
+  if(_chunked[o.mesh]) {
+    const unsigned int n = _chunkCount[object];
+    for(unsigned int i=0;i<n;++i) {
+      const ChunkPool::Draw &d = _chunkDraws[_chunkFirst[object]+i];
+      _drawCounts[i]       = d.nbIndices;
+      _drawOffsets[i]      = (void *)(d.firstIndex*sizeof(GLuint));
+      _drawBaseVertices[i] = d.baseVertex;
+      _nbTriangles += d.nbIndices/3;
+    }
+    if(n>0)
+      glMultiDrawElementsBaseVertex(GL_TRIANGLES,&_drawCounts[0],GL_UNSIGNED_INT,&_drawOffsets[0],n,&_drawBaseVertices[0]);
+    return;
+  }
+
+  // progressive meshes have no meshlets until they are complete
+  if(!_meshletCulling || meshlets.size()==0) {
+    glDrawElementsBaseVertex(GL_TRIANGLES,lod.nbIndices,GL_UNSIGNED_INT,(void *)((r.firstIndex+lod.firstIndex)*sizeof(GLuint)),r.baseVertex);
+    _nbTriangles += lod.nbIndices/3;
+    return;
+  }
+
+  const unsigned int n = _meshletCount[object];
+  for(unsigned int i=0;i<n;++i) {
+    const Meshlet &m = meshlets[_visibleMeshlets[_meshletFirst[object]+i]];
+    _drawCounts[i]       = m.nbIndices;
+    _drawOffsets[i]      = (void *)((r.firstIndex+lod.firstIndex+m.firstIndex)*sizeof(GLuint));
+    _drawBaseVertices[i] = r.baseVertex;
+    _nbTriangles += m.nbIndices/3;
+  }
+
+  if(n>0)
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES,&_drawCounts[0],GL_UNSIGNED_INT,&_drawOffsets[0],n,&_drawBaseVertices[0]);
+}
+
+void Viewer::drawInstances() {
+  const unsigned int n = _visibleInstances.size();
+  if(n==0)
+    return;
+
+  // sorted by level of detail (counting sort)
+  const LodChain &lods = _lods[0];
+  unsigned int first[LodChain::MAX_LEVELS+1] = {0};
+  for(unsigned int i=0;i<n;++i)
+    first[level(_instances[_visibleInstances[i]])+1]++;
+  for(unsigned int l=0;l<lods.size();++l)
+    first[l+1] += first[l];
+
+  unsigned int next[LodChain::MAX_LEVELS];
+  std::copy(first,first+LodChain::MAX_LEVELS,next);
+  _sortedInstances.resize(n);
+  for(unsigned int i=0;i<n;++i)
+    _sortedInstances[next[level(_instances[_visibleInstances[i]])]++] = _visibleInstances[i];
+
+  GLintptr offset = 0;
+  if(!streamMatrices(_instances,_sortedInstances,offset))
+    return;
+
+  const GLuint id = _instanceShader->variant(_defines);
+  glUseProgram(id);
+  glUniform3f(_instanceShader->uniforms(id).location("myColor"),1.0f,0.0f,0.0f);
+
+  // one draw call per level, whatever the number of instances
+  const MeshArena::Range &r = _ranges[0];
+  glBindVertexArray(_arena->vao());
+  for(unsigned int l=0;l<lods.size();++l) {
+    const unsigned int count = first[l+1]-first[l];
+    if(count==0)
+      continue;
+
+    setInstanceMatrices(offset+first[l]*sizeof(Mat4f));
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES,lods[l].nbIndices,GL_UNSIGNED_INT,
+				      (void *)((r.firstIndex+lods[l].firstIndex)*sizeof(GLuint)),count,r.baseVertex);
+    _nbTriangles += count*(lods[l].nbIndices/3);
+  }
+  glBindVertexArray(0);
+
+  glUseProgram(0);
+}
+
+void Viewer::drawOccluded() {
+  const unsigned int nt = _hiddenTiles.size();
+  const unsigned int no = _hiddenObjects.size();
+  if(nt+no==0)
+    return;
+
+  // boxes of the tiles, boxes of the objects, then the objects
+  GLintptr offset = 0;
+  Mat4f *m = (Mat4f *)_instanceBuffer->map((nt+2*no)*sizeof(Mat4f),offset);
+  if(m==NULL)
+    return;
+
+  const Vec3f c = _cam->relative(_center);
+  for(unsigned int i=0;i<nt+no;++i) {
+    const Box &b = i<nt ? _tileBoxes[_hiddenTiles[i]] : _objectBoxes[_hiddenObjects[i-nt]];
+    m[i] = Mat4f::scale(b.max[0]-b.min[0],b.max[1]-b.min[1],b.max[2]-b.min[2]);
+    m[i][12] = c[0]+b.min[0];
+    m[i][13] = c[1]+b.min[1];
+    m[i][14] = c[2]+b.min[2];
+  }
+  for(unsigned int i=0;i<no;++i)
+    m[nt+no+i] = eyeMatrix(_objects[_hiddenObjects[i]]);
+  _instanceBuffer->unmap();
+
+  const GLuint id = _instanceShader->variant(_defines);
+  glUseProgram(id);
+  glBindVertexArray(_arena->vao());
+
+  // boxes tested against everything drawn so far, without writing anything
+  // (filled, even in wire mode: the faces may be visible, not the edges)
+  glColorMask(GL_FALSE,GL_FALSE,GL_FALSE,GL_FALSE);
+  glDepthMask(GL_FALSE);
+  glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
+  for(unsigned int i=0;i<nt+no;++i) {
+    OcclusionQueries *queries = i<nt ? _tileQueries : _objectQueries;
+    setInstanceMatrices(offset+i*sizeof(Mat4f));
+    queries->begin(i<nt ? _hiddenTiles[i] : _hiddenObjects[i-nt]);
+    glDrawElementsBaseVertex(GL_TRIANGLES,_boxRange.nbIndices,GL_UNSIGNED_INT,MeshArena::indexOffset(_boxRange),_boxRange.baseVertex);
+    queries->end();
+  }
+  glColorMask(GL_TRUE,GL_TRUE,GL_TRUE,GL_TRUE);
+  glDepthMask(GL_TRUE);
+  glPolygonMode(GL_FRONT_AND_BACK,_drawMode ? GL_LINE : GL_FILL);
+
+  // objects whose box passed (decided on the GPU)
+  glUniform3f(_instanceShader->uniforms(id).location("myColor"),0.0f,0.0f,1.0f);
+  for(unsigned int i=0;i<no;++i) {
+    setInstanceMatrices(offset+(nt+no+i)*sizeof(Mat4f));
+    _objectQueries->beginConditional(_hiddenObjects[i]);
+    drawObject(_hiddenObjects[i]);
+    _objectQueries->endConditional();
+  }
+  glBindVertexArray(0);
+  glUseProgram(0);
+
+  // then the tiles
+  if(nt>0) {
+    enableShader();
+    glBindVertexArray(_vao);
+    for(unsigned int i=0;i<nt;++i) {
+      glUniform3fv(_originLocation,1,_cam->relative(_tiles[_hiddenTiles[i]]).ptr());
+      _tileQueries->beginConditional(_hiddenTiles[i]);
+      glDrawElements(GL_TRIANGLES,3*_grid->nbFaces(),GL_UNSIGNED_INT,(void *)0);
+      _tileQueries->endConditional();
+    }
+    _nbTriangles += nt*_grid->nbFaces();
+    glBindVertexArray(0);
+    disableShader();
+  }
+}
+
+void Viewer::createCameraBuffer() {
+  static_assert(sizeof(CameraBlock)==3*16*sizeof(float),"CameraBlock must match the std140 layout");
+
+  glGenBuffers(1,&_cameraBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER,_cameraBuffer);
+  glBufferData(GL_UNIFORM_BUFFER,sizeof(CameraBlock),NULL,GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER,0);
+
+  // every program declaring the Camera block reads this buffer
+  glBindBufferBase(GL_UNIFORM_BUFFER,Shader::blockBinding("Camera"),_cameraBuffer);
+}
+
+void Viewer::deleteCameraBuffer() {
+  glDeleteBuffers(1,&_cameraBuffer);
+}
+
+void Viewer::updateCameraBuffer() {
   // get the current modelview and projection matrices 
-  glm::mat4 p  = _cam->projMatrix();
-  glm::mat4 mv  = _cam->mdvMatrix();
+  CameraBlock block;
+  block.proj = _cam->projMatrix();
+  block.mdv  = _cam->mdvMatrix();
 
   // compute the resulting transformation matrix
-  glm::mat4 mvp = p*mv;
+  block.mvp = block.proj*block.mdv;
 
-  // activate the shader 
-  glUseProgram(_shader->id());
+  // once per frame, whatever the number of programs and draws
+  glBindBuffer(GL_UNIFORM_BUFFER,_cameraBuffer);
+  glBufferSubData(GL_UNIFORM_BUFFER,0,sizeof(CameraBlock),&block);
+  glBindBuffer(GL_UNIFORM_BUFFER,0);
+}
 
-  // send the transformation matrix
-  glUniformMatrix4fv(glGetUniformLocation(_shader->id(),"mvp"),1,GL_FALSE,&(mvp[0][0]));
+void Viewer::enableShader() {
+  // activate the shader (variant specialized for the current defines)
+  const GLuint id = _shader->variant(_defines);
+  const UniformTable &uniforms = _shader->uniforms(id);
+  glUseProgram(id);
 
   // send another variable color
-  glUniform3f(glGetUniformLocation(_shader->id(),"myColor"),0.0f,1.0f,0.0f);
+  glUniform3f(uniforms.location("myColor"),0.0f,1.0f,0.0f);
 
   // send another variable color
-  glUniform3f(glGetUniformLocation(_shader->id(),"myOtherColor"),1.0f,0.0f,0.0f);
+  glUniform3f(uniforms.location("myOtherColor"),1.0f,0.0f,0.0f);
+
+  // set per tile in drawVAO
+  _originLocation = uniforms.location("origin");
 
 
 }
@@ -114,21 +1209,148 @@ void Viewer::disableShader() {
 }
 
 void Viewer::paintGL() {
-  // clear the color and depth buffers 
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  TRACE_SCOPE("Viewer::paintGL");
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  {
+    // steady-state frames must not touch the heap
+    ALLOC_FREE_SCOPE("Viewer::paintGL");
+
+    // clear the color and depth buffers 
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // set viewport
+    glViewport(0,0,width(),height());
+
+    // camera matrices for all the shaders
+    updateCameraBuffer();
+
+    // the occluders are rasterized while the main thread culls and draws the tiles
+    const bool occluding = _occluding && _culling && !_objects.empty();
+    if(occluding)
+      _occlusion->renderAsync(cullMatrix());
+
+    // what is in the frustum
+    cull();
+    _nbTriangles = 0;
 
-  // set viewport
-  glViewport(0,0,width(),height());
+    // tiles hidden in the previous frame: drawn last, if still needed
+    if(_queries)
+      splitOccluded(_tileQueries,_tileBoxes,_visibleTiles,_hiddenTiles);
 
-  // tell the GPU to use this specified shader and send custom variables (matrices and others)
-  enableShader();
+    // tell the GPU to use this specified shader and send custom variables (matrices and others)
+    enableShader();
   
-  // actually draw the scene 
-  drawVAO();
+    // actually draw the scene 
+    drawVAO();
+
+    // tell the GPU to stop using this shader 
+    disableShader();
+
+    // what is not hidden behind the objects
+    if(occluding) {
+      _occlusion->wait();
+      occlude(_objectBoxes,_visibleObjects);
+      occlude(_instanceBoxes,_visibleInstances);
+    }
+    if(_queries)
+      splitOccluded(_objectQueries,_objectBoxes,_visibleObjects,_hiddenObjects);
+
+    // then the parts of the objects that are in the frustum and facing the
+    // eye, in their level of detail
+    selectLevels(_visibleObjects);
+    if(_queries)
+      selectLevels(_hiddenObjects);
+    if(_meshletCulling) {
+      _visibleMeshlets.clear();
+      cullMeshlets(_visibleObjects);
+      if(_queries)
+	cullMeshlets(_hiddenObjects);
+    }
+
+    // the chunks of the out-of-core objects, the ones missing are
+    // uploaded between the frames
+    if(_pool) {
+      const Vec3f eye = -_cam->relative(_center);
+      _eyeMotion   = eye-_previousEye;
+      _previousEye = eye;
+
+      _pool->beginFrame();
+      _chunkDraws.clear();
+      cullChunks(_visibleObjects);
+      if(_queries)
+	cullChunks(_hiddenObjects);
+    }
+
+    // the nodes of the point clouds, coarse to fine: the hidden objects
+    // get the points the visible ones left
+    _cloudNodes.clear();
+    const unsigned int points = cullClouds(_visibleObjects,_pointBudget);
+    if(_queries)
+      cullClouds(_hiddenObjects,points);
+
+    // the OFF files and the copies of the first one
+    drawScene();
+    drawInstances();
+
+    // what was hidden, behind all the rest
+    if(_queries)
+      drawOccluded();
+  }
+
+  // the timer is not running once everything is loaded
+  if(_pool && _pool->pending() && !_streamTimer.isActive())
+    _streamTimer.start(10);
 
-  // tell the GPU to stop using this shader 
-  disableShader();
+  if(_benchFrames>0) {
+    // wait for the GPU so that the sample covers the whole frame
+    glFinish();
 
+    // the samples start once everything is loaded
+    if(!_loading) {
+      if(_benchWarmup>0) {
+	_benchWarmup--;
+      } else {
+	_benchSamples.push_back(std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-start).count());
+	if(--_benchFrames==0)
+	  finishBenchmark();
+      }
+    }
+  }
+}
+
+void Viewer::startBenchmark(unsigned int nbFrames,const char *filename) {
+  _benchWarmup   = 30;
+  _benchFrames   = nbFrames;
+  _benchFilename = filename;
+  _benchSamples.clear();
+  _benchSamples.reserve(nbFrames);
+
+  // frame_scene: the default view (the tiles and the OFF files, no
+  // copies), with the default culling and levels of detail, from the
+  // initial camera (the samples start once everything is loaded)
+
+  // redraw continuously
+  connect(&_benchTimer,SIGNAL(timeout()),this,SLOT(updateGL()));
+  _benchTimer.start(0);
+}
+
+void Viewer::finishBenchmark() {
+  _benchTimer.stop();
+
+  BenchmarkResult r;
+  r.name       = "frame_scene";
+  r.elements   = std::max(_nbTriangles,1u); // submitted by the last frame
+  r.iterations = 1;
+  r.samples    = _benchSamples;
+  computeStats(r);
+
+  cout << "Frame benchmark: median " << r.median/1e6 << " ms over " << r.samples.size() << " frames" << endl;
+
+  std::vector<BenchmarkResult> results(1,r);
+  writeBenchmarkJson(_benchFilename.c_str(),results);
+  QApplication::quit();
 }
 
 void Viewer::resizeGL(int width,int height) {
@@ -138,7 +1360,7 @@ void Viewer::resizeGL(int width,int height) {
 
 void Viewer::mousePressEvent(QMouseEvent *me) {
   // handle camera events
-  const glm::vec2 p((float)me->x(),(float)(height()-me->y()));
+  const Vec2f p((float)me->x(),(float)(height()-me->y()));
 
   if(me->button()==Qt::LeftButton) {
     _cam->initRotation(p);
@@ -153,7 +1375,7 @@ void Viewer::mousePressEvent(QMouseEvent *me) {
 
 void Viewer::mouseMoveEvent(QMouseEvent *me) {
   // handle camera motion
-  const glm::vec2 p((float)me->x(),(float)(height()-me->y()));
+  const Vec2f p((float)me->x(),(float)(height()-me->y()));
  
   _cam->move(p);
   updateGL();
@@ -177,15 +1399,92 @@ void Viewer::keyPressEvent(QKeyEvent *ke) {
     _cam->initialize(width(),height(),true);
   }
   
-  // key r: reload shaders 
+  // key r: reload shaders (in the background)
   if(ke->key()==Qt::Key_R) {
-    _shader->reload(_vertexFilename.c_str(),_fragmentFilename.c_str());
+    makeCurrent();
+    _shader->reloadAsync(_vertexFilename.c_str(),_fragmentFilename.c_str());
+    _instanceShader->reloadAsync(_instanceVertexFilename.c_str(),_fragmentFilename.c_str());
+    watchShaderFiles();
+    pollShader();
+  }
+
+  // key d: depth debug view (compiled here, not in the middle of a frame)
+  if(ke->key()==Qt::Key_D) {
+    if(_defines.empty())
+      _defines.push_back("DEBUG_DEPTH");
+    else
+      _defines.clear();
+
+    makeCurrent();
+    _shader->variant(_defines);
+    _instanceShader->variant(_defines);
+  }
+
+  // key +/-: twice more/less copies of the mesh
+  if(ke->key()==Qt::Key_Plus) {
+    _nbInstances = _nbInstances==0 ? 1 : 2*_nbInstances;
+    if(_nbInstances>_instances.size())
+      _nbInstances = _instances.size();
+    buildBvh(_instances,_nbInstances,_instanceBoxes,_instanceBvh,_visibleInstances);
+    cout << _nbInstances << " instances" << endl;
+  }
+  if(ke->key()==Qt::Key_Minus) {
+    _nbInstances /= 2;
+    buildBvh(_instances,_nbInstances,_instanceBoxes,_instanceBvh,_visibleInstances);
+    cout << _nbInstances << " instances" << endl;
+  }
+
+  // key c: frustum culling on/off
+  if(ke->key()==Qt::Key_C) {
+    _culling = !_culling;
+    cout << "frustum culling " << (_culling ? "on" : "off") << " (" << _nbTriangles << " triangles submitted by the last frame)" << endl;
+  }
+
+  // key o: occlusion culling on/off (with the frustum culling only)
+  if(ke->key()==Qt::Key_O) {
+    _occluding = !_occluding;
+    cout << "occlusion culling " << (_occluding ? "on" : "off") << " (" << _nbTriangles << " triangles submitted by the last frame)" << endl;
+  }
+
+  // key g: GPU occlusion queries on/off (tiles and objects)
+  if(ke->key()==Qt::Key_G) {
+    _queries = !_queries;
+    cout << "occlusion queries " << (_queries ? "on" : "off") << " (" << _nbTriangles << " triangles submitted by the last frame)" << endl;
+  }
+
+  // key m: culling of the meshlets on/off
+  if(ke->key()==Qt::Key_M) {
+    _meshletCulling = !_meshletCulling;
+    cout << "meshlet culling " << (_meshletCulling ? "on" : "off") << " (" << _nbTriangles << " triangles submitted by the last frame)" << endl;
+  }
+
+  // key l: levels of detail on/off
+  if(ke->key()==Qt::Key_L) {
+    _lod = !_lod;
+    cout << "levels of detail " << (_lod ? "on" : "off") << " (" << _nbTriangles << " triangles submitted by the last frame)" << endl;
+  }
+
+  // key a: print the allocations per phase (last frame, max, total)
+  if(ke->key()==Qt::Key_A) {
+    AllocTracker::print();
+  }
+
+  // key t: start/stop tracing (the trace is written when stopping)
+  if(ke->key()==Qt::Key_T) {
+    if(Trace::enabled()) {
+      Trace::disable();
+      Trace::dump(Trace::outputFilename());
+    } else {
+      Trace::enable();
+    }
   }
 
   updateGL();
 }
 
 void Viewer::initializeGL() {
+  TRACE_SCOPE("Viewer::initializeGL");
+
   // make this window the current one
   makeCurrent();
 
@@ -207,8 +1506,9 @@ void Viewer::initializeGL() {
   // create and initialize shaders and VAO 
   
   createShader();
+  createCameraBuffer();
   createVAO();
-  loadMeshIntoVAO();
+  createScene();
 
 }
 
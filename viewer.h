@@ -10,27 +10,45 @@
 // OpenGL Utility library
 #include <GL/glu.h>
 
-// OpenGL Mathematics
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-
 #include <QGLFormat>
 #include <QGLWidget>
 #include <QMouseEvent>
 #include <QKeyEvent>
 #include <QTimer>
+#include <QFileSystemWatcher>
 #include <stack>
+#include <vector>
+#include <string>
+#include <thread>
 
 #include "camera.h"
 #include "meshLoader.h"
 #include "grid.h"
 #include "shader.h"
+#include "streambuffer.h"
+#include "meshArena.h"
+#include "bvh.h"
+#include "occlusion.h"
+#include "occlusionQueries.h"
+#include "meshlets.h"
+#include "simplify.h"
+#include "progressiveMesh.h"
+#include "backgroundLoader.h"
+#include "chunkedMesh.h"
+#include "chunkPool.h"
+#include "pointCloud.h"
 
 class Viewer : public QGLWidget {
+  Q_OBJECT
+
  public:
-  Viewer(char *filename,const QGLFormat &format=QGLFormat::defaultFormat());
+  Viewer(const std::vector<char *> &filenames,const QGLFormat &format=QGLFormat::defaultFormat());
   ~Viewer();
 
+  // render nbFrames frames as fast as possible, write their timings
+  // (bench/benchmark.h JSON format) in filename and quit
+  void startBenchmark(unsigned int nbFrames,const char *filename);
+
  protected :
   virtual void paintGL();
   virtual void initializeGL();
@@ -38,6 +56,16 @@ class Viewer : public QGLWidget {
   virtual void keyPressEvent(QKeyEvent *ke);
   virtual void mousePressEvent(QMouseEvent *me);
   virtual void mouseMoveEvent(QMouseEvent *me);
+
+ private slots:
+  // shader hot-reload: files are watched, the new program is compiled in
+  // the background and swapped in only once it links
+  void shaderFileChanged(const QString &path);
+  void pollShader();
+
+  // progressive meshes: the batches of splits read in the background are
+  // uploaded as they come, the levels of detail once the mesh is complete
+  void pollStreams();
     
 
  private:
@@ -46,11 +74,112 @@ class Viewer : public QGLWidget {
   void loadMeshIntoVAO();
   void drawVAO();
 
+  // the OFF meshes share the buffers of the arena (one VAO): one
+  // multi-draw for the objects, one instanced draw for the copies
+  struct Instance;
+  void createScene();
+  void deleteScene();
+  void drawScene();
+  void drawInstances();
+
+  // visible meshlets of the objects (frustum and normal cones, in mesh
+  // space), drawn with one multi-draw per object
+  void cullMeshlets(const std::vector<unsigned int> &objects);
+  void drawObject(unsigned int object);
+
+  // part of a mesh still to upload: vertices [firstVertex,lastVertex) then
+  // indices [firstIndex,lastIndex), relative to range
+  struct Upload {
+    enum {NONE,BATCH,LEVELS,MESH} kind; // batch of a progressive mesh, its
+					// levels once complete, or a loaded OFF file
+    MeshArena::Range    range;
+    const float        *vertices;
+    const unsigned int *indices;
+    GLuint              firstVertex,lastVertex;
+    GLuint              firstIndex,lastIndex;
+  };
+
+  // uploads at most MAX_UPLOAD bytes of the grid and meshes ready, true if
+  // something new can be drawn. Polled by _streamTimer until all is there
+  bool updateStreams();
+  // uploads the next part of u within budget (bytes), true once complete
+  bool upload(Upload &u,GLsizeiptr &budget);
+  // loaded part of the OFF files and progressive meshes (0 to 1)
+  float loadingProgress();
+  // side x side tiles around center, one object per OFF file above them,
+  // the copies of the first one scattered on them
+  void layoutScene(unsigned int side,const Vec3d &center);
+  // the objects and copies of mesh were placed for a unit sphere: moves
+  // them to its bounding sphere
+  void placeMesh(unsigned int mesh,const float *center,float radius);
+  // mesh i is complete: levels, meshlets, occluder
+  void finishMesh(unsigned int i,const LodChain &levels,const std::vector<Meshlets> &meshlets,
+		  const float *vertices,unsigned int nbVertices,const unsigned int *faces,unsigned int nbFaces);
+  // _chunked[i] is mapped: its chunks go through the pool (created with
+  // the first one, SIM_OOC_POOL=<megabytes>, 256 by default)
+  void addChunkedMesh(unsigned int i);
+  // the chunks of the out-of-core objects that are on the GPU (and the
+  // missing ones are requested, with the ones ahead of the camera motion)
+  void cullChunks(const std::vector<unsigned int> &objects);
+  // _clouds[i] is uploaded: room for its nodes in the culling
+  void addPointCloud(unsigned int i);
+  // the nodes of the point clouds drawn by the objects: coarse to fine
+  // until budget points (shared by the clouds) or the pixel. Returns the
+  // points left
+  unsigned int cullClouds(const std::vector<unsigned int> &objects,unsigned int budget);
+
+  // level of detail whose error stays under a pixel on the screen
+  unsigned int level(const Instance &instance) const;
+  void selectLevels(const std::vector<unsigned int> &objects);
+
+  // mesh -> world, relative to _center (occluders) or to the eye
+  Mat4f centerMatrix(const Instance &instance) const;
+  Mat4f eyeMatrix(const Instance &instance) const;
+  // matrices of the visible instances written in the stream buffer, at offset
+  bool streamMatrices(const std::vector<Instance> &instances,const std::vector<unsigned int> &visible,GLintptr &offset);
+  // instance attributes (2 to 5) read from offset
+  void setInstanceMatrices(GLintptr offset);
+
+  // frustum culling of the tiles, objects and copies: the draws only
+  // submit the visible ones
+  void buildBvh(const std::vector<Instance> &instances,unsigned int n,std::vector<Box> &boxes,Bvh &bvh,std::vector<unsigned int> &visible);
+  void buildBvhs();
+  Mat4f cullMatrix() const; // projection of the positions relative to _center
+  void cull();
+
+  // occlusion culling: the objects are rasterized on the CPU (worker
+  // thread, during the frustum culling and the tiles), then the visible
+  // objects and copies hidden behind them are removed
+  void occlude(const std::vector<Box> &boxes,std::vector<unsigned int> &visible);
+
+  // GPU occlusion queries on the tiles and objects: the ones hidden in the
+  // previous frame move from visible to hidden, and are drawn after
+  // everything else, if their box passes its query (drawOccluded)
+  void splitOccluded(OcclusionQueries *queries,const std::vector<Box> &boxes,
+		     std::vector<unsigned int> &visible,std::vector<unsigned int> &hidden);
+  void drawOccluded();
+
   void createShader();
   void deleteShader();
+  void watchShaderFiles();
+
+  // std140 layout of the Camera uniform block (shaders/camera.glsl):
+  // Mat4f is stored column major, as a GLSL mat4. mvp and mdv are relative
+  // to the eye (Camera::mdvMatrix)
+  struct CameraBlock {
+    Mat4f mvp;
+    Mat4f mdv;
+    Mat4f proj;
+  };
+
+  void createCameraBuffer();
+  void deleteCameraBuffer();
+  void updateCameraBuffer();
   void enableShader();
   void disableShader();
 
+  void finishBenchmark();
+
 
   bool           _drawMode; // press w for wire or fill drawing mode
   //Mesh  *_grid;
@@ -58,11 +187,107 @@ class Viewer : public QGLWidget {
   Camera *_cam;    // the camera
   Shader *_shader; // the shader
 
+  // terrain tiles: the grid is uploaded once and drawn at each tile origin
+  // (world coordinates, in double), offset relative to the eye
+  std::vector<Vec3d> _tiles;
+  GLint              _originLocation; // "origin" uniform of the current program
+
+  // one copy of a mesh: world position (double) and local transformation
+  struct Instance {
+    unsigned int mesh;   // in _ranges
+    Vec3d        origin;
+    float        radius; // bounding sphere around origin
+    Mat4f        local;
+  };
+
+  enum {MAX_UPLOAD=4<<20}; // bytes per updateStreams
+  enum {PREFETCH_FRAMES=10}; // ahead of the camera motion
+  std::vector<ProgressiveMesh *> _streams;       // OFF files with a progressive cache, until complete
+  BackgroundLoader             *_loader;         // the other OFF files
+  std::vector<std::shared_ptr<BackgroundLoader::Result> > _loaded; // until uploaded
+  std::vector<Upload>           _uploads;        // one per OFF file
+  GLsizeiptr                    _gridUploaded;   // bytes of the grid vertices, then indices
+  bool                          _loading;        // something is not drawn yet
+  QString                       _title;          // of the window, without the progress
+  QTimer                        _streamTimer;
+  std::vector<ChunkedMesh *>    _chunked;        // OFF files rendered out of core (NULL if in memory)
+  std::vector<std::string>      _temporaries;    // their conversions when there is no cache
+  ChunkPool                    *_pool;           // their chunks on the GPU
+  std::vector<ChunkPool::Draw>  _chunkDraws;     // of the visible objects, this frame
+  std::vector<unsigned int>     _chunkFirst;     // per object, in _chunkDraws
+  std::vector<unsigned int>     _chunkCount;
+  Vec3f                         _previousEye;    // relative to _center
+  Vec3f                         _eyeMotion;      // in the last frame
+  std::vector<PointCloud *>     _clouds;         // OFF files without faces (NULL otherwise), once loaded
+  std::vector<unsigned int>     _cloudNodes;     // of the visible objects, this frame
+  std::vector<unsigned int>     _cloudFirst;     // per object, in _cloudNodes
+  std::vector<unsigned int>     _cloudCount;
+  PointCloud::Queue             _cloudQueue;
+  unsigned int                  _pointBudget;    // per frame (SIM_POINT_BUDGET=<millions>, 5 by default)
+  MeshArena                    *_arena;
+  std::vector<MeshArena::Range> _ranges;         // one per OFF file
+  std::vector<Instance>         _objects;        // one per OFF file
+  Shader                       *_instanceShader;
+  std::vector<Instance>         _instances;      // all the possible copies of the first mesh
+  MeshArena::Range              _boxRange;       // [0,1]^3 cube, for the occlusion queries
+  std::vector<LodChain>         _lods;           // one per OFF file, as _ranges
+  std::vector<std::vector<Meshlets> > _meshlets; // per OFF file and per level
+  unsigned int                  _nbInstances;    // drawn ones (press + or -)
+  StreamBuffer                 *_instanceBuffer; // matrices relative to the eye, rewritten every frame
+  StreamBuffer                 *_commandBuffer;  // indirect draws of the objects
+  bool                          _indirect;       // glMultiDrawElementsIndirect available
+
+  // bounding volume hierarchies, relative to _center, and what they let through
+  Vec3d                     _center;
+  Bvh                       _tileBvh;
+  Bvh                       _objectBvh;
+  Bvh                       _instanceBvh;
+  std::vector<unsigned int> _visibleTiles;
+  std::vector<unsigned int> _visibleObjects;
+  std::vector<unsigned int> _visibleInstances;
+  std::vector<Box>          _tileBoxes;
+  std::vector<Box>          _objectBoxes;
+  std::vector<Box>          _instanceBoxes;
+  bool                      _culling;     // press c
+  Occlusion                *_occlusion;   // occluders: the objects
+  bool                      _occluding;   // press o
+  OcclusionQueries         *_tileQueries;
+  OcclusionQueries         *_objectQueries;
+  std::vector<unsigned int> _hiddenTiles;   // in the previous frame
+  std::vector<unsigned int> _hiddenObjects;
+  bool                      _queries;       // press g
+  std::vector<unsigned int> _visibleMeshlets;  // of all the visible objects
+  std::vector<unsigned int> _meshletFirst;     // per object, in _visibleMeshlets
+  std::vector<unsigned int> _meshletCount;
+  std::vector<GLsizei>      _drawCounts;       // glMultiDrawElementsBaseVertex parameters
+  std::vector<void *>       _drawOffsets;
+  std::vector<GLint>        _drawBaseVertices;
+  std::vector<GLint>        _drawFirsts;       // glMultiDrawArrays (point clouds)
+  bool                      _meshletCulling;   // press m
+  std::vector<unsigned int> _objectLevels;     // of the visible objects
+  std::vector<unsigned int> _sortedInstances;  // visible instances, by level
+  bool                      _lod;              // press l
+  unsigned int              _nbTriangles; // submitted by the last frame
+
   std::string _vertexFilename;
   std::string _fragmentFilename;
+  std::string _instanceVertexFilename;
 
+  std::vector<std::string> _defines; // shader variant (press d for the depth view)
+
+  QFileSystemWatcher _shaderWatcher;
+  QTimer             _shaderTimer;
+
+  GLuint _cameraBuffer; // uniform buffer of the Camera block
   GLuint _vao;
   GLuint _buffers[3];
+
+  // frame benchmark 
+  QTimer              _benchTimer;
+  unsigned int        _benchWarmup;
+  unsigned int        _benchFrames;
+  std::vector<double> _benchSamples; // ns per frame
+  std::string         _benchFilename;
 };
 
 #endif // VIEWER_H